@@ -1,4 +1,5 @@
 #include "ActiveRegion.h"
+#include "ColorRuns.h"
 
 using namespace std;
 extern std::string filenamePrefix;
@@ -17,22 +18,8 @@ ColorMap* getAggregatedARMap(const ColorMap* map, Real cleaningFactor, Real aggr
 	
 	if(projection == "exact")
 	{
-		/*! Clean the color map to remove very small components (like protons)*/
-		aggregated->erodeCircularProjected(cleaningFactor, 0);
-	
-		#if defined DEBUG
-		aggregated->writeFits(filenamePrefix + "eroded.fits");
-		#endif
-	
-		/*! Aggregate the blobs together */
-		aggregated->dilateCircularProjected(cleaningFactor + aggregationFactor, 0);
-	
-		#if defined DEBUG
-		aggregated->writeFits(filenamePrefix + "dilated.fits");
-		#endif
-	
-		/*! Give back the original size */
-		aggregated->erodeCircularProjected(aggregationFactor, 0);
+		/*! Clean the color map to remove very small components (like protons), aggregate the blobs together and give back the original size */
+		aggregated->aggregateCircularProjected(cleaningFactor, aggregationFactor, 0);
 	
 		#if defined DEBUG
 		aggregated->writeFits(filenamePrefix + "closed.fits");
@@ -77,22 +64,8 @@ ColorMap* getAggregatedARMap(const ColorMap* map, Real cleaningFactor, Real aggr
 			exit(EXIT_FAILURE);
 		}
 	
-		/*! Clean the color map to remove very small components (like protons)*/
-		aggregated->erodeCircular(cleaningFactor, 0);
-	
-		#if defined DEBUG
-		aggregated->writeFits(filenamePrefix + "eroded.fits");
-		#endif
-	
-		/*! Aggregate the blobs together */
-		aggregated->dilateCircular(cleaningFactor + aggregationFactor, 0);
-	
-		#if defined DEBUG
-		aggregated->writeFits(filenamePrefix + "dilated.fits");
-		#endif
-	
-		/*! Give back the original size */
-		aggregated->erodeCircular(aggregationFactor, 0);
+		/*! Clean the color map to remove very small components (like protons), aggregate the blobs together and give back the original size */
+		aggregated->aggregateCircular(cleaningFactor, aggregationFactor, 0);
 	
 		#if defined DEBUG
 		aggregated->writeFits(filenamePrefix + "closed.fits");
@@ -161,7 +134,7 @@ void writeARMap(ColorMap*& map, const string& filename, const vector<EUVImage*>&
 	map->nullifyAboveRadius(1.);
 	
 	/*! We get the map of aggregated AR */
-	ColorMap* aggregatedMap = parameters["projection"].is_set() ? getAggregatedARMap(map, parameters["cleaning"], parameters["aggregation"], parameters["projection"]) : getAggregatedARMap(map, parameters["cleaning"], parameters["aggregation"], "none");
+	ColorMap* aggregatedMap = getAggregatedARMap(map, parameters["cleaning"], parameters["aggregation"], parameters["projection"]);
 	
 	if(parameters["aggregated"])
 	{
@@ -196,7 +169,10 @@ void writeARMap(ColorMap*& map, const string& filename, const vector<EUVImage*>&
 	
 	/*! We write the map of AR to the fits file */
 	FitsFile file(filename, FitsFile::overwrite);
-	map->writeFits(file, compressed ? FitsFile::compress : 0, "ActiveRegionMap");
+	int mode = compressed ? FitsFile::compress : 0;
+	if(parameters["runLength"])
+		mode = FitsFile::runlength;
+	map->writeFits(file, mode, "ActiveRegionMap");
 	
 	/*! We write some info about the map creation */
 	Header header = map->getHeader();
@@ -210,6 +186,13 @@ void writeARMap(ColorMap*& map, const string& filename, const vector<EUVImage*>&
 	file.writeTable("Regions");
 	writeRegions(file, regions);
 	
+	/*! We write the runs of pixels of the map with the regions, so that the regions can be tracked without reading the map */
+	if(parameters["footprints"] && !parameters["runLength"])
+	{
+		file.writeTable("Footprints");
+		ColorRuns(map).writeFits(file);
+	}
+	
 	/*! We get the chaincode and write them to the fits file */
 	if(parameters["chaincodeMaxPoints"].as<int>() > 0)
 	{
@@ -298,9 +281,11 @@ ParameterSection ARMapParameters()
 	parameters["cleaning"] = ArgParser::Parameter(6, "Cleaning factor in arcsec.");
 	parameters["aggregation"] = ArgParser::Parameter(32, "Aggregation factor in arcsec.");
 	parameters["minimalSize"] = ArgParser::Parameter(1500, "Minal size of regions in arcsec². Smaller regions will be discarded");
-	parameters["projection"] = ArgParser::Parameter("sinusoidal", "Projection used for the aggregation.");
+	parameters["projection"] = ArgParser::Parameter("none", "Projection used for the aggregation: none, equirectangular, lambert, sinusoidal, or exact for the slower morphology with discs projected on the sun.");
 	parameters["aggregated"] = ArgParser::Parameter(false, "Aggregate regions so that one region correspond to only one connected component");
 	parameters["useRawArea"] = ArgParser::Parameter(false, "When discarding small regions, use raw area instead of real area.");
+	parameters["runLength"] = ArgParser::Parameter(false, "Write the map as a table of runs of pixels instead of an image.");
+	parameters["footprints"] = ArgParser::Parameter(false, "Write the runs of pixels of the map in a Footprints table, so that the regions can be tracked without reading the map.");
 	return parameters;
 }
 
@@ -0,0 +1,85 @@
+#include "ButterflyGeometry.h"
+#include "ColorMap.h"
+
+using namespace std;
+
+const unsigned ButterflyGeometry::numberBins;
+
+ButterflyGeometry::ButterflyGeometry(ColorMap* map)
+:xAxes(map->Xaxes()), yAxes(map->Yaxes()), wcs(map->getWCS()), totalNumberOfPixels(numberBins, 0), correctedTotalNumberOfPixels(numberBins, 0)
+{
+	RealPixLoc sun_center = map->SunCenter();
+	Real sun_radius = map->SunRadius();
+	Real radius_squared = sun_radius * sun_radius;
+
+	// We try to avoid computing latitude for pixels that are out of the sun disc
+	unsigned miny = sun_center.y - sun_radius - 1 > 0 ? unsigned(sun_center.y - sun_radius - 1) : 0;
+	unsigned maxy = sun_center.y + sun_radius + 2 < yAxes ? unsigned(sun_center.y + sun_radius + 2) : yAxes;
+	unsigned minx = sun_center.x - sun_radius - 1 > 0 ? unsigned(sun_center.x - sun_radius - 1) : 0;
+	unsigned maxx = sun_center.x + sun_radius + 2 < xAxes ? unsigned(sun_center.x + sun_radius + 2) : xAxes;
+	for (unsigned y = miny; y < maxy ; ++y)
+	{
+		for (unsigned x = minx; x < maxx; ++x)
+		{
+			// We compute sigma, the square distance of the pixel to the sun edge
+			Real dx = fabs(x - sun_center.x);
+			Real dy = fabs(y - sun_center.y);
+			Real sigma = radius_squared - (dx * dx) - (dy * dy);
+			if(sigma <= 0)
+				continue;
+
+			HGS hgs = map->toHGS(RealPixLoc(x, y));
+			if (!hgs)
+				continue;
+
+			// We compute the correction factor to compensate for the projection
+			Real correction_factor = sun_radius/sqrt(sigma);
+			int latitude = int(floor(hgs.latitude * RADIAN2DEGREE)) + 91;
+			if(latitude < 0 || latitude >= int(numberBins))
+				continue;
+			pixels.push_back(y * xAxes + x);
+			bins.push_back(latitude);
+			// If the area correction factor is more than some value (i.e. the pixel is near the limb) we don't count it
+			corrections.push_back(correction_factor <= HIGGINS_FACTOR ? correction_factor : 0);
+			++totalNumberOfPixels[latitude];
+			correctedTotalNumberOfPixels[latitude] += corrections.back();
+		}
+	}
+}
+
+bool ButterflyGeometry::matches(ColorMap* map, const Real tolerance) const
+{
+	if(map->Xaxes() != xAxes || map->Yaxes() != yAxes)
+		return false;
+	const WCS& other = map->getWCS();
+	if(fabs(other.sun_center.x - wcs.sun_center.x) > tolerance || fabs(other.sun_center.y - wcs.sun_center.y) > tolerance || fabs(other.sun_radius - wcs.sun_radius) > tolerance)
+		return false;
+	// The differences of b0 and of the roll are converted to a displacement in pixels at the limb
+	if(fabs(other.b0 - wcs.b0) * wcs.sun_radius > tolerance)
+		return false;
+	for (unsigned i = 0; i < 2; ++i)
+	{
+		for (unsigned j = 0; j < 2; ++j)
+		{
+			if(fabs(other.cd[i][j] - wcs.cd[i][j]) * wcs.sun_radius > tolerance * fabs(wcs.cdelt1))
+				return false;
+		}
+	}
+	return true;
+}
+
+void ButterflyGeometry::accumulate(const ColorMap* map, vector<float>& regionNumberOfPixels, vector<float>& correctedRegionNumberOfPixels) const
+{
+	regionNumberOfPixels.assign(numberBins, 0);
+	correctedRegionNumberOfPixels.assign(numberBins, 0);
+	const ColorType null = map->null();
+	const ColorType* mapPixels = &(map->pixel(0));
+	for (unsigned p = 0; p < pixels.size(); ++p)
+	{
+		if(mapPixels[pixels[p]] != null)
+		{
+			++regionNumberOfPixels[bins[p]];
+			correctedRegionNumberOfPixels[bins[p]] += corrections[p];
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef ButterflyGeometry_H
+#define ButterflyGeometry_H
+
+#include <vector>
+
+#include "constants.h"
+#include "Coordinate.h"
+#include "WCS.h"
+
+class ColorMap;
+
+//! Class that caches the latitude and the area correction of the pixels of the sun disk, to compute butterfly diagrams
+/*!
+The latitude of a pixel and the correction factor of it's area for the projection depend only on the WCS of the map.
+They are computed once for the pixels of the disk, so that the statistics of many maps with the same WCS only need to look at their colors.
+
+The pixels are gathered by the closest inferior integral latitude, i.e. the latitude -0.5 goes into the -1 latitude, but the latitude 0.5 goes into the 0 latitude.
+The latitude l (in degrees) is stored in the bin l + 91.
+The pixels with a correction factor above HIGGINS_FACTOR (i.e. near the limb) are not counted in the corrected statistics.
+
+Example:
+@code
+ButterflyGeometry geometry(map);
+vector<float> regionNumberOfPixels, correctedRegionNumberOfPixels;
+geometry.accumulate(map, regionNumberOfPixels, correctedRegionNumberOfPixels);
+@endcode
+*/
+
+class ButterflyGeometry
+{
+	public :
+		//! Number of latitude bins
+		static const unsigned numberBins = 182;
+
+	private :
+		//! Size of the X axes of the map
+		unsigned xAxes;
+		//! Size of the Y axes of the map
+		unsigned yAxes;
+		//! The WCS of the map
+		WCS wcs;
+		//! Position of the pixels of the disk
+		std::vector<unsigned> pixels;
+		//! Latitude bin of the pixels of the disk
+		std::vector<unsigned char> bins;
+		//! Area correction factor of the pixels of the disk, 0 if above HIGGINS_FACTOR
+		std::vector<float> corrections;
+		//! Number of pixels of the disk for each latitude
+		std::vector<float> totalNumberOfPixels;
+		//! Corrected area of the disk for each latitude
+		std::vector<float> correctedTotalNumberOfPixels;
+
+	public :
+		//! Constructor, computes the geometry of the WCS of map
+		ButterflyGeometry(ColorMap* map);
+
+		//! Test if the geometry can be used for map
+		/*! The maps must have the same size, and their sun center, sun radius, b0 and roll must not differ by more than tolerance pixels */
+		bool matches(ColorMap* map, const Real tolerance = 0) const;
+
+		//! Number of pixels of the disk for each latitude
+		const std::vector<float>& TotalNumberOfPixels() const
+		{return totalNumberOfPixels;}
+
+		//! Corrected area of the disk for each latitude
+		const std::vector<float>& CorrectedTotalNumberOfPixels() const
+		{return correctedTotalNumberOfPixels;}
+
+		//! Routine to compute the number of pixels and corrected area of the regions of map for each latitude
+		/*! The map must match the geometry */
+		void accumulate(const ColorMap* map, std::vector<float>& regionNumberOfPixels, std::vector<float>& correctedRegionNumberOfPixels) const;
+};
+
+#endif
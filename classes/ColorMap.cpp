@@ -1,4 +1,11 @@
 #include "ColorMap.h"
+#include "ColorRuns.h"
+#include "ButterflyGeometry.h"
+#include "Contours.h"
+#include "DistanceTransform.h"
+#include "ShapeCache.h"
+#include "ConnectedComponents.h"
+#include "Region.h"
 #include <assert.h>
 #include <deque>
 #include <math.h>
@@ -181,6 +188,74 @@ void ColorMap::fillHeader()
 }
 
 
+unsigned ColorMap::storageBits(const ColorType maxColor)
+{
+	if(maxColor <= 255)
+		return 8;
+	else if(maxColor <= 65535)
+		return 16;
+	else
+		return 32;
+}
+
+unsigned ColorMap::storageBits() const
+{
+	ColorType max = 0;
+	for(unsigned j = 0; j < numberPixels; ++j)
+	{
+		if(pixels[j] > max)
+			max = pixels[j];
+	}
+	return storageBits(max);
+}
+
+FitsFile& ColorMap::writeFits(FitsFile& file, int mode, const string imagename)
+{
+	return writeFits(file, mode, imagename, 0);
+}
+
+FitsFile& ColorMap::writeFits(FitsFile& file, int mode, const string imagename, const ColorType maxColor)
+{
+	fillHeader();
+	if(!(mode & FitsFile::runlength) && !((mode & FitsFile::update) && file.isTable()))
+	{
+		// Class maps need only 8 bits and most region maps 16 bits, so we do not waste 32 bits per pixel
+		// When we update an image, it is promoted only if the colors do not fit anymore
+		const unsigned bits = maxColor > 0 ? storageBits(maxColor) : storageBits();
+		const int bitpix = bits == 8 ? BYTE_IMG : bits == 16 ? USHORT_IMG : LONG_IMG;
+		file.writeImage(pixels, xAxes, yAxes, mode, imagename, bitpix);
+		file.writeHeader(header);
+		return file;
+	}
+	
+	ColorRuns runs(this);
+	if(mode & FitsFile::update)
+	{
+		// The runs replace the columns of the current table
+		runs.writeFits(file, FitsFile::overwrite);
+	}
+	else
+	{
+		file.writeTable(imagename.empty() ? "ColorMap" : imagename);
+		runs.writeFits(file);
+	}
+	file.writeHeader(header);
+	return file;
+}
+
+FitsFile& ColorMap::readFits(FitsFile& file)
+{
+	if(!file.isTable())
+		return SunImage<ColorType>::readFits(file);
+	
+	file.readHeader(header);
+	ColorRuns runs;
+	runs.readFits(file);
+	runs.decode(this);
+	parseHeader();
+	return file;
+}
+
 bool isColorMap(const Header& header)
 {
 	return header.has("INSTRUME") && header.get<string>("INSTRUME").find("SPoCA") != string::npos;
@@ -193,32 +268,18 @@ void ColorMap::thresholdRegionsByRawArea(const double minSize)
 	const double pixelarea = PixelArea();
 	
 	//First we compute the area for each color
-	map<ColorType,double> areas;
-	for (ColorType* j = pixels; j < pixels + numberPixels; ++j)
+	RegionAccumulator accumulator(this);
+	vector<bool> erased(accumulator.numberSlots(), false);
+	for (unsigned s = 0; s < accumulator.numberSlots(); ++s)
 	{
-		if(*j != nullpixelvalue)
-		{
-			if (areas.count(*j) == 0)
-				areas[*j] = pixelarea;
-			else
-				areas[*j] += pixelarea;
-		}
-	}
-	#if defined VERBOSE
-	cout<<"Found following sizes for regions:"<<endl;
-	for(map<ColorType,double>::iterator a = areas.begin(); a != areas.end(); ++a)
-	{
-		cout<<"color: "<<a->first<<"\tsize:"<<a->second<<(a->second < minSize ? " To small" : " OK")<<endl;
+		const double area = accumulator.numberPixels(s) * pixelarea;
+		erased[s] = area < minSize;
+		#if defined VERBOSE
+		cout<<"color: "<<accumulator.color(s)<<"\tsize:"<<area<<(erased[s] ? " To small" : " OK")<<endl;
+		#endif
 	}
-	#endif
 	//Now we nullify those that are too small
-	for (ColorType* j = pixels; j < pixels + numberPixels; ++j)
-	{
-		if(*j != nullpixelvalue && areas[*j] < minSize)
-		{
-			*j = nullpixelvalue;
-		}
-	}
+	accumulator.erase(this, erased);
 
 }
 
@@ -228,39 +289,18 @@ void ColorMap::thresholdRegionsByRealArea(double minSize)
 	minSize *= RealPixelArea(wcs.sun_center);
 	
 	//We compute the area for each color
-	map<ColorType,Real> areas;
-	
-	for (PixLoc j(0,0); j.y < yAxes; ++j.y)
+	RegionAccumulator accumulator(this, RegionAccumulator::REAL_AREA);
+	vector<bool> erased(accumulator.numberSlots(), false);
+	for (unsigned s = 0; s < accumulator.numberSlots(); ++s)
 	{
-		for (j.x = 0; j.x < xAxes; ++j.x)
-		{
-			const ColorType& color = pixel(j);
-			if(color != nullpixelvalue)
-			{
-				if (areas.count(color) == 0)
-					areas[color] = RealPixelArea(j);
-				else
-					areas[color] += RealPixelArea(j);
-			}
-		}
-	}
-	
-	#if defined VERBOSE
-	cout<<"Found following sizes for regions:"<<endl;
-	for(map<ColorType,Real>::iterator a = areas.begin(); a != areas.end(); ++a)
-	{
-		cout<<"color: "<<a->first<<"\tsize:"<<a->second<<(a->second < minSize ? " To small" : " OK")<<endl;
+		erased[s] = accumulator.realArea(s) < minSize;
+		#if defined VERBOSE
+		cout<<"color: "<<accumulator.color(s)<<"\tsize:"<<accumulator.realArea(s)<<(erased[s] ? " To small" : " OK")<<endl;
+		#endif
 	}
-	#endif
 	
 	//Now we nullify those that are too small
-	for (ColorType* j = pixels; j < pixels + numberPixels; ++j)
-	{
-		if(*j != nullpixelvalue && areas[*j] < minSize)
-		{
-			*j = nullpixelvalue;
-		}
-	}
+	accumulator.erase(this, erased);
 
 }
 
@@ -369,98 +409,169 @@ ColorMap* ColorMap::erodeDiamond(unsigned size, ColorType pixelValueToErode)
 
 
 
-ColorMap* ColorMap::dilateCircular(const Real size, const ColorType unsetValue)
+// Set as seeds of the transform the pixels that are not unsetValue and have a 4 neighbour of a different color
+static void seedBoundaries(DistanceTransform& transform, const ColorType* pixels, const unsigned xAxes, const unsigned yAxes, const ColorType unsetValue)
 {
-	ColorType * newPixels = new ColorType[numberPixels];
-	memcpy(newPixels, pixels, numberPixels * sizeof(ColorType));
-	vector<int> shape;
-	shape.reserve(unsigned(size*size*3));
-	for(unsigned x = 1; x <= size; ++x)
-		shape.push_back(x);
-	for(int x = -int(size); x <= int(size); ++x)
-		for(unsigned y = 1; y <= size; ++y)
-			if(sqrt(x * x + y * y) <= size)
-				shape.push_back(y * xAxes + x);
-	
-	int offset = xAxes + 1;
-	ColorType * j = pixels + offset;
-	ColorType * nj = newPixels + offset;
-	for(unsigned y = 1; y < yAxes - 1; ++y)
-	{
-		for(unsigned x = 1; x < xAxes - 1; ++x)
+	for(unsigned y = 0, j = 0; y < yAxes; ++y)
+	{
+		for(unsigned x = 0; x < xAxes; ++x, ++j)
 		{
-			if(*j != unsetValue)
-			{
-				if(*(j-1) == unsetValue || *(j+1) == unsetValue || *(j-xAxes) == unsetValue || *(j+xAxes) == unsetValue)
-				{
-					for(unsigned s = 0; s < shape.size(); ++s)
-					{
-						if(offset + shape[s] < int(numberPixels))
-							*(nj + shape[s]) = *j;
-						if(shape[s] <= offset)
-							*(nj - shape[s]) = *j;
-					}
-				}
-			}
-			++j;
-			++nj;
-			++offset;
+			if(pixels[j] == unsetValue)
+				continue;
+			if((x > 0 && pixels[j-1] != pixels[j]) || (x + 1 < xAxes && pixels[j+1] != pixels[j]) || (y > 0 && pixels[j-xAxes] != pixels[j]) || (y + 1 < yAxes && pixels[j+xAxes] != pixels[j]))
+				transform.setSeed(j);
 		}
-		j+=2;
-		nj+=2;
-		offset+=2;
 	}
+}
+
+/*!
+Every unset pixel at a distance of at most size of a set pixel takes the color of the nearest set pixel.
+*/
+ColorMap* ColorMap::dilateCircular(const Real size, const ColorType unsetValue)
+{
+	DistanceTransform transform(xAxes, yAxes);
+	for(unsigned j = 0; j < numberPixels; ++j)
+	{
+		if(pixels[j] != unsetValue)
+			transform.setSeed(j);
+	}
+	transform.compute();
 	
-	delete[] pixels;
-	pixels = newPixels;
+	// The nearest seed of a pixel is always a set pixel, so the dilated pixels never serve as seed
+	for(unsigned j = 0; j < numberPixels; ++j)
+	{
+		if(pixels[j] == unsetValue && transform.within(j, size))
+			pixels[j] = pixels[transform.nearest(j)];
+	}
 	return this;
 }
 
 
-
+/*!
+Every pixel at a distance of at most size of the boundary of a connected component is unset.
+The boundary pixels are the set pixels that have a neighbour of a different color.
+*/
 ColorMap* ColorMap::erodeCircular(const Real size, const ColorType unsetValue)
 {
-	ColorType * newPixels = new ColorType[numberPixels];
-	memcpy(newPixels, pixels, numberPixels * sizeof(ColorType));
-	vector<int> shape;
-	shape.reserve(unsigned(size*size*3));
-	for(unsigned x = 1; x <= size; ++x)
-		shape.push_back(x);
-	for(int x = -int(size); x <= int(size); ++x)
-		for(unsigned y = 1; y <= size; ++y)
-			if(sqrt(x * x + y *y) <= size)
-				shape.push_back(y * xAxes + x);
-	
-	int offset = xAxes + 1;
-	ColorType * j = pixels + offset;
-	ColorType * nj = newPixels + offset;
-	for(unsigned y = 1; y < yAxes - 1; ++y)
-	{
-		for(unsigned x = 1; x < xAxes - 1; ++x)
+	DistanceTransform transform(xAxes, yAxes);
+	seedBoundaries(transform, pixels, xAxes, yAxes, unsetValue);
+	transform.compute();
+	
+	for(unsigned j = 0; j < numberPixels; ++j)
+	{
+		if(transform.within(j, size))
+			pixels[j] = unsetValue;
+	}
+	return this;
+}
+
+
+ColorMap* ColorMap::openingCircular(const Real size, const ColorType unsetValue)
+{
+	erodeCircular(size, unsetValue);
+	return dilateCircular(size, unsetValue);
+}
+
+
+ColorMap* ColorMap::closingCircular(const Real size, const ColorType unsetValue)
+{
+	dilateCircular(size, unsetValue);
+	return erodeCircular(size, unsetValue);
+}
+
+/*!
+It gives the same result as an erosion of size cleaningFactor, followed by a dilation of size cleaningFactor + aggregationFactor and an erosion of size aggregationFactor.
+The 3 operations are thresholds of distance transforms, computed on a buffer cropped to the bounding box of the set pixels enlarged by the size of the dilation.
+The pixels outside of that box are never set, so the result is the same as on the whole map.
+The buffer and the distance transform are allocated once for the 3 operations.
+*/
+ColorMap* ColorMap::aggregateCircular(const Real cleaningFactor, const Real aggregationFactor, const ColorType unsetValue)
+{
+	// We search the bounding box of the set pixels
+	unsigned xmin = xAxes, xmax = 0, ymin = yAxes, ymax = 0;
+	for(unsigned y = 0, j = 0; y < yAxes; ++y)
+	{
+		for(unsigned x = 0; x < xAxes; ++x, ++j)
 		{
-			if(*j != unsetValue && (*(j-1) != *j || *(j+1) != *j || *(j-xAxes) != *j || *(j+xAxes) != *j))
-			{
-				*nj = unsetValue;
-				for(unsigned s = 0; s < shape.size(); ++s)
-				{
-					if(offset + shape[s] < int(numberPixels))
-						*(nj + shape[s]) = unsetValue;
-					if(shape[s] <= offset)
-						*(nj - shape[s]) = unsetValue;
-				}
-				
-			}
-			++offset;
-			++j;
-			++nj;
+			if(pixels[j] == unsetValue)
+				continue;
+			if(x < xmin)
+				xmin = x;
+			if(x > xmax)
+				xmax = x;
+			if(y < ymin)
+				ymin = y;
+			ymax = y;
 		}
-		j+=2;
-		nj+=2;
-		offset+=2;
 	}
+	if(xmin > xmax)
+		return this;
+	
+	// The dilated pixels and their neighbours must be inside the buffer
+	const unsigned margin = unsigned(cleaningFactor + aggregationFactor) + 2;
+	xmin = xmin > margin ? xmin - margin : 0;
+	ymin = ymin > margin ? ymin - margin : 0;
+	xmax = xmax + margin < xAxes ? xmax + margin : xAxes - 1;
+	ymax = ymax + margin < yAxes ? ymax + margin : yAxes - 1;
+	const unsigned width = xmax - xmin + 1;
+	const unsigned height = ymax - ymin + 1;
+	const unsigned size = width * height;
 	
-	delete[] pixels;
-	pixels = newPixels;
+	vector<ColorType> buffer(size);
+	for(unsigned y = ymin; y <= ymax; ++y)
+		copy(pixels + y * xAxes + xmin, pixels + y * xAxes + xmax + 1, buffer.begin() + (y - ymin) * width);
+	ColorType* crop = &(buffer[0]);
+	
+	DistanceTransform transform(width, height);
+	
+	/*! Clean the map to remove very small components */
+	seedBoundaries(transform, crop, width, height, unsetValue);
+	transform.compute();
+	for(unsigned j = 0; j < size; ++j)
+	{
+		if(transform.within(j, cleaningFactor))
+			crop[j] = unsetValue;
+	}
+	
+	#if defined DEBUG
+	for(unsigned y = ymin; y <= ymax; ++y)
+		copy(buffer.begin() + (y - ymin) * width, buffer.begin() + (y - ymin + 1) * width, pixels + y * xAxes + xmin);
+	writeFits(filenamePrefix + "eroded.fits");
+	#endif
+	
+	/*! Aggregate the blobs together */
+	transform.clear();
+	for(unsigned j = 0; j < size; ++j)
+	{
+		if(crop[j] != unsetValue)
+			transform.setSeed(j);
+	}
+	transform.compute();
+	const Real dilation = cleaningFactor + aggregationFactor;
+	for(unsigned j = 0; j < size; ++j)
+	{
+		if(crop[j] == unsetValue && transform.within(j, dilation))
+			crop[j] = crop[transform.nearest(j)];
+	}
+	
+	#if defined DEBUG
+	for(unsigned y = ymin; y <= ymax; ++y)
+		copy(buffer.begin() + (y - ymin) * width, buffer.begin() + (y - ymin + 1) * width, pixels + y * xAxes + xmin);
+	writeFits(filenamePrefix + "dilated.fits");
+	#endif
+	
+	/*! Give back the original size */
+	transform.clear();
+	seedBoundaries(transform, crop, width, height, unsetValue);
+	transform.compute();
+	for(unsigned j = 0; j < size; ++j)
+	{
+		if(transform.within(j, aggregationFactor))
+			crop[j] = unsetValue;
+	}
+	
+	for(unsigned y = ymin; y <= ymax; ++y)
+		copy(buffer.begin() + (y - ymin) * width, buffer.begin() + (y - ymin + 1) * width, pixels + y * xAxes + xmin);
 	return this;
 }
 
@@ -507,17 +618,32 @@ vector<PixLoc> ColorMap::get_shape(PixLoc center, const vector<HCC>& line)
 	return shape;
 }
 
-ColorMap* ColorMap::dilateCircularProjected(const Real size, const ColorType unsetValue)
+// Stamp the shape centered on the pixel (x, y) with the color, the shape is clipped to the image
+static inline void stamp(ColorType* pixels, const unsigned xAxes, const unsigned yAxes, const unsigned x, const unsigned y, const ShapeCache::Shape& shape, const ColorType color)
+{
+	for(ShapeCache::Shape::const_iterator s = shape.begin(); s != shape.end(); ++s)
+	{
+		int row = int(y) + s->dy;
+		if(row < 0 || row >= int(yAxes))
+			continue;
+		int xmin = int(x) + s->xmin;
+		int xmax = int(x) + s->xmax;
+		if(xmin < 0)
+			xmin = 0;
+		if(xmax >= int(xAxes))
+			xmax = xAxes - 1;
+		ColorType* j = pixels + row * xAxes;
+		for(int xs = xmin; xs <= xmax; ++xs)
+			j[xs] = color;
+	}
+}
+
+ColorMap* ColorMap::dilateCircularProjected(const Real size, const ColorType unsetValue, ShapeCache* cache)
 {
+	ShapeCache* shapes = cache ? cache : new ShapeCache(this);
 	ColorType* original = new ColorType[numberPixels];
 	memcpy(original, pixels, numberPixels * sizeof(ColorType));
-	vector<HCC> line = get_half_circle(size);
 	
-	// We need to temporarly disable b0
-	Real cos_b0 = wcs.cos_b0;
-	Real sin_b0 = wcs.sin_b0;
-	wcs.cos_b0 = 1;
-	wcs.sin_b0 = 0;
 	RealPixLoc sun_center = SunCenter();
 	Real sun_radius = SunRadius();
 	
@@ -535,32 +661,23 @@ ColorMap* ColorMap::dilateCircularProjected(const Real size, const ColorType uns
 			{
 				if(*(j-1) == unsetValue || *(j+1) == unsetValue || *(j-xAxes) == unsetValue || *(j+xAxes) == unsetValue)
 				{
-					vector<PixLoc> shape = get_shape(PixLoc(x, y), line);
-					for (vector<PixLoc>::iterator s = shape.begin() ; s != shape.end(); ++s)
-					{
-						pixel(*s) = *j;
-					}
+					stamp(pixels, xAxes, yAxes, x, y, shapes->shape(PixLoc(x, y), size), *j);
 				}
 			}
 		}
 	}
-	wcs.cos_b0 = cos_b0;
-	wcs.sin_b0 = sin_b0;
 	delete[] original;
+	if(shapes != cache)
+		delete shapes;
 	return this;
 }
 
-ColorMap* ColorMap::erodeCircularProjected(const Real size, const ColorType unsetValue)
+ColorMap* ColorMap::erodeCircularProjected(const Real size, const ColorType unsetValue, ShapeCache* cache)
 {
+	ShapeCache* shapes = cache ? cache : new ShapeCache(this);
 	ColorType* original = new ColorType[numberPixels];
 	memcpy(original, pixels, numberPixels * sizeof(ColorType));
-	vector<HCC> line = get_half_circle(size);
 	
-	// We need to temporarly disable b0
-	Real cos_b0 = wcs.cos_b0;
-	Real sin_b0 = wcs.sin_b0;
-	wcs.cos_b0 = 1;
-	wcs.sin_b0 = 0;
 	RealPixLoc sun_center = SunCenter();
 	Real sun_radius = SunRadius();
 	
@@ -576,124 +693,204 @@ ColorMap* ColorMap::erodeCircularProjected(const Real size, const ColorType unse
 		{
 			if(*j == unsetValue && (*(j-1) != unsetValue || *(j+1) != unsetValue || *(j-xAxes) != unsetValue || *(j+xAxes) != unsetValue))
 			{
-				vector<PixLoc> shape = get_shape(PixLoc(x, y), line);
-				for (vector<PixLoc>::iterator s = shape.begin() ; s != shape.end(); ++s)
-				{
-					pixel(*s) = unsetValue;
-				}
+				stamp(pixels, xAxes, yAxes, x, y, shapes->shape(PixLoc(x, y), size), unsetValue);
 			}
 		}
 	}
-	wcs.cos_b0 = cos_b0;
-	wcs.sin_b0 = sin_b0;
 	delete[] original;
+	if(shapes != cache)
+		delete shapes;
 	return this;
 }
 
 
-ColorMap* ColorMap::drawInternContours(const unsigned width, const ColorType unsetValue)
+// Routine to stamp the shapes of size on the boundary pixels inside the box, the box is enlarged to the stamped pixels
+// If dilate, the boundary pixels are the set pixels with an unset neighbour, and they stamp their color
+// Otherwise, they are the unset pixels with a set neighbour, and they stamp unsetValue
+static void stampBoundaries(ColorType* pixels, vector<ColorType>& original, const unsigned xAxes, const unsigned yAxes, const RealPixLoc& sun_center, const Real sun_radius, unsigned& xmin, unsigned& xmax, unsigned& ymin, unsigned& ymax, const Real size, const ColorType unsetValue, ShapeCache* shapes, const bool dilate)
 {
+	// The boundary pixels are at most one pixel outside the box, and their neighbours are read
+	const unsigned scan_ymin = ymin > 0 ? ymin - 1 : 0;
+	const unsigned scan_ymax = ymax + 1 < yAxes ? ymax + 1 : yAxes - 1;
+	const unsigned scan_xmin = xmin > 0 ? xmin - 1 : 0;
+	const unsigned scan_xmax = xmax + 1 < xAxes ? xmax + 1 : xAxes - 1;
+	const unsigned copy_ymin = scan_ymin > 0 ? scan_ymin - 1 : 0;
+	const unsigned copy_ymax = scan_ymax + 1 < yAxes ? scan_ymax + 1 : yAxes - 1;
+	memcpy(&(original[copy_ymin * xAxes]), pixels + copy_ymin * xAxes, (copy_ymax - copy_ymin + 1) * xAxes * sizeof(ColorType));
+	
+	unsigned min_y = ceil(sun_center.y - sun_radius);
+	unsigned max_y = floor(sun_center.y + sun_radius);
+	min_y = min_y > scan_ymin ? min_y : scan_ymin;
+	max_y = max_y < scan_ymax ? max_y : scan_ymax;
+	for(unsigned y = min_y; y <= max_y; ++y)
+	{
+		Real delta_x = sqrt(sun_radius * sun_radius - (y - sun_center.y) * (y - sun_center.y));
+		unsigned min_x = ceil(sun_center.x - delta_x);
+		unsigned max_x = floor(sun_center.x + delta_x);
+		min_x = min_x > scan_xmin ? min_x : scan_xmin;
+		max_x = max_x < scan_xmax ? max_x : scan_xmax;
+		const ColorType* j = &(original[y * xAxes + min_x]);
+		for(unsigned x = min_x; x <= max_x; ++x, ++j)
+		{
+			if(dilate)
+			{
+				if(*j == unsetValue || (*(j-1) != unsetValue && *(j+1) != unsetValue && *(j-xAxes) != unsetValue && *(j+xAxes) != unsetValue))
+					continue;
+				const ShapeCache::Shape& shape = shapes->shape(PixLoc(x, y), size);
+				stamp(pixels, xAxes, yAxes, x, y, shape, *j);
+				for(ShapeCache::Shape::const_iterator s = shape.begin(); s != shape.end(); ++s)
+				{
+					int row = int(y) + s->dy;
+					if(row < 0 || row >= int(yAxes))
+						continue;
+					ymin = unsigned(row) < ymin ? row : ymin;
+					ymax = unsigned(row) > ymax ? row : ymax;
+					int left = int(x) + s->xmin;
+					int right = int(x) + s->xmax;
+					xmin = left < 0 ? 0 : (unsigned(left) < xmin ? left : xmin);
+					xmax = right >= int(xAxes) ? xAxes - 1 : (unsigned(right) > xmax ? right : xmax);
+				}
+			}
+			else if(*j == unsetValue && (*(j-1) != unsetValue || *(j+1) != unsetValue || *(j-xAxes) != unsetValue || *(j+xAxes) != unsetValue))
+			{
+				stamp(pixels, xAxes, yAxes, x, y, shapes->shape(PixLoc(x, y), size), unsetValue);
+			}
+		}
+	}
+}
 
-	ColorMap* eroded = new ColorMap(this);
-	eroded->erodeCircular(width, unsetValue);
-	for (unsigned j = 0; j < numberPixels; ++j)
+/*!
+It gives the same result as the 3 separate operations, but the copy of the pixels is allocated once, and the shapes are shared.
+Only the pixels inside the bounding box of the set pixels are scanned, the box is enlarged as the dilation stamps the shapes.
+The pixels outside of the box are unset, and so have no set neighbour, so they cannot be boundary pixels.
+The shapes of the discs depend on the position on the disk, so the operations are still done by stamping the shapes, and not with a distance transform.
+*/
+ColorMap* ColorMap::aggregateCircularProjected(const Real cleaningFactor, const Real aggregationFactor, const ColorType unsetValue, ShapeCache* cache)
+{
+	// We search the bounding box of the set pixels
+	unsigned xmin = xAxes, xmax = 0, ymin = yAxes, ymax = 0;
+	for(unsigned y = 0, j = 0; y < yAxes; ++y)
 	{
-		if(eroded->pixels[j] != eroded->nullpixelvalue)
-			pixels[j] = unsetValue;
+		for(unsigned x = 0; x < xAxes; ++x, ++j)
+		{
+			if(pixels[j] == unsetValue)
+				continue;
+			if(x < xmin)
+				xmin = x;
+			if(x > xmax)
+				xmax = x;
+			if(y < ymin)
+				ymin = y;
+			ymax = y;
+		}
 	}
-	delete eroded;
+	if(xmin > xmax)
+		return this;
+	
+	ShapeCache* shapes = cache ? cache : new ShapeCache(this);
+	vector<ColorType> original(numberPixels);
+	const RealPixLoc sun_center = SunCenter();
+	const Real sun_radius = SunRadius();
+	
+	/*! Clean the map to remove very small components */
+	stampBoundaries(pixels, original, xAxes, yAxes, sun_center, sun_radius, xmin, xmax, ymin, ymax, cleaningFactor, unsetValue, shapes, false);
+	
+	#if defined DEBUG
+	writeFits(filenamePrefix + "eroded.fits");
+	#endif
+	
+	/*! Aggregate the blobs together */
+	stampBoundaries(pixels, original, xAxes, yAxes, sun_center, sun_radius, xmin, xmax, ymin, ymax, cleaningFactor + aggregationFactor, unsetValue, shapes, true);
+	
+	#if defined DEBUG
+	writeFits(filenamePrefix + "dilated.fits");
+	#endif
+	
+	/*! Give back the original size */
+	stampBoundaries(pixels, original, xAxes, yAxes, sun_center, sun_radius, xmin, xmax, ymin, ymax, aggregationFactor, unsetValue, shapes, false);
+	
+	if(shapes != cache)
+		delete shapes;
 	return this;
+}
+
 
+/*!
+The set pixels further than width of the boundary of their region are unset.
+The distance transform of the boundaries is computed only around the contours (cf. Contours).
+*/
+ColorMap* ColorMap::drawInternContours(const unsigned width, const ColorType unsetValue)
+{
+	Contours contours(this, unsetValue);
+	contours.drawIntern(this, width, unsetValue);
+	return this;
 }
 
 
+/*!
+The unset pixels at a distance of at most width of a set pixel take the color of the nearest set pixel, the set pixels are unset.
+The nearest set pixel is always on the boundary of a region, so only the contours are used as seeds (cf. Contours).
+*/
 ColorMap* ColorMap::drawExternContours(const unsigned width, const ColorType unsetValue)
 {
-
-	ColorMap * copy = new ColorMap (this);
-	this->dilateCircular(width, unsetValue);
-	for (unsigned j = 0; j < numberPixels; ++j)
-	{
-		if(pixels[j] == copy->pixels[j])
-			pixels[j] = unsetValue;
-	}
-	delete copy;
+	Contours contours(this, unsetValue);
+	contours.drawExtern(this, width, unsetValue);
 	return this;
-
 }
 
 
+/*!
+The contours are drawn on both sides of the boundaries between 2 colors, with a width of width/2 on each side.
+The boundary pixels are the pixels that have a neighbour of a greater color, the contour takes that color.
+*/
 ColorMap* ColorMap::drawContours(const unsigned width, const ColorType unsetValue)
 {
 	unsigned size = width/2;
 	if (size <= 0)
 		size = 1;
 	
-	ColorType * newPixels = new ColorType[numberPixels];
-	memcpy(newPixels, pixels, numberPixels * sizeof(ColorType));
-	vector<unsigned> shape;
-	shape.reserve(size*size*3);
-	for(unsigned x = 1; x <= size; ++x)
-		shape.push_back(x);
-	for(int x = -size; x <= int(size); ++x)
-		for(unsigned y = 1; y <= size; ++y)
-			if(sqrt(x * x + y *y) <= size)
-				shape.push_back(y * xAxes + x);
-	
-	
-	int j = 0;
-	for(unsigned y = size; y < yAxes - size; ++y)
+	// We compute the color of the contour at each boundary pixel
+	ColorType * contourColors = new ColorType[numberPixels];
+	DistanceTransform transform(xAxes, yAxes);
+	for(unsigned y = 0, j = 0; y < yAxes; ++y)
 	{
-		j = y * xAxes + size;
-		for(unsigned x = size; x < xAxes - size; ++x)
+		for(unsigned x = 0; x < xAxes; ++x, ++j)
 		{
-			ColorType maxColor = pixels[j-1];
-			maxColor = pixels[j+1] > maxColor ? pixels[j+1] : maxColor;
-			maxColor = pixels[j-xAxes] > maxColor ? pixels[j-xAxes] : maxColor;
-			maxColor = pixels[j+xAxes] > maxColor ? pixels[j+xAxes] : maxColor;
+			ColorType maxColor = pixels[j];
+			if(x > 0 && pixels[j-1] > maxColor)
+				maxColor = pixels[j-1];
+			if(x + 1 < xAxes && pixels[j+1] > maxColor)
+				maxColor = pixels[j+1];
+			if(y > 0 && pixels[j-xAxes] > maxColor)
+				maxColor = pixels[j-xAxes];
+			if(y + 1 < yAxes && pixels[j+xAxes] > maxColor)
+				maxColor = pixels[j+xAxes];
+			contourColors[j] = maxColor;
 			if(pixels[j] != maxColor)
-			{
-				newPixels[j] = maxColor;
-				for(unsigned s = 0; s < shape.size(); ++s)
-				{
-					#if defined EXTRA_SAFE
-						if(j + shape[s] >= numberPixels || j - shape[s] < 0)
-						{
-							cerr<<"Error : trying to access pixel out of image in drawContours"<<endl;
-							exit(EXIT_FAILURE);
-						}
-					#endif
-					newPixels[j + shape[s]] = newPixels[j - shape[s]] = maxColor;
-				}
-				
-			}
-			else
-			{
-				newPixels[j] = unsetValue;
-			}
-			++j;
+				transform.setSeed(j);
 		}
 	}
+	transform.compute();
 	
-	delete[] pixels;
-	pixels = newPixels;
+	for(unsigned j = 0; j < numberPixels; ++j)
+	{
+		pixels[j] = transform.within(j, size) ? contourColors[transform.nearest(j)] : unsetValue;
+	}
+	
+	delete[] contourColors;
 	return this;
 }
 
-
 unsigned ColorMap::colorizeConnectedComponents(const ColorType setValue)
 {
-	ColorType color = setValue;
+	ConnectedComponents components(pixels, xAxes, yAxes, setValue);
 	for (unsigned j = 0; j < numberPixels; ++j)
 	{
-		if(pixels[j] == setValue)
-		{
-			++color;
-			propagateColor(color, j);
-		}
+		if(components.label(j))
+			pixels[j] = setValue + components.label(j);
 	}
 
-	return unsigned(color - setValue);
+	return components.numberComponents();
 
 }
 
@@ -755,11 +952,12 @@ unsigned ColorMap::propagateColor(const ColorType color, const unsigned firstPix
 			continue;
 		pixels[h] = color;
 		++numberColoredPixels;
-		if(h+1 < numberPixels && pixels[h+1] == setValue)
+		// The neighbours on the left and right must be on the same row
+		if((h+1) % xAxes != 0 && pixels[h+1] == setValue)
 			pixelList.push_back(h+1);
 		if(h+xAxes < numberPixels && pixels[h+xAxes] == setValue)
 			pixelList.push_back(h+xAxes);
-		if(h >= 1 && pixels[h-1] == setValue)
+		if(h % xAxes != 0 && pixels[h-1] == setValue)
 			pixelList.push_back(h-1);
 		if(h >= xAxes && pixels[h-xAxes] == setValue)
 			pixelList.push_back(h-xAxes);
@@ -772,47 +970,68 @@ unsigned ColorMap::propagateColor(const ColorType color, const unsigned firstPix
 
 unsigned ColorMap::thresholdConnectedComponents(const unsigned minSize, const ColorType setValue)
 {
-	deque<unsigned> treatedPixels;
-	ColorType color = setValue + 1;
-	for (unsigned j = 0; j < numberPixels; ++j)
+	ConnectedComponents components(pixels, xAxes, yAxes, setValue);
+	vector<bool> small(components.numberComponents() + 1, false);
+	unsigned numberComponents = 0;
+	for (unsigned l = 1; l <= components.numberComponents(); ++l)
 	{
-		if(pixels[j] == setValue)
-		{
-			if (propagateColor(color, j) < minSize)
-				propagateColor(nullpixelvalue, j);
-			else
-			{
-				++color;
-				treatedPixels.push_back(j);
-			}
-		}
+		if(components.component(l).numberPixels < minSize)
+			small[l] = true;
+		else
+			++numberComponents;
 	}
-	//We have to give back the original color
-	for (unsigned t = 0; t < treatedPixels.size(); ++t)
+	for (unsigned j = 0; j < numberPixels; ++j)
 	{
-		propagateColor(setValue, treatedPixels[t]);
+		if(small[components.label(j)])
+			pixels[j] = nullpixelvalue;
 	}
 
-	return unsigned(color - 1 - setValue);
+	return numberComponents;
 }
 
 
-ColorMap* ColorMap::removeHoles(ColorType unusedColor)
+/*!
+The holes are the connected components of the background that touch neither the border of the map nor the area outside of the sun disk.
+Each hole takes the color of the region that encloses it, i.e. the color of the pixel on the left of the first pixel of the hole.
+The regions inside the hole of another region keep their color.
+*/
+ColorMap* ColorMap::removeHoles()
 {
-	propagateColor(unusedColor, 0);
-	ColorType lastColor = nullpixelvalue;
-	for (unsigned j = 0; j < numberPixels; ++j)
+	ConnectedComponents background(pixels, xAxes, yAxes, nullpixelvalue);
+	vector<bool> hole(background.numberComponents() + 1, true);
+	hole[0] = false;
+	for (unsigned l = 1; l <= background.numberComponents(); ++l)
 	{
-		if(pixels[j] != nullpixelvalue)
-		{
-			lastColor = pixels[j];
-		}
-		else
+		const ConnectedComponents::Component& component = background.component(l);
+		if(component.boxmin.x == 0 || component.boxmin.y == 0 || component.boxmax.x + 1 == xAxes || component.boxmax.y + 1 == yAxes)
+			hole[l] = false;
+	}
+	
+	// The background outside of the sun disk is not a hole
+	const Real sunRadius = SunRadius();
+	if(sunRadius > 0)
+	{
+		const RealPixLoc sunCenter = SunCenter();
+		const Real squaredSunRadius = sunRadius * sunRadius;
+		for (unsigned y = 0, j = 0; y < yAxes; ++y)
 		{
-			pixels[j] = lastColor;
+			const Real dy = y - sunCenter.y;
+			for (unsigned x = 0; x < xAxes; ++x, ++j)
+			{
+				const unsigned l = background.label(j);
+				if(hole[l] && (x - sunCenter.x) * (x - sunCenter.x) + dy * dy > squaredSunRadius)
+					hole[l] = false;
+			}
 		}
 	}
-	propagateColor(nullpixelvalue, 0);
+	
+	// The pixel on the left of the first pixel of a hole is always in the enclosing region
+	for (unsigned j = 0; j < numberPixels; ++j)
+	{
+		const unsigned l = background.label(j);
+		if(hole[l])
+			pixels[j] = pixels[background.component(l).firstPixel - 1];
+	}
 	return this;
 }
 
@@ -877,67 +1096,19 @@ void ColorMap::preprocessing(const string& preprocessingList)
 
 void ColorMap::computeButterflyStats(vector<float>& totalNumberOfPixels, vector<float>& regionNumberOfPixels, vector<float>& correctedTotalNumberOfPixels, vector<float>& correctedRegionNumberOfPixels)
 {
-	totalNumberOfPixels.clear();
-	totalNumberOfPixels.resize(182, 0);
-	regionNumberOfPixels.clear();
-	regionNumberOfPixels.resize(182, 0);
-	correctedTotalNumberOfPixels.clear();
-	correctedTotalNumberOfPixels.resize(182, 0);
-	correctedRegionNumberOfPixels.clear();
-	correctedRegionNumberOfPixels.resize(182, 0);
-	
-	RealPixLoc sun_center = SunCenter();
-	Real sun_radius = SunRadius();
-	Real radius_squared = sun_radius * sun_radius;
-	
-	// We try to avoid computing latitude for pixels that are out of the sun disc
-	unsigned miny = sun_center.y - sun_radius - 1;
-	unsigned maxy = sun_center.y + sun_radius + 2;
-	unsigned minx = sun_center.x - sun_radius - 1;
-	unsigned maxx = sun_center.x + sun_radius + 2;
-	for (unsigned y = miny; y < maxy ; ++y)
-	{
-		for (unsigned x = minx; x < maxx; ++x)
-		{
-			// We compute sigma, the square distance of the pixel to the sun edge
-			Real dx = fabs(x - sun_center.x);
-			Real dy = fabs(y - sun_center.y);
-			Real sigma = radius_squared - (dx * dx) - (dy * dy);
-			
-			if(sigma > 0)
-			{
-				HGS hgs = toHGS(RealPixLoc(x, y));
-				if (!!hgs)
-				{
-					//cout<<"Latitude of coord "<<RealPixLoc(x, y)<< " : "<< int(hgs.latitude * RADIAN2DEGREE)<< "\n";
-					/* Pixels are gathered by the closest inferior integral latitude.
-					I.e the latitude -0.5 will go into the -1 latitude
-					but the latitude 0.5 will go into the 0 latitude
-					*/
-					// We compute the correction factor to compensate for the projection
-					Real correction_factor = sun_radius/sqrt(sigma);
-					int latitude = floor(hgs.latitude * RADIAN2DEGREE) + 91;
-					++totalNumberOfPixels[latitude];
-					// If the area correction factor is more than some value (i.e. the pixel is near the limb) we don't count it
-					if (correction_factor <= HIGGINS_FACTOR)
-						correctedTotalNumberOfPixels[latitude] += correction_factor;
-					if(this->pixel(x, y) != this->null())
-					{
-						++regionNumberOfPixels[latitude];
-						// If the area correction factor is more than some value (i.e. the pixel is near the limb) we don't count it
-						if (correction_factor <= HIGGINS_FACTOR)
-							correctedRegionNumberOfPixels[latitude] += correction_factor;
-					}
-				}
-			}
-		}
-	}
+	ButterflyGeometry geometry(this);
+	totalNumberOfPixels = geometry.TotalNumberOfPixels();
+	correctedTotalNumberOfPixels = geometry.CorrectedTotalNumberOfPixels();
+	geometry.accumulate(this, regionNumberOfPixels, correctedRegionNumberOfPixels);
 }
 
 #ifdef MAGICK
 using namespace MagickCore;
 MagickImage ColorMap::magick(const Magick::Color background)
 {
+	// The colors of the gradient are parsed only once per call, when they are first used
+	vector<Magick::Color> colors(gradientMax);
+	vector<bool> parsed(gradientMax, false);
 	MagickImage image(background, xAxes, yAxes);
 	for (unsigned y = 0; y < yAxes; ++y)
 	{
@@ -945,7 +1116,13 @@ MagickImage ColorMap::magick(const Magick::Color background)
 		{
 			if(pixel(x, y) != nullpixelvalue)
 			{
-				image.pixelColor(x, yAxes - y - 1, Magick::Color(gradient[pixel(x, y) % gradientMax]));
+				const unsigned c = pixel(x, y) % gradientMax;
+				if(!parsed[c])
+				{
+					colors[c] = Magick::Color(gradient[c]);
+					parsed[c] = true;
+				}
+				image.pixelColor(x, yAxes - y - 1, colors[c]);
 			}
 		}
 	}
@@ -13,6 +13,7 @@
 #include "MagickImage.h"
 #endif
 
+class ShapeCache;
 
 class ColorMap : public SunImage<ColorType>
 {
@@ -41,6 +42,29 @@ class ColorMap : public SunImage<ColorType>
 		//! Accessor to retrieve the interpolated value of the image in c
 		ColorType interpolate(const RealPixLoc& c) const;
 		
+		//! Return the number of bits (8, 16 or 32) needed to store the colors of the map
+		unsigned storageBits() const;
+		
+		//! Return the number of bits (8, 16 or 32) needed to store the colors up to maxColor
+		static unsigned storageBits(const ColorType maxColor);
+		
+		//! Routine to write the ColorMap to a fits file
+		/*! If mode contains FitsFile::runlength, or if we update a table, the map is written as a table of runs (cf. ColorRuns)
+			Otherwise the image is written with the smallest bitpix that can store all the colors (cf. storageBits)
+		*/
+		FitsFile& writeFits(FitsFile& file, int mode = 0, const std::string imagename = "");
+		
+		//! Routine to write the ColorMap to a fits file, when the caller knows the greatest color of the map
+		/*! The colors need not be scanned to find the bitpix, if maxColor is 0 they are scanned */
+		FitsFile& writeFits(FitsFile& file, int mode, const std::string imagename, const ColorType maxColor);
+		
+		//! Routine to read the ColorMap from a fits file
+		/*! The map can be stored as an image or as a table of runs (cf. ColorRuns) */
+		FitsFile& readFits(FitsFile& file);
+		
+		using SunImage<ColorType>::writeFits;
+		using SunImage<ColorType>::readFits;
+		
 		//! Routine to read the sun parameters from the header
 		void parseHeader();
 		
@@ -63,11 +87,23 @@ class ColorMap : public SunImage<ColorType>
 		ColorMap* erodeDiamond(const unsigned size, const ColorType pixelValueToErode);
 		
 		//! Routine to do dilation with the shape of a disc
+		/*! The dilated pixels take the color of the nearest set pixel, it is computed with a distance transform in linear time */
 		ColorMap* dilateCircular(const Real size, const ColorType unsetValue);
 		
 		//! Routine to do erosion with the shape of a disc
+		/*! It is computed with a distance transform in linear time */
 		ColorMap* erodeCircular(const Real size, const ColorType unsetValue);
 		
+		//! Routine to do an opening (erosion followed by dilation) with the shape of a disc
+		ColorMap* openingCircular(const Real size, const ColorType unsetValue);
+		
+		//! Routine to do a closing (dilation followed by erosion) with the shape of a disc
+		ColorMap* closingCircular(const Real size, const ColorType unsetValue);
+		
+		//! Routine to do the cleaning and aggregation of the regions with the shape of a disc
+		/*! Equivalent to an erosion of size cleaningFactor, a dilation of size cleaningFactor + aggregationFactor, and an erosion of size aggregationFactor */
+		ColorMap* aggregateCircular(const Real cleaningFactor, const Real aggregationFactor, const ColorType unsetValue);
+		
 		//! Compute the hcc coordinates of the right half circle of radius size around the center of the sun
 		std::vector<HCC> get_half_circle(Real size);
 		
@@ -75,10 +111,16 @@ class ColorMap : public SunImage<ColorType>
 		std::vector<PixLoc> get_shape(PixLoc center, const std::vector<HCC>& line);
 		
 		//! Routine to do dilation with the shape of a disc projected onto the sun
-		ColorMap* dilateCircularProjected(const Real size, const ColorType unsetValue);
+		/*! The shapes are taken from the cache, if none is provided a temporary one is used */
+		ColorMap* dilateCircularProjected(const Real size, const ColorType unsetValue, ShapeCache* cache = NULL);
 		
-		//! Routine to do dilation with the shape of a disc projected onto the sun
-		ColorMap* erodeCircularProjected(const Real size, const ColorType unsetValue);
+		//! Routine to do erosion with the shape of a disc projected onto the sun
+		/*! The shapes are taken from the cache, if none is provided a temporary one is used */
+		ColorMap* erodeCircularProjected(const Real size, const ColorType unsetValue, ShapeCache* cache = NULL);
+		
+		//! Routine to do the cleaning and aggregation of the regions with the shape of a disc projected onto the sun
+		/*! Equivalent to erodeCircularProjected of size cleaningFactor, dilateCircularProjected of size cleaningFactor + aggregationFactor, and erodeCircularProjected of size aggregationFactor */
+		ColorMap* aggregateCircularProjected(const Real cleaningFactor, const Real aggregationFactor, const ColorType unsetValue, ShapeCache* cache = NULL);
 		
 		//! Routine to threshold regions by its raw size
 		void thresholdRegionsByRawArea(const double minSize);
@@ -107,13 +149,15 @@ class ColorMap : public SunImage<ColorType>
 		//! Routine that erase all but the colors provided
 		void keepColors(const std::set<ColorType>& colors);
 		
-		//! Routine that tries to remove holes in connected components
-		ColorMap* removeHoles(ColorType unusedColor = std::numeric_limits<ColorType>::max() - 1);
+		//! Routine that fills the holes in the regions with the color of the enclosing region
+		/*! The holes are found by labeling the connected components of the background */
+		ColorMap* removeHoles();
 		
 		//! Routine to preprocess an image
 		void preprocessing(const std::string& preprocessingList);
 		
 		//! Method to compute the area per latitude
+		/*! To compute the statistics of many maps with the same WCS, use a ButterflyGeometry */
 		void computeButterflyStats(std::vector<float>& totalNumberOfPixels, std::vector<float>& regionNumberOfPixels, std::vector<float>& correctedTotalNumberOfPixels, std::vector<float>& correctedRegionNumberOfPixels);
 		
 		#ifdef MAGICK
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include "ColorRuns.h"
+
+using namespace std;
+
+ColorRuns::ColorRuns()
+:xAxes(0), yAxes(0), rows(1, 0)
+{}
+
+ColorRuns::ColorRuns(const ColorMap* map)
+:xAxes(0), yAxes(0), rows(1, 0)
+{
+	encode(map);
+}
+
+void ColorRuns::encode(const ColorMap* map)
+{
+	xAxes = map->Xaxes();
+	yAxes = map->Yaxes();
+	rows.resize(yAxes + 1);
+	runs.clear();
+	const ColorType null = map->null();
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		rows[y] = runs.size();
+		const ColorType* row = &(map->pixel(0, y));
+		unsigned x = 0;
+		while (x < xAxes)
+		{
+			if(row[x] == null)
+			{
+				++x;
+				continue;
+			}
+			unsigned start = x;
+			while (x < xAxes && row[x] == row[start])
+				++x;
+			runs.push_back(Run(start, x - start, row[start]));
+		}
+	}
+	rows[yAxes] = runs.size();
+}
+
+void ColorRuns::decode(ColorMap* map) const
+{
+	if(map->Xaxes() != xAxes || map->Yaxes() != yAxes)
+		map->resize(xAxes, yAxes);
+	map->zero(map->null());
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		ColorType* row = &(map->pixel(0, y));
+		for (vector<Run>::const_iterator r = row_begin(y); r != row_end(y); ++r)
+			fill(row + r->start, row + r->start + r->length, r->color);
+	}
+}
+
+// Order of the runs by start, to search the run of a pixel
+static bool startsBefore(const unsigned x, const ColorRuns::Run& run)
+{
+	return x < run.start;
+}
+
+ColorType ColorRuns::pixel(const unsigned x, const unsigned y, const ColorType null) const
+{
+	if(y >= yAxes)
+		return null;
+	// We search the last run that starts at or before x
+	vector<Run>::const_iterator r = upper_bound(row_begin(y), row_end(y), x, startsBefore);
+	if(r == row_begin(y))
+		return null;
+	--r;
+	return x < r->start + r->length ? r->color : null;
+}
+
+ColorType ColorRuns::interpolate(const RealPixLoc& c, const ColorType null) const
+{
+	float x = c.x < 0.? 0. : min(float(xAxes-1.001), float(c.x));
+	float y = c.y < 0.? 0. : min(float(yAxes-1.001), float(c.y));
+	
+	unsigned ix = (unsigned) x;
+	unsigned iy = (unsigned) y;
+	float dx = x - ix;
+	float dy = y - iy;
+	float cdx = 1. - dx;
+	float cdy = 1. - dy;
+	ColorType colors[] = {pixel(ix, iy, null), pixel(ix+1, iy, null), pixel(ix, iy+1, null), pixel(ix+1, iy+1, null)};
+	float quantity[] = {cdx*cdy, dx*cdy, cdx*dy, dx*dy};
+	
+	for(unsigned i = 0; i < 3; ++i)
+		for(unsigned j = i+1; j < 4; ++j)
+			if(colors[i] == colors[j])
+			{
+				quantity[i] += quantity[j];
+				quantity[j] = 0;
+			}
+	unsigned max = 0;
+	for(unsigned i = 1; i < 4; ++i)
+		max = quantity[i] > quantity[max] ? i : max;
+	
+	return colors[max];
+}
+
+void ColorRuns::assign(const unsigned xAxes, const unsigned yAxes, const vector<PixLoc>& start, const vector<unsigned>& length, const vector<ColorType>& color)
+{
+	this->xAxes = xAxes;
+	this->yAxes = yAxes;
+	vector<pair<unsigned long, unsigned> > order;
+	order.reserve(start.size());
+	for (unsigned r = 0; r < start.size() && r < length.size() && r < color.size(); ++r)
+	{
+		if(start[r].y < yAxes && start[r].x + length[r] <= xAxes)
+			order.push_back(make_pair((unsigned long)(start[r].y) * xAxes + start[r].x, r));
+		else
+			cerr<<"Error : run "<<r<<" is outside the map."<<endl;
+	}
+	sort(order.begin(), order.end());
+	
+	rows.assign(yAxes + 1, 0);
+	runs.resize(order.size());
+	for (unsigned r = 0; r < order.size(); ++r)
+	{
+		unsigned i = order[r].second;
+		runs[r] = Run(start[i].x, length[i], color[i]);
+		++rows[start[i].y + 1];
+	}
+	for (unsigned y = 0; y < yAxes; ++y)
+		rows[y + 1] += rows[y];
+}
+
+map<ColorType, unsigned> ColorRuns::areas() const
+{
+	map<ColorType, unsigned> areas;
+	for (vector<Run>::const_iterator r = runs.begin(); r != runs.end(); ++r)
+		areas[r->color] += r->length;
+	return areas;
+}
+
+void ColorRuns::boxes(map<ColorType, PixLoc>& boxmin, map<ColorType, PixLoc>& boxmax) const
+{
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		for (vector<Run>::const_iterator r = row_begin(y); r != row_end(y); ++r)
+		{
+			unsigned end = r->start + r->length - 1;
+			map<ColorType, PixLoc>::iterator min = boxmin.find(r->color);
+			if(min == boxmin.end())
+			{
+				boxmin[r->color] = PixLoc(r->start, y);
+				boxmax[r->color] = PixLoc(end, y);
+			}
+			else
+			{
+				PixLoc& max = boxmax[r->color];
+				min->second.x = r->start < min->second.x ? r->start : min->second.x;
+				max.x = end > max.x ? end : max.x;
+				// The rows are visited in increasing order
+				max.y = y;
+			}
+		}
+	}
+}
+
+map<pair<ColorType, ColorType>, unsigned> ColorRuns::overlap(const ColorRuns& other) const
+{
+	map<pair<ColorType, ColorType>, unsigned> overlap;
+	if(xAxes != other.xAxes || yAxes != other.yAxes)
+	{
+		cerr<<"Error : cannot compute the overlap of maps of different size"<<endl;
+		return overlap;
+	}
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		// We walk the runs of both rows together
+		vector<Run>::const_iterator a = row_begin(y), b = other.row_begin(y);
+		while (a != row_end(y) && b != other.row_end(y))
+		{
+			unsigned a_end = a->start + a->length, b_end = b->start + b->length;
+			unsigned start = a->start > b->start ? a->start : b->start;
+			unsigned end = a_end < b_end ? a_end : b_end;
+			if(start < end)
+				overlap[make_pair(a->color, b->color)] += end - start;
+			if(a_end < b_end)
+				++a;
+			else
+				++b;
+		}
+	}
+	return overlap;
+}
+
+void ColorRuns::recolor(const map<ColorType, ColorType>& LUT)
+{
+	for (vector<Run>::iterator r = runs.begin(); r != runs.end(); ++r)
+	{
+		map<ColorType, ColorType>::const_iterator color = LUT.find(r->color);
+		if(color != LUT.end())
+			r->color = color->second;
+	}
+}
+
+void ColorRuns::nullifyAboveRadius(const RealPixLoc& sun_center, const Real radius)
+{
+	// The coordinates are computed the same way as in SunImage::nullifyAboveRadius, so the same pixels are removed
+	Real radius2 = radius*radius;
+	vector<Real> xs, ys;
+	Real max_x = -sun_center.x + xAxes;
+	Real max_y = -sun_center.y + yAxes;
+	for (Real y = -sun_center.y; y < max_y && ys.size() < yAxes; ++y)
+		ys.push_back(y);
+	for (Real x = -sun_center.x; x < max_x && xs.size() < xAxes; ++x)
+		xs.push_back(x);
+	
+	vector<Run> cropped;
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		const unsigned first = rows[y];
+		rows[y] = cropped.size();
+		for (vector<Run>::const_iterator r = runs.begin() + first; r != runs.begin() + rows[y + 1]; ++r)
+		{
+			unsigned x = r->start;
+			const unsigned end = r->start + r->length;
+			while (x < end)
+			{
+				if(y >= ys.size() || x >= xs.size() || xs[x] * xs[x] + ys[y] * ys[y] > radius2)
+				{
+					++x;
+					continue;
+				}
+				unsigned start = x;
+				while (x < end && x < xs.size() && xs[x] * xs[x] + ys[y] * ys[y] <= radius2)
+					++x;
+				cropped.push_back(Run(start, x - start, r->color));
+			}
+		}
+	}
+	rows[yAxes] = cropped.size();
+	runs.swap(cropped);
+}
+
+FitsFile& ColorRuns::writeFits(FitsFile& file, const int mode) const
+{
+	FitsTable table(runs.size());
+	vector<PixLoc>& start = table.column<PixLoc>("START");
+	vector<unsigned>& length = table.column<unsigned>("LENGTH");
+	vector<ColorType>& color = table.column<ColorType>("COLOR");
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		for (unsigned r = rows[y]; r < rows[y + 1]; ++r)
+		{
+			start[r] = PixLoc(runs[r].start, y);
+			length[r] = runs[r].length;
+			color[r] = runs[r].color;
+		}
+	}
+	// When we overwrite the runs, the table may have more rows than needed
+	if(mode & FitsFile::overwrite)
+		file.resizeTable(runs.size());
+	file.writeColumns(table, mode);
+	
+	Header header;
+	header.set("MAPNAXI1", xAxes, "Size of the X axes of the map");
+	header.set("MAPNAXI2", yAxes, "Size of the Y axes of the map");
+	return file.writeHeader(header);
+}
+
+FitsFile& ColorRuns::readFits(FitsFile& file)
+{
+	Header header;
+	file.readHeader(header);
+	if(!header.has("MAPNAXI1") || !header.has("MAPNAXI2"))
+	{
+		cerr<<"Error : table is not a map of runs, no MAPNAXI1 or MAPNAXI2 keyword."<<endl;
+		return file;
+	}
+	FitsTable table;
+	vector<PixLoc>& start = table.column<PixLoc>("START");
+	vector<unsigned>& length = table.column<unsigned>("LENGTH");
+	vector<ColorType>& color = table.column<ColorType>("COLOR");
+	file.readColumns(table);
+	
+	// The runs are sorted by row, in case the table was not written by us
+	assign(header.get<unsigned>("MAPNAXI1"), header.get<unsigned>("MAPNAXI2"), start, length, color);
+	return file;
+}
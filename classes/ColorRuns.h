@@ -0,0 +1,124 @@
+#pragma once
+#ifndef ColorRuns_H
+#define ColorRuns_H
+
+#include <vector>
+#include <map>
+#include <utility>
+
+#include "constants.h"
+#include "Coordinate.h"
+#include "FitsFile.h"
+#include "ColorMap.h"
+
+//! Class that stores a ColorMap as a list of runs of pixels of the same color
+/*!
+Each row of the map is stored as a list of runs (start, length, color), the null pixels are not stored.
+Because most of the pixels of a map of regions are null, and the regions are contiguous, the list of runs is much smaller than the map.
+
+The runs are stored in a fits binary table with the columns YSTART, XSTART, LENGTH and COLOR, one row per run.
+The size of the map is stored in the keywords MAPNAXI1 and MAPNAXI2 of the table.
+
+The area, the bounding box and the overlap of the regions can be computed directly on the runs, without decoding the null pixels.
+The color of a pixel is found by a binary search in the runs of it's row, so the runs can replace the map when only a few pixels are looked at (e.g. for tracking).
+*/
+
+class ColorRuns
+{
+	public :
+		//! A run of pixels of the same color in a row
+		struct Run
+		{
+			//! Position in the row of the first pixel of the run
+			unsigned start;
+			//! Number of pixels of the run
+			unsigned length;
+			//! Color of the run
+			ColorType color;
+			
+			Run(const unsigned start = 0, const unsigned length = 0, const ColorType color = 0)
+			:start(start), length(length), color(color)
+			{}
+		};
+
+	private :
+		//! Size of the X axes of the map
+		unsigned xAxes;
+		//! Size of the Y axes of the map
+		unsigned yAxes;
+		//! Position in runs of the first run of each row, the last element is the total number of runs
+		std::vector<unsigned> rows;
+		//! The runs, row by row
+		std::vector<Run> runs;
+
+	public :
+		//! Constructor
+		ColorRuns();
+		
+		//! Constructor from a ColorMap, the null pixels are skipped
+		ColorRuns(const ColorMap* map);
+		
+		//! Routine to encode a ColorMap, the null pixels are skipped
+		void encode(const ColorMap* map);
+		
+		//! Routine to decode the runs into a ColorMap
+		/*! The map is resized if needed, and the pixels outside the runs are set to null */
+		void decode(ColorMap* map) const;
+		
+		//! Size of the X axes of the map
+		unsigned Xaxes() const
+		{return xAxes;}
+		
+		//! Size of the Y axes of the map
+		unsigned Yaxes() const
+		{return yAxes;}
+		
+		//! Number of runs
+		unsigned NumberRuns() const
+		{return runs.size();}
+		
+		//! Accessor to the first run of the row y
+		std::vector<Run>::const_iterator row_begin(const unsigned y) const
+		{return runs.begin() + rows[y];}
+		
+		//! Accessor to the end of the runs of the row y
+		std::vector<Run>::const_iterator row_end(const unsigned y) const
+		{return runs.begin() + rows[y + 1];}
+		
+		//! Return the color of the pixel (x, y), or null if it is not in a run
+		ColorType pixel(const unsigned x, const unsigned y, const ColorType null = 0) const;
+		
+		//! Return the color at a real position, with the same interpolation as ColorMap::interpolate
+		ColorType interpolate(const RealPixLoc& c, const ColorType null = 0) const;
+		
+		//! Routine to set the runs from their start, length and color
+		/*! The runs are sorted by row, and the runs outside the map are skipped */
+		void assign(const unsigned xAxes, const unsigned yAxes, const std::vector<PixLoc>& start, const std::vector<unsigned>& length, const std::vector<ColorType>& color);
+		
+		//! Return the number of pixels of each color
+		std::map<ColorType, unsigned> areas() const;
+		
+		//! Compute the bounding box of each color
+		void boxes(std::map<ColorType, PixLoc>& boxmin, std::map<ColorType, PixLoc>& boxmax) const;
+		
+		//! Return the number of pixels of each pair of colors (this color, other color) that overlap
+		/*! Both maps must have the same size */
+		std::map<std::pair<ColorType, ColorType>, unsigned> overlap(const ColorRuns& other) const;
+		
+		//! Routine that recolors the runs using a color lookup table
+		/*! The colors that are not in the LUT are left unchanged */
+		void recolor(const std::map<ColorType, ColorType>& LUT);
+		
+		//! Routine that removes the pixels further than radius from the center of the sun
+		/*! The same pixels are removed as by SunImage::nullifyAboveRadius */
+		void nullifyAboveRadius(const RealPixLoc& sun_center, const Real radius);
+		
+		//! Routine to write the runs in the current table of the fits file
+		/*! @param mode The mode is passed to FitsFile::writeColumns */
+		FitsFile& writeFits(FitsFile& file, const int mode = 0) const;
+		
+		//! Routine to read the runs from the current table of the fits file
+		FitsFile& readFits(FitsFile& file);
+};
+
+#endif
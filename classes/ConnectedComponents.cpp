@@ -0,0 +1,206 @@
+#include "ConnectedComponents.h"
+
+using namespace std;
+
+ConnectedComponents::ConnectedComponents(const ColorType* pixels, const unsigned xAxes, const unsigned yAxes, const ColorType setValue, const unsigned connectivity, const unsigned numberThreads)
+:xAxes(xAxes), yAxes(yAxes), connectivity(connectivity == 8 ? 8 : 4), labels(xAxes * yAxes, 0), parents(xAxes * yAxes + 1, 0), components(1)
+{
+	label(pixels, setValue, numberThreads);
+}
+
+unsigned ConnectedComponents::find(unsigned l)
+{
+	while(parents[l] != l)
+	{
+		parents[l] = parents[parents[l]];
+		l = parents[l];
+	}
+	return l;
+}
+
+void ConnectedComponents::merge(unsigned a, unsigned b)
+{
+	a = find(a);
+	b = find(b);
+	if(a < b)
+		parents[b] = a;
+	else if(b < a)
+		parents[a] = b;
+}
+
+void* ConnectedComponents::labelStrip(void* arg)
+{
+	Strip& strip = *static_cast<Strip*>(arg);
+	ConnectedComponents& self = *strip.self;
+	const unsigned xAxes = self.xAxes;
+	unsigned* labels = &(self.labels[0]);
+	for(unsigned y = strip.firstRow; y < strip.lastRow; ++y)
+	{
+		unsigned j = y * xAxes;
+		for(unsigned x = 0; x < xAxes; ++x, ++j)
+		{
+			if(strip.pixels[j] != strip.setValue)
+				continue;
+			unsigned l = x > 0 ? labels[j - 1] : 0;
+			if(y > strip.firstRow)
+			{
+				unsigned up = labels[j - xAxes];
+				if(self.connectivity == 8)
+				{
+					unsigned diagonal = x > 0 ? labels[j - xAxes - 1] : 0;
+					if(diagonal)
+					{
+						if(l && l != diagonal)
+							self.merge(l, diagonal);
+						else
+							l = diagonal;
+					}
+					diagonal = x + 1 < xAxes ? labels[j - xAxes + 1] : 0;
+					if(diagonal)
+					{
+						if(l && l != diagonal)
+							self.merge(l, diagonal);
+						else
+							l = diagonal;
+					}
+				}
+				if(up)
+				{
+					if(l && l != up)
+						self.merge(l, up);
+					else
+						l = up;
+				}
+			}
+			if(!l)
+			{
+				l = strip.nextLabel++;
+				self.parents[l] = l;
+			}
+			labels[j] = l;
+		}
+	}
+	return NULL;
+}
+
+void* ConnectedComponents::relabelStrip(void* arg)
+{
+	Strip& strip = *static_cast<Strip*>(arg);
+	ConnectedComponents& self = *strip.self;
+	const unsigned xAxes = self.xAxes;
+	unsigned* labels = &(self.labels[0]);
+	for(unsigned y = strip.firstRow; y < strip.lastRow; ++y)
+	{
+		unsigned j = y * xAxes;
+		for(unsigned x = 0; x < xAxes; ++x, ++j)
+		{
+			if(!labels[j])
+				continue;
+			unsigned l = self.parents[labels[j]];
+			labels[j] = l;
+			Component& component = strip.components[l];
+			if(component.numberPixels == 0)
+				component.firstPixel = j;
+			++component.numberPixels;
+			if(x < component.boxmin.x)
+				component.boxmin.x = x;
+			if(x > component.boxmax.x)
+				component.boxmax.x = x;
+			if(y < component.boxmin.y)
+				component.boxmin.y = y;
+			if(y > component.boxmax.y)
+				component.boxmax.y = y;
+		}
+	}
+	return NULL;
+}
+
+void ConnectedComponents::label(const ColorType* pixels, const ColorType setValue, unsigned numberThreads)
+{
+	if(xAxes == 0 || yAxes == 0)
+		return;
+	if(numberThreads > yAxes / minimalStripRows)
+		numberThreads = yAxes / minimalStripRows;
+	if(numberThreads < 1)
+		numberThreads = 1;
+
+	// Each strip has it's own range of provisional labels, starting at the position of it's first pixel
+	// Because the ranges follow the order of the pixels, the smallest label of a component is the label of it's first pixel
+	vector<Strip> strips(numberThreads);
+	for(unsigned s = 0; s < numberThreads; ++s)
+	{
+		strips[s].self = this;
+		strips[s].pixels = pixels;
+		strips[s].setValue = setValue;
+		strips[s].firstRow = (s * yAxes) / numberThreads;
+		strips[s].lastRow = ((s + 1) * yAxes) / numberThreads;
+		strips[s].nextLabel = strips[s].firstRow * xAxes + 1;
+	}
+	runStrips(strips, labelStrip);
+
+	// We merge the components along the boundaries of the strips
+	for(unsigned s = 1; s < strips.size(); ++s)
+	{
+		unsigned j = strips[s].firstRow * xAxes;
+		for(unsigned x = 0; x < xAxes; ++x, ++j)
+		{
+			if(!labels[j])
+				continue;
+			if(labels[j - xAxes])
+				merge(labels[j], labels[j - xAxes]);
+			if(connectivity == 8)
+			{
+				if(x > 0 && labels[j - xAxes - 1])
+					merge(labels[j], labels[j - xAxes - 1]);
+				if(x + 1 < xAxes && labels[j - xAxes + 1])
+					merge(labels[j], labels[j - xAxes + 1]);
+			}
+		}
+	}
+
+	// We replace the parents by the final labels, in increasing order of the provisional labels
+	// As the parent of a label is always smaller, it already contains it's final label
+	unsigned numberComponents = 0;
+	for(unsigned s = 0; s < strips.size(); ++s)
+	{
+		for(unsigned l = strips[s].firstRow * xAxes + 1; l < strips[s].nextLabel; ++l)
+		{
+			if(parents[l] < l)
+				parents[l] = parents[parents[l]];
+			else
+				parents[l] = ++numberComponents;
+		}
+	}
+
+	for(unsigned s = 0; s < strips.size(); ++s)
+	{
+		strips[s].components.resize(numberComponents + 1);
+	}
+	runStrips(strips, relabelStrip);
+	// The equivalences are not needed anymore
+	vector<unsigned>().swap(parents);
+
+	// We merge the statistics of the strips
+	components.resize(numberComponents + 1);
+	for(unsigned s = 0; s < strips.size(); ++s)
+	{
+		for(unsigned l = 1; l <= numberComponents; ++l)
+		{
+			const Component& part = strips[s].components[l];
+			if(part.numberPixels == 0)
+				continue;
+			Component& component = components[l];
+			if(component.numberPixels == 0)
+				component.firstPixel = part.firstPixel;
+			component.numberPixels += part.numberPixels;
+			if(part.boxmin.x < component.boxmin.x)
+				component.boxmin.x = part.boxmin.x;
+			if(part.boxmax.x > component.boxmax.x)
+				component.boxmax.x = part.boxmax.x;
+			if(part.boxmin.y < component.boxmin.y)
+				component.boxmin.y = part.boxmin.y;
+			if(part.boxmax.y > component.boxmax.y)
+				component.boxmax.y = part.boxmax.y;
+		}
+	}
+}
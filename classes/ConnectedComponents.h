@@ -0,0 +1,135 @@
+#pragma once
+#ifndef ConnectedComponents_H
+#define ConnectedComponents_H
+
+#include <vector>
+#include <pthread.h>
+
+#include "constants.h"
+#include "Coordinate.h"
+
+//! Class that labels the connected components of the pixels of a given color
+/*!
+The labeling is done in 2 passes with a union find of the provisional labels.
+The first pass gives a provisional label to each pixel from it's already labeled neighbours, and records the equivalences between labels.
+The second pass replaces the provisional labels by the final ones, and computes the statistics of the components.
+
+The image is split in strips of rows that are labeled in parallel, the equivalences along the boundaries of the strips are merged before the second pass.
+
+The components are labeled from 1 in the order of their first pixel, the background pixels have label 0.
+The statistics of each component (number of pixels, bounding box and first pixel) are computed during the labeling, so they do not need another pass.
+*/
+
+class ConnectedComponents
+{
+	public :
+		//! Statistics of a connected component
+		struct Component
+		{
+			//! Number of pixels of the component
+			unsigned numberPixels;
+			//! Position of the first pixel of the component
+			unsigned firstPixel;
+			//! Lower left corner of the bounding box
+			PixLoc boxmin;
+			//! Upper right corner of the bounding box
+			PixLoc boxmax;
+
+			Component()
+			:numberPixels(0), firstPixel(0), boxmin(PixLoc::null()), boxmax(0, 0)
+			{}
+		};
+
+	private :
+		//! Size of the X axes of the image
+		unsigned xAxes;
+		//! Size of the Y axes of the image
+		unsigned yAxes;
+		//! 4 or 8 connectivity
+		unsigned connectivity;
+		//! The label of each pixel
+		std::vector<unsigned> labels;
+		//! The equivalence between labels, the root of a label is always the smallest label of the component
+		std::vector<unsigned> parents;
+		//! The statistics of the components, component 0 is the background
+		std::vector<Component> components;
+
+		//! A strip of rows labeled by one thread
+		struct Strip
+		{
+			ConnectedComponents* self;
+			const ColorType* pixels;
+			ColorType setValue;
+			unsigned firstRow;
+			unsigned lastRow;
+			//! Next provisional label of the strip
+			unsigned nextLabel;
+			//! Statistics of the components in the strip
+			std::vector<Component> components;
+		};
+
+		//! Thread routine of the first pass
+		static void* labelStrip(void* strip);
+		//! Thread routine of the second pass
+		static void* relabelStrip(void* strip);
+
+		//! Return the root of the label l
+		unsigned find(unsigned l);
+		//! Routine to merge the components of the labels a and b
+		void merge(unsigned a, unsigned b);
+
+		//! Routine to do the 2 passes of the labeling
+		void label(const ColorType* pixels, const ColorType setValue, unsigned numberThreads);
+
+	public :
+		//! Constructor, labels the connected components of the pixels of color setValue
+		ConnectedComponents(const ColorType* pixels, const unsigned xAxes, const unsigned yAxes, const ColorType setValue, const unsigned connectivity = 4, const unsigned numberThreads = NUMBER_THREADS);
+
+		//! Return the number of connected components
+		unsigned numberComponents() const
+		{
+			return components.size() - 1;
+		}
+
+		//! Return the label of the pixel j, 0 if the pixel is not in a component
+		unsigned label(const unsigned j) const
+		{
+			return labels[j];
+		}
+
+		//! Return the statistics of the component with label l (starting at 1)
+		const Component& component(const unsigned l) const
+		{
+			return components[l];
+		}
+};
+
+//! Minimal number of rows of a strip, so that the threads are worth it
+static const unsigned minimalStripRows = 64;
+
+//! Routine to run the routine on all the strips, one thread per strip
+template<class Strip>
+void runStrips(std::vector<Strip>& strips, void* (*routine)(void*))
+{
+	if(strips.size() == 1)
+	{
+		routine(&strips[0]);
+		return;
+	}
+	std::vector<pthread_t> threads(strips.size());
+	std::vector<bool> started(strips.size(), false);
+	for(unsigned s = 0; s < strips.size(); ++s)
+	{
+		started[s] = pthread_create(&threads[s], NULL, routine, &strips[s]) == 0;
+		// If we cannot create a thread, we do the strip ourself
+		if(!started[s])
+			routine(&strips[s]);
+	}
+	for(unsigned s = 0; s < strips.size(); ++s)
+	{
+		if(started[s])
+			pthread_join(threads[s], NULL);
+	}
+}
+
+#endif
@@ -0,0 +1,326 @@
+#include <algorithm>
+#include "Contours.h"
+
+using namespace std;
+
+Contours::Contours()
+:xAxes(0), yAxes(0), offsets(1, 0), boxmin(PixLoc::null()), boxmax(0, 0)
+{}
+
+Contours::Contours(const ColorMap* map, const ColorType unsetValue)
+:xAxes(0), yAxes(0), offsets(1, 0), boxmin(PixLoc::null()), boxmax(0, 0)
+{
+	extract(map, unsetValue);
+}
+
+void Contours::extract(const ColorMap* map, const ColorType unsetValue)
+{
+	xAxes = map->Xaxes();
+	yAxes = map->Yaxes();
+
+	// We collect the contour pixels with their color, in the order of the pixels
+	vector<pair<ColorType, unsigned> > contourPixels;
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		const ColorType* row = &(map->pixel(0, y));
+		const ColorType* previous = y > 0 ? row - xAxes : NULL;
+		const ColorType* next = y + 1 < yAxes ? row + xAxes : NULL;
+		for (unsigned x = 0; x < xAxes; ++x)
+		{
+			const ColorType color = row[x];
+			if(color == unsetValue)
+				continue;
+			if((x > 0 && row[x-1] != color) || (x + 1 < xAxes && row[x+1] != color) || (previous && previous[x] != color) || (next && next[x] != color))
+				contourPixels.push_back(make_pair(color, y * xAxes + x));
+		}
+	}
+	// The sort is stable so the pixels of a contour stay in order
+	stable_sort(contourPixels.begin(), contourPixels.end(), lessColor);
+	setContours(contourPixels);
+}
+
+bool Contours::lessColor(const pair<ColorType, unsigned>& a, const pair<ColorType, unsigned>& b)
+{
+	return a.first < b.first;
+}
+
+void Contours::setContours(const vector<pair<ColorType, unsigned> >& contourPixels)
+{
+	colors.clear();
+	offsets.assign(1, 0);
+	pixels.resize(contourPixels.size());
+	boxmin = PixLoc::null();
+	boxmax = PixLoc(0, 0);
+	for (unsigned p = 0; p < contourPixels.size(); ++p)
+	{
+		if(colors.empty() || colors.back() != contourPixels[p].first)
+		{
+			if(!colors.empty())
+				offsets.push_back(p);
+			colors.push_back(contourPixels[p].first);
+		}
+		const unsigned j = contourPixels[p].second;
+		pixels[p] = j;
+		const unsigned x = j % xAxes, y = j / xAxes;
+		if(x < boxmin.x)
+			boxmin.x = x;
+		if(x > boxmax.x)
+			boxmax.x = x;
+		if(y < boxmin.y)
+			boxmin.y = y;
+		if(y > boxmax.y)
+			boxmax.y = y;
+	}
+	if(!colors.empty())
+		offsets.push_back(pixels.size());
+}
+
+vector<PixLoc> Contours::contour(const unsigned c) const
+{
+	vector<PixLoc> contour;
+	contour.reserve(NumberPixels(c));
+	for (unsigned p = 0; p < NumberPixels(c); ++p)
+		contour.push_back(Pixel(c, p));
+	return contour;
+}
+
+void Contours::paint(ColorMap* map) const
+{
+	if(map->Xaxes() != xAxes || map->Yaxes() != yAxes)
+	{
+		cerr<<"Error : cannot paint the contours on a map of a different size."<<endl;
+		return;
+	}
+	for (unsigned c = 0; c < colors.size(); ++c)
+	{
+		for (unsigned p = offsets[c]; p < offsets[c + 1]; ++p)
+			map->pixel(pixels[p]) = colors[c];
+	}
+}
+
+bool Contours::window(const Real width, PixLoc& windowmin, PixLoc& windowmax) const
+{
+	if(pixels.empty())
+		return false;
+	// The pixels outside of the window are further than width of the contours
+	const unsigned margin = width > 0 ? unsigned(width) + 1 : 1;
+	windowmin.x = boxmin.x > margin ? boxmin.x - margin : 0;
+	windowmin.y = boxmin.y > margin ? boxmin.y - margin : 0;
+	windowmax.x = boxmax.x + margin < xAxes ? boxmax.x + margin : xAxes - 1;
+	windowmax.y = boxmax.y + margin < yAxes ? boxmax.y + margin : yAxes - 1;
+	return true;
+}
+
+void Contours::distances(const PixLoc& windowmin, const PixLoc& windowmax, DistanceTransform& transform, vector<ColorType>& seedColors) const
+{
+	const unsigned windowWidth = windowmax.x - windowmin.x + 1;
+	seedColors.resize(windowWidth * (windowmax.y - windowmin.y + 1));
+	for (unsigned c = 0; c < colors.size(); ++c)
+	{
+		for (unsigned p = offsets[c]; p < offsets[c + 1]; ++p)
+		{
+			const unsigned w = (pixels[p] / xAxes - windowmin.y) * windowWidth + pixels[p] % xAxes - windowmin.x;
+			transform.setSeed(w);
+			seedColors[w] = colors[c];
+		}
+	}
+	transform.compute();
+}
+
+/*!
+Same as ColorMap::drawInternContours, but the distance transform is computed only around the contours.
+*/
+void Contours::drawIntern(ColorMap* map, const Real width, const ColorType unsetValue) const
+{
+	if(map->Xaxes() != xAxes || map->Yaxes() != yAxes)
+	{
+		cerr<<"Error : cannot draw the contours on a map of a different size."<<endl;
+		return;
+	}
+	PixLoc windowmin, windowmax;
+	if(!window(width, windowmin, windowmax))
+	{
+		map->zero(unsetValue);
+		return;
+	}
+	const unsigned windowWidth = windowmax.x - windowmin.x + 1;
+	DistanceTransform transform(windowWidth, windowmax.y - windowmin.y + 1);
+	vector<ColorType> seedColors;
+	distances(windowmin, windowmax, transform, seedColors);
+
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		ColorType* row = &(map->pixel(0, y));
+		if(y < windowmin.y || y > windowmax.y)
+		{
+			fill(row, row + xAxes, unsetValue);
+			continue;
+		}
+		for (unsigned x = 0; x < xAxes; ++x)
+		{
+			if(x < windowmin.x || x > windowmax.x || !transform.within((y - windowmin.y) * windowWidth + x - windowmin.x, width))
+				row[x] = unsetValue;
+		}
+	}
+}
+
+/*!
+Same as ColorMap::drawExternContours: the nearest set pixel of an unset pixel is always a contour pixel, so the contours are enough as seeds.
+*/
+void Contours::drawExtern(ColorMap* map, const Real width, const ColorType unsetValue) const
+{
+	if(map->Xaxes() != xAxes || map->Yaxes() != yAxes)
+	{
+		cerr<<"Error : cannot draw the contours on a map of a different size."<<endl;
+		return;
+	}
+	PixLoc windowmin, windowmax;
+	if(!window(width, windowmin, windowmax))
+	{
+		map->zero(unsetValue);
+		return;
+	}
+	const unsigned windowWidth = windowmax.x - windowmin.x + 1;
+	DistanceTransform transform(windowWidth, windowmax.y - windowmin.y + 1);
+	vector<ColorType> seedColors;
+	distances(windowmin, windowmax, transform, seedColors);
+
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		ColorType* row = &(map->pixel(0, y));
+		if(y < windowmin.y || y > windowmax.y)
+		{
+			fill(row, row + xAxes, unsetValue);
+			continue;
+		}
+		for (unsigned x = 0; x < xAxes; ++x)
+		{
+			if(row[x] != unsetValue || x < windowmin.x || x > windowmax.x)
+			{
+				row[x] = unsetValue;
+				continue;
+			}
+			const unsigned w = (y - windowmin.y) * windowWidth + x - windowmin.x;
+			if(transform.within(w, width))
+				row[x] = seedColors[transform.nearest(w)];
+		}
+	}
+}
+
+FitsFile& Contours::writeFits(FitsFile& file, const int mode) const
+{
+	FitsTable table(pixels.size());
+	vector<ColorType>& color = table.column<ColorType>("COLOR");
+	vector<PixLoc>& pixel = table.column<PixLoc>("PIXEL");
+	for (unsigned c = 0; c < colors.size(); ++c)
+	{
+		for (unsigned p = offsets[c]; p < offsets[c + 1]; ++p)
+		{
+			color[p] = colors[c];
+			pixel[p] = PixLoc(pixels[p] % xAxes, pixels[p] / xAxes);
+		}
+	}
+	if(mode & FitsFile::overwrite)
+	{
+		file.resizeTable(pixels.size());
+		file.writeColumns(table, FitsFile::overwrite);
+	}
+	else
+	{
+		file.writeColumns(table);
+	}
+
+	Header header;
+	header.set("MAPNAXI1", xAxes, "Size of the X axes of the map");
+	header.set("MAPNAXI2", yAxes, "Size of the Y axes of the map");
+	return file.writeHeader(header);
+}
+
+FitsFile& Contours::readFits(FitsFile& file)
+{
+	Header header;
+	file.readHeader(header);
+	if(!header.has("MAPNAXI1") || !header.has("MAPNAXI2"))
+	{
+		cerr<<"Error : table is not a table of contours, no MAPNAXI1 or MAPNAXI2 keyword."<<endl;
+		return file;
+	}
+	xAxes = header.get<unsigned>("MAPNAXI1");
+	yAxes = header.get<unsigned>("MAPNAXI2");
+
+	FitsTable table;
+	vector<ColorType>& color = table.column<ColorType>("COLOR");
+	vector<PixLoc>& pixel = table.column<PixLoc>("PIXEL");
+	file.readColumns(table);
+
+	vector<pair<ColorType, unsigned> > contourPixels;
+	contourPixels.reserve(color.size());
+	for (unsigned p = 0; p < color.size() && p < pixel.size(); ++p)
+	{
+		if(pixel[p].x < xAxes && pixel[p].y < yAxes)
+			contourPixels.push_back(make_pair(color[p], pixel[p].y * xAxes + pixel[p].x));
+		else
+			cerr<<"Error : contour pixel "<<p<<" is outside the map."<<endl;
+	}
+	// The contours are sorted by color, in case the table was not written by us
+	stable_sort(contourPixels.begin(), contourPixels.end(), lessColor);
+	setContours(contourPixels);
+	return file;
+}
+
+bool Contours::readCache(const string& mapFilename, const string& tableName)
+{
+	try
+	{
+		// The file is opened at the HDU of the map
+		FitsFile file(mapFilename);
+		const unsigned long mapSum = file.dataSum();
+		if(!file.isGood() || !file.has(tableName))
+			return false;
+		file.moveTo(tableName);
+		Header header;
+		file.readHeader(header);
+		if(!header.has("MAPDSUM") || header.get<unsigned long>("MAPDSUM") != mapSum)
+		{
+			#if defined VERBOSE
+			cout<<"The contours in "<<mapFilename<<" are outdated, they will be recomputed."<<endl;
+			#endif
+			return false;
+		}
+		readFits(file);
+		return file.isGood() && xAxes > 0 && yAxes > 0;
+	}
+	catch(const exception& error)
+	{
+		cerr<<"Error : reading contours from "<<mapFilename<<" : "<<error.what()<<endl;
+		return false;
+	}
+}
+
+bool Contours::writeCache(const string& mapFilename, const string& tableName) const
+{
+	try
+	{
+		FitsFile file(mapFilename, FitsFile::update);
+		const unsigned long mapSum = file.dataSum();
+		if(file.has(tableName))
+		{
+			file.moveTo(tableName);
+			writeFits(file, FitsFile::overwrite);
+		}
+		else
+		{
+			file.writeTable(tableName);
+			writeFits(file);
+		}
+		Header header;
+		header.set("MAPDSUM", mapSum, "Checksum of the data of the map of the contours");
+		file.writeHeader(header);
+		return file.isGood();
+	}
+	catch(const exception& error)
+	{
+		cerr<<"Error : writing contours to "<<mapFilename<<" : "<<error.what()<<endl;
+		return false;
+	}
+}
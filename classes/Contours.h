@@ -0,0 +1,127 @@
+#pragma once
+#ifndef Contours_H
+#define Contours_H
+
+#include <vector>
+
+#include "constants.h"
+#include "Coordinate.h"
+#include "FitsFile.h"
+#include "ColorMap.h"
+#include "DistanceTransform.h"
+
+//! Class that stores the contours of the regions of a ColorMap as lists of pixels
+/*!
+The contour of a region is the list of it's pixels that have a 4 neighbour of a different color.
+The contours are extracted in one pass over the map, and stored region by region, in the order of the pixels.
+
+Once extracted, the contours do not need the map anymore: they can be drawn with a given width,
+painted on another map of the same size, or stored in a fits table and reused for the next frames.
+The width of the contours is drawn with a threshold of the distance transform of the contour pixels,
+computed only on the bounding box of the contours.
+
+The contours are stored in a fits binary table with the columns COLOR and PIXEL, one row per contour pixel.
+The size of the map is stored in the keywords MAPNAXI1 and MAPNAXI2 of the table.
+
+The table can be stored as a cache in the fits file of the map itself (cf. writeCache), together with the checksum of the map data in the keyword MAPDSUM.
+The contours are then read back only if the map has not changed since (cf. readCache).
+*/
+
+class Contours
+{
+	private :
+		//! Size of the X axes of the map
+		unsigned xAxes;
+		//! Size of the Y axes of the map
+		unsigned yAxes;
+		//! Color of each contour
+		std::vector<ColorType> colors;
+		//! Position in pixels of the first pixel of each contour, the last element is the total number of pixels
+		std::vector<unsigned> offsets;
+		//! The pixels of the contours, contour by contour
+		std::vector<unsigned> pixels;
+		//! Lower left corner of the bounding box of all the contours
+		PixLoc boxmin;
+		//! Upper right corner of the bounding box of all the contours
+		PixLoc boxmax;
+
+		//! Order of the contour pixels by color only
+		static bool lessColor(const std::pair<ColorType, unsigned>& a, const std::pair<ColorType, unsigned>& b);
+
+		//! Routine to store the contours from a list of (color, pixel) sorted by color
+		void setContours(const std::vector<std::pair<ColorType, unsigned> >& contourPixels);
+
+		//! Compute the bounding box of the contours enlarged by width, return false if there is no contour
+		bool window(const Real width, PixLoc& windowmin, PixLoc& windowmax) const;
+
+		//! Compute the distance transform of the contour pixels in the window, and the color of the seeds
+		void distances(const PixLoc& windowmin, const PixLoc& windowmax, DistanceTransform& transform, std::vector<ColorType>& seedColors) const;
+
+	public :
+		//! Constructor
+		Contours();
+
+		//! Constructor from a ColorMap, the pixels of color unsetValue are not in a region
+		Contours(const ColorMap* map, const ColorType unsetValue = 0);
+
+		//! Routine to extract the contours of the regions of a ColorMap
+		void extract(const ColorMap* map, const ColorType unsetValue = 0);
+
+		//! Size of the X axes of the map
+		unsigned Xaxes() const
+		{return xAxes;}
+
+		//! Size of the Y axes of the map
+		unsigned Yaxes() const
+		{return yAxes;}
+
+		//! Number of contours
+		unsigned NumberContours() const
+		{return colors.size();}
+
+		//! Color of the contour c
+		ColorType Color(const unsigned c) const
+		{return colors[c];}
+
+		//! Number of pixels of the contour c
+		unsigned NumberPixels(const unsigned c) const
+		{return offsets[c + 1] - offsets[c];}
+
+		//! Position of the pixel p of the contour c
+		PixLoc Pixel(const unsigned c, const unsigned p) const
+		{
+			const unsigned j = pixels[offsets[c] + p];
+			return PixLoc(j % xAxes, j / xAxes);
+		}
+
+		//! Return the pixels of the contour c
+		std::vector<PixLoc> contour(const unsigned c) const;
+
+		//! Routine to paint the contour pixels with their color on a map of the same size
+		void paint(ColorMap* map) const;
+
+		//! Routine to draw the internal contours of the map, with a width of width pixels
+		/*! The map must have the regions of the contours, the pixels of the regions that are further than width of their contour are set to unsetValue */
+		void drawIntern(ColorMap* map, const Real width, const ColorType unsetValue = 0) const;
+
+		//! Routine to draw the external contours of the map, with a width of width pixels
+		/*! The map must have the regions of the contours, the unset pixels at most width of a contour take the color of the nearest contour pixel, the other pixels are set to unsetValue */
+		void drawExtern(ColorMap* map, const Real width, const ColorType unsetValue = 0) const;
+
+		//! Routine to write the contours in the current table of the fits file
+		/*! @param mode Possible value is FitsFile::overwrite, to replace the contours already in the table */
+		FitsFile& writeFits(FitsFile& file, const int mode = 0) const;
+
+		//! Routine to read the contours from the current table of the fits file
+		FitsFile& readFits(FitsFile& file);
+
+		//! Routine to read the contours stored in the table tableName of the fits file of the map
+		/*! @return false if there is no such table, or if the map has changed since the contours were stored */
+		bool readCache(const std::string& mapFilename, const std::string& tableName = "Contours");
+
+		//! Routine to store the contours in the table tableName of the fits file of the map
+		/*! The contours must have been extracted from the map as it is in the file */
+		bool writeCache(const std::string& mapFilename, const std::string& tableName = "Contours") const;
+};
+
+#endif
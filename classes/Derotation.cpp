@@ -0,0 +1,161 @@
+#include <cmath>
+#include "Derotation.h"
+#include "SunImage.h"
+
+using namespace std;
+
+const unsigned Derotation::tableSize;
+
+Derotation::Derotation(const WCS& from, const WCS& to, const unsigned xAxes, const unsigned yAxes)
+:from(from), to(to), delta_t(int(difftime(to.time_obs, from.time_obs)))
+{
+	init(xAxes, yAxes);
+}
+
+Derotation::Derotation(const WCS& wcs, const int delta_t, const unsigned xAxes, const unsigned yAxes)
+:from(wcs), to(wcs), delta_t(delta_t)
+{
+	init(xAxes, yAxes);
+}
+
+void Derotation::init(const unsigned xAxes, const unsigned yAxes)
+{
+	// The shift in longitude, and the difference of the longitude of the observers, by the square of the sine of the latitude
+	cos_shift.resize(tableSize + 1);
+	sin_shift.resize(tableSize + 1);
+	for (unsigned i = 0; i <= tableSize; ++i)
+	{
+		const double shift = delta_t * SunDifferentialAngularSpeedSquaredSine(Real(i) / tableSize) + from.l0 - to.l0;
+		cos_shift[i] = cos(shift);
+		sin_shift[i] = sin(shift);
+	}
+
+	// The helioprojective coordinates of the pixel (x, y) are x * cd[.][0] + y * cd[.][1] - (sun_center.x * cd[.][0] + sun_center.y * cd[.][1])
+	cos_columnx.resize(xAxes);
+	sin_columnx.resize(xAxes);
+	cos_columny.resize(xAxes);
+	sin_columny.resize(xAxes);
+	for (unsigned x = 0; x < xAxes; ++x)
+	{
+		const double columnx = x * double(from.cd[0][0]) * ARCSEC2RADIAN;
+		const double columny = x * double(from.cd[1][0]) * ARCSEC2RADIAN;
+		cos_columnx[x] = cos(columnx);
+		sin_columnx[x] = sin(columnx);
+		cos_columny[x] = cos(columny);
+		sin_columny[x] = sin(columny);
+	}
+	cos_rowx.resize(yAxes);
+	sin_rowx.resize(yAxes);
+	cos_rowy.resize(yAxes);
+	sin_rowy.resize(yAxes);
+	for (unsigned y = 0; y < yAxes; ++y)
+	{
+		const double rowx = (y * double(from.cd[0][1]) - (from.sun_center.x * double(from.cd[0][0]) + from.sun_center.y * double(from.cd[0][1]))) * ARCSEC2RADIAN;
+		const double rowy = (y * double(from.cd[1][1]) - (from.sun_center.x * double(from.cd[1][0]) + from.sun_center.y * double(from.cd[1][1]))) * ARCSEC2RADIAN;
+		cos_rowx[y] = cos(rowx);
+		sin_rowx[y] = sin(rowx);
+		cos_rowy[y] = cos(rowy);
+		sin_rowy[y] = sin(rowy);
+	}
+}
+
+/*!
+Same as SunImage::toHCC(const HPC&), followed by derotateHCC.
+*/
+RealPixLoc Derotation::derotateHPC(const double cosx, const double sinx, const double cosy, const double siny) const
+{
+	// We compute the dist between the sun observer and the surface of the sun
+	const double q = from.dsun_obs * cosy * cosx;
+	double dist = (q*q) - (from.dsun_obs * from.dsun_obs) + (from.sunradius_Mm * from.sunradius_Mm);
+	if (dist < 0)
+		return RealPixLoc::null();
+	dist = q - sqrt(dist);
+	return derotateHCC(dist * cosy * sinx, dist * siny, from.dsun_obs - (dist * cosy * cosx));
+}
+
+/*!
+Same as SunImage::toHGS(const HCC&), the shift of the longitude, and SunImage::toRealPixLoc(const HGS&) of the map to.
+The latitude is only used by it's sine, that is the argument of the asin, and by it's cosine.
+The cosine and sine of the longitude are computed from the arguments of the atan2, and rotated by the shift in the table.
+*/
+RealPixLoc Derotation::derotateHCC(const double hccx, const double hccy, const double hccz) const
+{
+	// Like in SunImage::toHGS, the latitude is at most PI/2
+	double sin_latitude = (hccy * from.cos_b0 + hccz * from.sin_b0) / from.sunradius_Mm;
+	if(sin_latitude > 1)
+		sin_latitude = 1;
+	else if(sin_latitude < -1)
+		sin_latitude = -1;
+	const double sin_latitude_squared = sin_latitude * sin_latitude;
+
+	// The derotated location must be on the visible side of the sun
+	const double longitudex = hccx;
+	const double longitudez = hccz * from.cos_b0 - hccy * from.sin_b0;
+	const double longitude = atan2(longitudex, longitudez) + from.l0 + delta_t * SunDifferentialAngularSpeedSquaredSine(sin_latitude_squared);
+	if(longitude > MIPI || longitude < -MIPI)
+		return RealPixLoc::null();
+
+	// We interpolate the shift in the table
+	const double position = sin_latitude_squared * tableSize;
+	const unsigned i = position < tableSize ? unsigned(position) : tableSize - 1;
+	const double weight = position - i;
+	const double cos_shift_i = cos_shift[i] + weight * (cos_shift[i + 1] - cos_shift[i]);
+	const double sin_shift_i = sin_shift[i] + weight * (sin_shift[i + 1] - sin_shift[i]);
+
+	// We rotate the longitude by the shift
+	const double norm = sqrt(longitudex * longitudex + longitudez * longitudez);
+	const double cos_original = norm > 0 ? longitudez / norm : 1;
+	const double sin_original = norm > 0 ? longitudex / norm : 0;
+	const double cos_longitude = cos_original * cos_shift_i - sin_original * sin_shift_i;
+	const double sin_longitude = sin_original * cos_shift_i + cos_original * sin_shift_i;
+	const double cos_latitude = sqrt(1 - sin_latitude_squared);
+
+	// We convert to the heliocentric cartesian coordinates of the map to
+	const double x = to.sunradius_Mm * cos_latitude * sin_longitude;
+	const double y = to.sunradius_Mm * (sin_latitude * to.cos_b0 - cos_latitude * cos_longitude * to.sin_b0);
+	const double z = to.sunradius_Mm * (sin_latitude * to.sin_b0 + cos_latitude * cos_longitude * to.cos_b0);
+
+	// We convert to the helioprojective coordinates, and to the pixel location of the map to
+	const double zeta = to.dsun_obs - z;
+	const double distance = sqrt(x * x + y * y + zeta * zeta);
+	const double hpcx = atan2(x, zeta) * RADIAN2ARCSEC;
+	const double hpcy = asin(y / distance) * RADIAN2ARCSEC;
+	return RealPixLoc(hpcx * to.icd[0][0] + hpcy * to.icd[0][1] + to.sun_center.x, hpcx * to.icd[1][0] + hpcy * to.icd[1][1] + to.sun_center.y);
+}
+
+RealPixLoc Derotation::derotate(const RealPixLoc& c) const
+{
+	if(!c)
+		return RealPixLoc::null();
+	// Same as SunImage::toHPC
+	const Real rx = (c.x - from.sun_center.x);
+	const Real ry = (c.y - from.sun_center.y);
+	const double hpcx = (rx * from.cd[0][0] + ry * from.cd[0][1]) * ARCSEC2RADIAN;
+	const double hpcy = (rx * from.cd[1][0] + ry * from.cd[1][1]) * ARCSEC2RADIAN;
+	return derotateHPC(cos(hpcx), sin(hpcx), cos(hpcy), sin(hpcy));
+}
+
+RealPixLoc Derotation::derotate(const unsigned x, const unsigned y) const
+{
+	if(x >= cos_columnx.size() || y >= cos_rowx.size())
+		return derotate(RealPixLoc(x, y));
+	// The angles of the column and of the row are added with the angle sum identities
+	const double cosx = cos_columnx[x] * cos_rowx[y] - sin_columnx[x] * sin_rowx[y];
+	const double sinx = sin_columnx[x] * cos_rowx[y] + cos_columnx[x] * sin_rowx[y];
+	const double cosy = cos_columny[x] * cos_rowy[y] - sin_columny[x] * sin_rowy[y];
+	const double siny = sin_columny[x] * cos_rowy[y] + cos_columny[x] * sin_rowy[y];
+	return derotateHPC(cosx, sinx, cosy, siny);
+}
+
+void Derotation::derotateRow(const unsigned y, const unsigned xmin, const unsigned xmax, RealPixLoc* positions) const
+{
+	// The pixels of a row are independent, so the compiler is free to interleave them
+	for (unsigned x = xmin; x <= xmax; ++x)
+		positions[x - xmin] = derotate(x, y);
+}
+
+void Derotation::derotate(vector<RealPixLoc>& positions) const
+{
+	for (unsigned p = 0; p < positions.size(); ++p)
+		positions[p] = derotate(positions[p]);
+}
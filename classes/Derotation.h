@@ -0,0 +1,87 @@
+#pragma once
+#ifndef Derotation_H
+#define Derotation_H
+
+#include <vector>
+
+#include "constants.h"
+#include "Coordinate.h"
+#include "WCS.h"
+
+//! Class that derotates the pixel locations of a map into another map, for the differential rotation of the sun between their observation times
+/*!
+It gives the same locations as SunImage::shift_like, without the complete conversion to heliographic coordinates and back for every pixel.
+
+For a given delta t, the shift in longitude depends only on the latitude, so the cosine and sine of the shift are precomputed in a table,
+by the square of the sine of the latitude, and linearly interpolated.
+The latitude is then only needed by it's sine and cosine, and the longitude by it's cosine and sine, that are computed without trigonometric functions.
+
+The helioprojective coordinates are linear in the pixel location, so the cosine and sine of their part that depends on the column, and of their part that depends on the row,
+are precomputed for the columns and the rows of the map, and combined with the angle sum identities.
+A pixel then needs only 3 inverse trigonometric functions instead of 13 trigonometric functions.
+
+The tables only depend on the WCS of the maps, so a Derotation can be shared by the threads, and reused for all the regions of 2 maps.
+
+Example:
+@code
+Derotation derotation(image2->getWCS(), image1->getWCS(), image2->Xaxes(), image2->Yaxes());
+RealPixLoc c1 = derotation.derotate(x2, y2);
+@endcode
+*/
+
+class Derotation
+{
+	public :
+		//! Number of intervals of the table of the shift in longitude
+		static const unsigned tableSize = 1024;
+
+	private :
+		//! The WCS of the map of the locations to derotate
+		WCS from;
+		//! The WCS of the map to derotate the locations into
+		WCS to;
+		//! The number of seconds between the maps
+		int delta_t;
+		//! Cosine and sine of the shift in longitude plus the difference of l0, by the square of the sine of the latitude
+		std::vector<double> cos_shift, sin_shift;
+		//! Cosine and sine of the part of the helioprojective x and y coordinates that depends on the column
+		std::vector<double> cos_columnx, sin_columnx, cos_columny, sin_columny;
+		//! Cosine and sine of the part of the helioprojective x and y coordinates that depends on the row
+		std::vector<double> cos_rowx, sin_rowx, cos_rowy, sin_rowy;
+
+		//! Routine to compute the tables
+		void init(const unsigned xAxes, const unsigned yAxes);
+
+		//! Routine to derotate a helioprojective coordinate of the map from, given by the cosine and sine of it's angles, into a pixel location of the map to
+		RealPixLoc derotateHPC(const double cosx, const double sinx, const double cosy, const double siny) const;
+
+		//! Routine to derotate a heliocentric cartesian coordinate of the map from, into a pixel location of the map to
+		RealPixLoc derotateHCC(const double hccx, const double hccy, const double hccz) const;
+
+	public :
+		//! Constructor, to derotate the locations of the map with the WCS from into the map with the WCS to
+		/*! The tables of the pixels are computed for xAxes columns and yAxes rows */
+		Derotation(const WCS& from, const WCS& to, const unsigned xAxes = 0, const unsigned yAxes = 0);
+
+		//! Constructor, to rotate the locations of the map with the WCS wcs by delta_t seconds
+		Derotation(const WCS& wcs, const int delta_t, const unsigned xAxes = 0, const unsigned yAxes = 0);
+
+		//! The number of seconds of the derotation
+		int DeltaT() const
+		{return delta_t;}
+
+		//! Routine to derotate a location, return the null location if it is not on the sun or not visible after the derotation
+		RealPixLoc derotate(const RealPixLoc& c) const;
+
+		//! Routine to derotate the location of a pixel, using the tables of the pixels if the pixel is in the tables
+		RealPixLoc derotate(const unsigned x, const unsigned y) const;
+
+		//! Routine to derotate the pixels from xmin to xmax (included) of the row y
+		/*! The location of the pixel x is stored in positions[x - xmin] */
+		void derotateRow(const unsigned y, const unsigned xmin, const unsigned xmax, RealPixLoc* positions) const;
+
+		//! Routine to derotate a set of locations (e.g. the corners of boxes, or the centers of regions)
+		void derotate(std::vector<RealPixLoc>& positions) const;
+};
+
+#endif
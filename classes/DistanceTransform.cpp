@@ -0,0 +1,100 @@
+#include "DistanceTransform.h"
+
+using namespace std;
+
+const unsigned DistanceTransform::infinity;
+
+DistanceTransform::DistanceTransform(const unsigned xAxes, const unsigned yAxes)
+:xAxes(xAxes), yAxes(yAxes), distances(xAxes * yAxes, infinity), nearests(xAxes * yAxes, 0)
+{}
+
+void DistanceTransform::clear()
+{
+	distances.assign(xAxes * yAxes, infinity);
+}
+
+void DistanceTransform::compute()
+{
+	// First pass: for each column we compute the distance to the nearest seed in the column
+	// The distance is stored in distances, and the y of the seed in nearests
+	for(unsigned x = 0; x < xAxes; ++x)
+	{
+		// Distance to the previous seed
+		unsigned last = infinity;
+		for(unsigned y = 0, j = x; y < yAxes; ++y, j += xAxes)
+		{
+			if(distances[j] == 0)
+			{
+				last = y;
+				nearests[j] = y;
+			}
+			else if(last != infinity)
+			{
+				distances[j] = y - last;
+				nearests[j] = last;
+			}
+		}
+		// Distance to the next seed
+		last = infinity;
+		for(unsigned y = yAxes, j = x + (yAxes - 1) * xAxes; y > 0; j -= xAxes)
+		{
+			--y;
+			if(distances[j] == 0)
+			{
+				last = y;
+			}
+			else if(last != infinity && last - y < distances[j])
+			{
+				distances[j] = last - y;
+				nearests[j] = last;
+			}
+		}
+	}
+
+	// Second pass: for each row we compute the lower envelope of the parabolas (x - q)^2 + f(q)
+	// where f(q) is the squared distance to the nearest seed in column q
+	vector<unsigned> f(xAxes), seed_y(xAxes);
+	// The columns of the parabolas of the envelope, and their left boundary
+	vector<unsigned> v(xAxes);
+	vector<double> z(xAxes);
+	for(unsigned y = 0; y < yAxes; ++y)
+	{
+		unsigned* row_distances = &(distances[y * xAxes]);
+		unsigned* row_nearests = &(nearests[y * xAxes]);
+		int k = -1;
+		for(unsigned q = 0; q < xAxes; ++q)
+		{
+			if(row_distances[q] == infinity)
+			{
+				f[q] = infinity;
+				continue;
+			}
+			f[q] = row_distances[q] * row_distances[q];
+			seed_y[q] = row_nearests[q];
+			double s = 0;
+			while(k >= 0)
+			{
+				s = ((double(f[q]) + double(q) * q) - (double(f[v[k]]) + double(v[k]) * v[k])) / (2. * (double(q) - v[k]));
+				if(s <= z[k])
+					--k;
+				else
+					break;
+			}
+			++k;
+			v[k] = q;
+			z[k] = k == 0 ? -numeric_limits<double>::max() : s;
+		}
+		// There is no seed in the whole image
+		if(k < 0)
+			continue;
+		for(unsigned x = 0, e = 0; x < xAxes; ++x)
+		{
+			while(int(e) < k && z[e + 1] < x)
+				++e;
+			unsigned q = v[e];
+			unsigned dx = x > q ? x - q : q - x;
+			row_distances[x] = dx * dx + f[q];
+			row_nearests[x] = seed_y[q] * xAxes + q;
+		}
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef DistanceTransform_H
+#define DistanceTransform_H
+
+#include <vector>
+#include <limits>
+
+#include "constants.h"
+
+//! Class that computes the exact euclidean distance transform of a set of seed pixels
+/*!
+For each pixel of the image, the transform gives the squared euclidean distance to the nearest seed pixel, and the position of that seed.
+
+It uses the separable algorithm of Felzenszwalb and Huttenlocher: a first pass computes for each column the distance to the nearest seed in the column,
+a second pass computes for each row the lower envelope of the parabolas centered on the pixels of the row.
+Both passes are linear, so the cost does not depend on the distance, contrary to stamping a disc on every pixel.
+
+A morphological operation with a disc of radius r is then a simple threshold of the distance, e.g. the dilation of a map is the set of pixels at distance <= r of a seed,
+and the position of the nearest seed gives the color of the dilated pixel.
+
+Example:
+@code
+DistanceTransform transform(xAxes, yAxes);
+for(unsigned j = 0; j < numberPixels; ++j)
+	if(pixels[j] != 0)
+		transform.setSeed(j);
+transform.compute();
+for(unsigned j = 0; j < numberPixels; ++j)
+	if(transform.within(j, radius))
+		pixels[j] = pixels[transform.nearest(j)];
+@endcode
+*/
+
+class DistanceTransform
+{
+	public :
+		//! Squared distance of the pixels when there is no seed
+		static const unsigned infinity = std::numeric_limits<unsigned>::max();
+
+	private :
+		//! Size of the X axes of the image
+		unsigned xAxes;
+		//! Size of the Y axes of the image
+		unsigned yAxes;
+		//! The squared distance of each pixel to the nearest seed
+		std::vector<unsigned> distances;
+		//! The position of the nearest seed of each pixel
+		std::vector<unsigned> nearests;
+
+	public :
+		//! Constructor, there is no seed
+		DistanceTransform(const unsigned xAxes, const unsigned yAxes);
+
+		//! Routine to remove all the seeds
+		void clear();
+
+		//! Routine to set the pixel j as a seed
+		void setSeed(const unsigned j)
+		{
+			distances[j] = 0;
+		}
+
+		//! Routine to compute the distance transform of the seeds
+		void compute();
+
+		//! Return the squared distance of the pixel j to the nearest seed, or infinity if there is no seed
+		unsigned squaredDistance(const unsigned j) const
+		{
+			return distances[j];
+		}
+
+		//! Return the position of the nearest seed of pixel j
+		/*! Only meaningfull if the squaredDistance is not infinity */
+		unsigned nearest(const unsigned j) const
+		{
+			return nearests[j];
+		}
+
+		//! Test if the pixel j is at a distance of at most radius of a seed
+		bool within(const unsigned j, const Real radius) const
+		{
+			return distances[j] != infinity && Real(distances[j]) <= radius * radius;
+		}
+};
+
+#endif
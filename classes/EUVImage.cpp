@@ -94,6 +94,14 @@ void EUVImage::fillHeader()
 	SunImage<EUVPixelType>::fillHeader();
 }
 
+FitsFile& EUVImage::writeQuantizedFits(FitsFile& file, const Real min, const Real max, const unsigned bits, int mode, const string imagename)
+{
+	fillHeader();
+	file.writeQuantizedImage(pixels, xAxes, yAxes, min, max, bits, mode, imagename);
+	file.writeHeader(header);
+	return file;
+}
+
 inline string EUVImage::Channel() const
 {
 	return Instrument() + "_" + toString(int(Wavelength()));
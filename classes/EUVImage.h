@@ -84,6 +84,10 @@ class EUVImage : public SunImage<EUVPixelType>
 		//! Routine to set the ALC parameters
 		virtual void setALCParameters(std::vector<Real> ALCParameters);
 
+		//! Routine to write the image quantized on 8 or 16 bits
+		/*! The values between min and max are mapped linearly to integers (cf. FitsFile::writeQuantizedImage) */
+		FitsFile& writeQuantizedFits(FitsFile& file, const Real min, const Real max, const unsigned bits = 16, int mode = 0, const std::string imagename = "");
+		
 		//! Routine to do image preprocessing
 		void preprocessing(const std::string& preprocessingList);
 		
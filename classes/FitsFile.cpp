@@ -52,7 +52,14 @@ void FitsFile::open(const string& filename, const int mode)
 		else
 		{
 			int iomode = mode & update ? READWRITE : READONLY;
-			if (fits_open_image(&fptr, filename.c_str(), iomode, &status))
+			// If the file contains no image (e.g. a map stored as a table of runs), we open it at the first table
+			if (fits_open_image(&fptr, filename.c_str(), iomode, &status) && status == NOT_IMAGE)
+			{
+				status = 0;
+				fptr = NULL;
+				fits_open_data(&fptr, filename.c_str(), iomode, &status);
+			}
+			if (status)
 			{
 				fits_get_errstatus(status, error_message);
 				fptr = NULL;
@@ -112,6 +119,23 @@ FitsFile& FitsFile::moveTo(const string& extension_name)
 
 }
 
+bool FitsFile::isTable()
+{
+	int hdutype = get_CHDU_type();
+	return hdutype == BINARY_TBL || hdutype == ASCII_TBL;
+}
+
+unsigned long FitsFile::dataSum()
+{
+	unsigned long datasum = 0, hdusum = 0;
+	if (fits_get_chksum(fptr, &datasum, &hdusum, &status))
+	{
+		cerr<<"Error : computing checksum of the data in file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+	}
+	return datasum;
+}
+
 bool FitsFile::has(const string& extension_name)
 {
 	// We save the current_hdu
@@ -225,6 +249,29 @@ string FitsFile::getFormat(int datatype)
 }
 
 
+// Return the number of bits of the integer values an image of type bitpix can store
+static int bitpixRange(const int bitpix)
+{
+	switch(bitpix)
+	{
+		case 0:
+			return 0;
+		case BYTE_IMG:
+		case SBYTE_IMG:
+			return 8;
+		case SHORT_IMG:
+			return 15;
+		case USHORT_IMG:
+			return 16;
+		case LONG_IMG:
+			return 31;
+		case ULONG_IMG:
+			return 32;
+		default:
+			return 64;
+	}
+}
+
 int FitsFile::getBitpix(int datatype)
 {
 	int bitpix;
@@ -345,7 +392,11 @@ FitsFile& FitsFile::readHeader(Header& header)
 				size_t endpos = cleanValue.find_last_not_of("' \t");
 				if((startpos != string::npos) && (endpos != string::npos))
 				{
-					header.set(key,cleanValue.substr(startpos, endpos-startpos+1), comment);
+					// A quoted value is a string, even if it looks like a number or a logical
+					if(value[0] == '\'')
+						header.setString(key,cleanValue.substr(startpos, endpos-startpos+1), comment);
+					else
+						header.set(key,cleanValue.substr(startpos, endpos-startpos+1), comment);
 				}
 			}
 		}
@@ -354,9 +405,9 @@ FitsFile& FitsFile::readHeader(Header& header)
 		status = 0;
 	#if defined VERBOSE
 	cout<<"Header for file "<<filename<<endl;
-	for ( map<string,string>::iterator i = header.begin(); i != header.end(); ++i )
+	for ( Header::const_iterator i = header.begin(); i != header.end(); ++i )
 	{
-		cout<<setw(8)<<left<<i->first<<": "<<i->second<<endl;
+		cout<<setw(8)<<left<<i->key<<": "<<i->value<<endl;
 	}
 	#endif
 	return *this;
@@ -378,52 +429,40 @@ FitsFile& FitsFile::writeHeader(const Header& header)
 	}
 	for ( Header::const_iterator i = header.begin(); i != header.end(); ++i )
 	{
-		string comment = header.comment(i->first);
-		// To avoid cfitsio to put quotes around values (why does it do it in the first place ???) we have to know if the value is a number or not
-		// We cannot use fits_get_keytype to determine the type of the value because it is bugged
-		if(i->second.find_first_not_of(" \t") == string::npos)
+		char* comment = const_cast<char *>(i->comment.c_str());
+		// The type of the value has already been determined by the header
+		// To avoid cfitsio to put quotes around numbers, we must write them with their type
+		switch(i->type)
 		{
-			// The value is all white
-			if(fits_update_key_null(fptr, i->first.c_str(), const_cast<char *>(comment.c_str()), &status))
+			case Header::EMPTY:
+				fits_update_key_null(fptr, i->key.c_str(), comment, &status);
+				break;
+			case Header::INTEGER:
 			{
-				cerr<<"Error : writing keyword "<<i->first<<" to file "<<filename<<" :"<< status <<endl;
-				fits_report_error(stderr, status);
-				status = 0;
+				long value = i->integer;
+				fits_update_key(fptr, TLONG, i->key.c_str(), &value, comment, &status);
+				break;
 			}
-		}
-		else if(i->second.find_first_not_of(" \t0123456789.-") != string::npos)
-		{
-			// It is a string
-			if(fits_update_key(fptr, TSTRING, i->first.c_str(), const_cast<char *>(i->second.c_str()), const_cast<char *>(comment.c_str()), &status))
+			case Header::REAL:
 			{
-				cerr<<"Error : writing keyword "<<i->first<<" to file "<<filename<<" :"<< status <<endl;
-				fits_report_error(stderr, status);
-				status = 0;
+				double value = i->real;
+				fits_update_key(fptr, TDOUBLE, i->key.c_str(), &value, comment, &status);
+				break;
 			}
-		}
-		else if(i->second.find_first_of(".") == string::npos)
-		{
-			//It is probably a integer
-			int value = toInt(i->second);
-			if(fits_update_key(fptr, TINT, i->first.c_str(), &value, const_cast<char *>(comment.c_str()), &status))
+			case Header::LOGICAL:
 			{
-				cerr<<"Error : writing keyword "<<i->first<<" to file "<<filename<<" :"<< status <<endl;
-				fits_report_error(stderr, status);
-				status = 0;
+				int value = i->integer;
+				fits_update_key(fptr, TLOGICAL, i->key.c_str(), &value, comment, &status);
+				break;
 			}
-		
+			default:
+				fits_update_key(fptr, TSTRING, i->key.c_str(), const_cast<char *>(i->value.c_str()), comment, &status);
 		}
-		else
+		if(status)
 		{
-			//It is probably a double
-			double value = toDouble(i->second);
-			if(fits_update_key(fptr, TDOUBLE, i->first.c_str(), &value, const_cast<char *>(comment.c_str()), &status))
-			{
-				cerr<<"Error : writing keyword "<<i->first<<" to file "<<filename<<" :"<< status <<endl;
-				fits_report_error(stderr, status);
-				status = 0;
-			}
-		
+			cerr<<"Error : writing keyword "<<i->key<<" to file "<<filename<<" :"<< status <<endl;
+			fits_report_error(stderr, status);
+			status = 0;
 		}
 	}
 	return *this;
@@ -553,7 +592,7 @@ FitsFile& FitsFile::readImage(T*& image, unsigned &X, unsigned& Y, T* null)
 
 
 template<class T>
-FitsFile& FitsFile::writeImage(T* image, const unsigned X, const unsigned Y, int mode, const string name)
+FitsFile& FitsFile::writeImage(T* image, const unsigned X, const unsigned Y, int mode, const string name, int bitpix)
 {
 	if (isClosed())
 	{
@@ -577,7 +616,8 @@ FitsFile& FitsFile::writeImage(T* image, const unsigned X, const unsigned Y, int
 	}
 	
 	//We determine bitpix so we write with the correct type
-	int bitpix = getBitpix(datatype);
+	if(bitpix == 0)
+		bitpix = getBitpix(datatype);
 
 	// We get the axes from the image
 	long axes[2];
@@ -651,6 +691,77 @@ FitsFile& FitsFile::writeImage(T* image, const unsigned X, const unsigned Y, int
 			cerr<<"Warning : possible image parameter mismatch while updating image in file "<<filename<<endl;
 			#endif
 		}
+		// If the image in the file cannot store the values of the requested bitpix, we promote it
+		int equivalent_bitpix = cbitpix;
+		fits_get_img_equivtype(fptr, &equivalent_bitpix, &status);
+		if(bitpixRange(equivalent_bitpix) < bitpixRange(bitpix))
+		{
+			#if defined DEBUG
+			cout<<"Promoting image in file "<<filename<<" from bitpix "<<equivalent_bitpix<<" to "<<bitpix<<endl;
+			#endif
+			if(fits_is_compressed_image(fptr, &status))
+			{
+				// A compressed image cannot be resized, so we replace it
+				// The keywords that do not describe the image itself (e.g. EXTNAME, COMMENT or HISTORY) are copied to the new image
+				vector<string> cards;
+				int numberKeywords = 0;
+				if(fits_get_hdrspace(fptr, &numberKeywords, NULL, &status))
+				{
+					cerr<<"Error : reading the number of keywords from file "<<filename<<" :"<< status <<endl;
+					fits_report_error(stderr, status);
+					status = 0;
+				}
+				char card[FLEN_CARD];
+				for(int k = 1; k <= numberKeywords; ++k)
+				{
+					if(fits_read_record(fptr, k, card, &status))
+					{
+						cerr<<"Error reading keyword from file "<<filename<<" :"<< status <<endl;
+						fits_report_error(stderr, status);
+						status = 0;
+						continue;
+					}
+					int keyword_class = fits_get_keyclass(card);
+					if(keyword_class != TYP_STRUC_KEY && keyword_class != TYP_CMPRS_KEY && keyword_class != TYP_SCAL_KEY && keyword_class != TYP_NULL_KEY && keyword_class != TYP_CKSUM_KEY)
+						cards.push_back(card);
+				}
+				int hdu_number = 1;
+				fits_get_hdu_num(fptr, &hdu_number);
+				if(fits_delete_hdu(fptr, NULL, &status) || fits_movabs_hdu(fptr, hdu_number - 1, NULL, &status))
+				{
+					cerr<<"Error : could not replace image in file "<<filename<<" :"<< status <<endl;
+					fits_report_error(stderr, status);
+					return *this;
+				}
+				if(fits_set_compression_type(fptr, RICE_1, &status))
+				{
+					cerr<<"Error : could not set image compression :"<< status <<endl;
+					fits_report_error(stderr, status);
+					status = 0;
+				}
+				if(fits_insert_img(fptr, bitpix, naxis, axes, &status))
+				{
+					cerr<<"Error : creating image in file "<<filename<<" :"<< status <<endl;
+					fits_report_error(stderr, status);
+					return *this;
+				}
+				for(unsigned c = 0; c < cards.size(); ++c)
+				{
+					if(fits_write_record(fptr, cards[c].c_str(), &status))
+					{
+						cerr<<"Error : writing keyword "<<cards[c]<<" to file "<<filename<<" :"<< status <<endl;
+						fits_report_error(stderr, status);
+						status = 0;
+					}
+				}
+			}
+			else if(fits_resize_img(fptr, bitpix, naxis, axes, &status))
+			{
+				cerr<<"Error : could not promote image in file "<<filename<<" to bitpix "<<bitpix<<" :"<< status <<endl;
+				fits_report_error(stderr, status);
+				return *this;
+			}
+		}
 	}
 	else
 	{
@@ -694,6 +805,168 @@ FitsFile& FitsFile::writeImage(T* image, const unsigned X, const unsigned Y, int
 }
 
 
+FitsFile& FitsFile::writeQuantizedImage(const Real* image, const unsigned X, const unsigned Y, const Real min, const Real max, const unsigned bits, int mode, const string name)
+{
+	if (isClosed())
+	{
+		cerr<<"Error writing image, "<<filename<<" is closed"<<endl;
+		return *this;
+	}
+	if(!isGood())
+	{
+		cerr<<"Error "<<filename<<" is not good"<<endl;
+		return *this;
+	}
+	if(bits != 8 && bits != 16)
+	{
+		cerr<<"Error : cannot quantize image on "<<bits<<" bits, only 8 or 16 bits are possible"<<endl;
+		return *this;
+	}
+	
+	// One integer value is kept for the BLANK
+	int bitpix;
+	short lowest, highest, blank;
+	if(bits == 8)
+	{
+		bitpix = BYTE_IMG;
+		lowest = 0;
+		highest = 254;
+		blank = 255;
+	}
+	else
+	{
+		bitpix = SHORT_IMG;
+		lowest = -32767;
+		highest = 32767;
+		blank = -32768;
+	}
+	double scale = max > min ? (max - min) / (highest - lowest) : 1;
+	double zero = min - lowest * scale;
+	
+	// We quantize the pixels
+	unsigned numberPixels = X*Y;
+	vector<short> values(numberPixels);
+	for (unsigned j = 0; j < numberPixels; ++j)
+	{
+		if(! isfinite(image[j]))
+			values[j] = blank;
+		else if(image[j] <= min)
+			values[j] = lowest;
+		else if(image[j] >= max)
+			values[j] = highest;
+		else
+			values[j] = short(floor((image[j] - zero) / scale + 0.5));
+	}
+	
+	if(mode & compress)
+	{
+		if ( fits_set_compression_type(fptr, RICE_1, &status) )
+		{
+			cerr<<"Error : could not set image compression :"<< status <<endl;
+			fits_report_error(stderr, status);
+			status = 0;
+		}
+	}
+	long axes[2];
+	axes[0] = X;
+	axes[1] = Y;
+	if(fits_create_img(fptr, bitpix, 2, axes, &status))
+	{
+		cerr<<"Error : creating image in file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+		return *this;
+	}
+	
+	// The pixels are already quantized, so cfitsio must not scale them
+	long blank_value = blank;
+	if(fits_update_key(fptr, TDOUBLE, "BSCALE", &scale, NULL, &status) || fits_update_key(fptr, TDOUBLE, "BZERO", &zero, NULL, &status) || fits_update_key(fptr, TLONG, "BLANK", &blank_value, NULL, &status) || fits_set_bscale(fptr, 1., 0., &status))
+	{
+		cerr<<"Error : writing scaling keywords to file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+		return *this;
+	}
+	
+	if ( fits_write_img(fptr, TSHORT, 1, numberPixels, &(values[0]), &status) )
+	{
+		cerr<<"Error : writing pixels to file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+		return *this;
+	}
+	if(! name.empty())
+	{
+		if(fits_update_key(fptr, TSTRING, "EXTNAME", const_cast<char *>(name.c_str()), NULL, &status))
+		{
+			cerr<<"Error : setting image name to file "<<filename<<" :"<< status <<endl;
+			fits_report_error(stderr, status);
+			status = 0;
+		}
+	}
+	return *this;
+}
+
+FitsFile& FitsFile::readQuantizedImage(vector<short>& values, unsigned &X, unsigned& Y, Real& scale, Real& zero, short& blank)
+{
+	if (isClosed())
+	{
+		cerr<<"Error reading image, "<<filename<<" is closed"<<endl;
+		return *this;
+	}
+	if(!isGood())
+	{
+		cerr<<"Error "<<filename<<" is not good"<<endl;
+		return *this;
+	}
+	
+	int bitpix, naxis;
+	long axes[2];
+	if (fits_get_img_param(fptr, 2, &bitpix, &naxis, axes, &status))
+	{
+		cerr<<"Error : reading image parameters from file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+		return *this;
+	}
+	if(naxis != 2 || (bitpix != BYTE_IMG && bitpix != SHORT_IMG))
+	{
+		cerr<<"Error : image is not a 2D image of 8 or 16 bits integers"<<endl;
+		return *this;
+	}
+	X = axes[0];
+	Y = axes[1];
+	
+	// We read the scaling, and then we disable it to get the quantized values
+	double bscale = 1, bzero = 0;
+	long blank_value = bitpix == BYTE_IMG ? 255 : -32768;
+	int temp_status = 0;
+	fits_read_key(fptr, TDOUBLE, "BSCALE", &bscale, NULL, &temp_status);
+	temp_status = 0;
+	fits_read_key(fptr, TDOUBLE, "BZERO", &bzero, NULL, &temp_status);
+	temp_status = 0;
+	fits_read_key(fptr, TLONG, "BLANK", &blank_value, NULL, &temp_status);
+	scale = bscale;
+	zero = bzero;
+	blank = short(blank_value);
+	if(fits_set_bscale(fptr, 1., 0., &status))
+	{
+		cerr<<"Error : disabling scaling for file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+		return *this;
+	}
+	
+	unsigned numberPixels = X * Y;
+	values.resize(numberPixels);
+	int anynull;
+	if (numberPixels > 0 && fits_read_img(fptr, TSHORT, 1, numberPixels, NULL, &(values[0]), &anynull, &status))
+	{
+		cerr<<"Error : reading image from file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+	}
+	
+	// We restore the scaling for the next reads
+	temp_status = 0;
+	fits_set_bscale(fptr, bscale, bzero, &temp_status);
+	return *this;
+}
+
 FitsFile& FitsFile::writeTable(const string &name, const unsigned number_rows)
 {
 	if (isClosed())
@@ -717,6 +990,38 @@ FitsFile& FitsFile::writeTable(const string &name, const unsigned number_rows)
 	return *this;
 }
 
+FitsFile& FitsFile::resizeTable(const unsigned number_rows)
+{
+	if (isClosed())
+	{
+		cerr<<"Error resizing table, "<<filename<<" is closed"<<endl;
+		return *this;
+	}
+	if(!isGood())
+	{
+		cerr<<"Error "<<filename<<" is not good"<<endl;
+		return *this;
+	}
+	long nrows = 0;
+	if(fits_get_num_rows(fptr, &nrows, &status))
+	{
+		cerr<<"Error : reading number of rows in table of file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+		return *this;
+	}
+	if(nrows > long(number_rows) && fits_delete_rows(fptr, number_rows + 1, nrows - number_rows, &status))
+	{
+		cerr<<"Error : deleting rows in table of file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+	}
+	else if(nrows < long(number_rows) && fits_insert_rows(fptr, nrows, number_rows - nrows, &status))
+	{
+		cerr<<"Error : inserting rows in table of file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+	}
+	return *this;
+}
+
 int FitsFile::find_column(const string &name)
 {
 	int colnum = 0;
@@ -874,10 +1179,10 @@ FitsFile& FitsFile::readColumn(const string &name, vector<T>& data)
 }
 
 
-template FitsFile& FitsFile::writeImage(ColorType* image, const unsigned X, const unsigned Y, int mode, const string name);
+template FitsFile& FitsFile::writeImage(ColorType* image, const unsigned X, const unsigned Y, int mode, const string name, int bitpix);
 template FitsFile& FitsFile::readImage(ColorType*& image, unsigned &X, unsigned& Y, ColorType* null);
 
-template FitsFile& FitsFile::writeImage(EUVPixelType* image, const unsigned X, const unsigned Y, int mode, const string name);
+template FitsFile& FitsFile::writeImage(EUVPixelType* image, const unsigned X, const unsigned Y, int mode, const string name, int bitpix);
 template FitsFile& FitsFile::readImage(EUVPixelType*& image, unsigned &X, unsigned& Y, EUVPixelType* null);
 
 template FitsFile& FitsFile::writeColumn(const string &name, const vector<int>& array, const int mode);
@@ -1196,3 +1501,217 @@ time_t iso2ctime(const string& date)
 	}
 	return timegm(&time);
 }
+
+FitsFile& FitsFile::writeColumns(FitsTable& table, const int mode)
+{
+	if (isClosed())
+	{
+		cerr<<"Error writing columns, "<<filename<<" is closed"<<endl;
+		return *this;
+	}
+	if(!isGood())
+	{
+		cerr<<"Error "<<filename<<" is not good"<<endl;
+		return *this;
+	}
+	
+	// We determine the fields to write
+	vector<FitsTable::Column*> columns;
+	vector<unsigned> fields;
+	vector<int> datatypes;
+	vector<string> names, formats;
+	for (unsigned c = 0; c < table.numberColumns(); ++c)
+	{
+		for (unsigned f = 0; f < table[c]->numberFields(); ++f)
+		{
+			int datatype = fitsDataType(table[c]->fieldType(f));
+			if (datatype == 0)
+			{
+				cerr<<"Error writing column "<<table[c]->name<<" to file "<<filename<<" : Unknown type "<< table[c]->fieldType(f).name() <<endl;
+				continue;
+			}
+			columns.push_back(table[c]);
+			fields.push_back(f);
+			datatypes.push_back(datatype);
+			names.push_back(table[c]->fieldName(f));
+			if(datatype == TSTRING)
+				formats.push_back(toString(table[c]->fieldWidth(f)) + "A");
+			else
+				formats.push_back(getFormat(datatype));
+		}
+	}
+	
+	// If we overwrite and the field exist, we replace it at the same position
+	vector<int> colnums(names.size(), 0);
+	if(mode & overwrite)
+	{
+		for (unsigned i = 0; i < names.size(); ++i)
+		{
+			colnums[i] = find_column(names[i]);
+			if(colnums[i] == 0)
+				continue;
+			char* ttype = const_cast<char *>(names[i].c_str());
+			char* tform = const_cast<char *>(formats[i].c_str());
+			if (fits_delete_col(fptr, colnums[i], &status) || fits_insert_col(fptr, colnums[i], ttype, tform, &status))
+			{
+				cerr<<"Error : replacing column "<<names[i]<<" in file "<<filename<<" :"<< status <<endl;
+				fits_report_error(stderr, status);
+				return *this;
+			}
+		}
+	}
+	
+	// The other fields are created together at the end of the table
+	int numcols = 0;
+	if (fits_get_num_cols(fptr, &numcols, &status) )
+	{
+		cerr<<"Error : writing columns to file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+		return *this;
+	}
+	vector<char*> ttypes, tforms;
+	for (unsigned i = 0; i < names.size(); ++i)
+	{
+		if(colnums[i] == 0)
+		{
+			ttypes.push_back(const_cast<char *>(names[i].c_str()));
+			tforms.push_back(const_cast<char *>(formats[i].c_str()));
+			colnums[i] = numcols + ttypes.size();
+		}
+	}
+	if (ttypes.size() > 0 && fits_insert_cols(fptr, numcols + 1, ttypes.size(), &(ttypes[0]), &(tforms[0]), &status))
+	{
+		cerr<<"Error : writing columns to file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+		return *this;
+	}
+	
+	// We write the data by groups of rows, so that cfitsio can keep them in it's buffers
+	long nrows = table.numberRows();
+	long step = 0;
+	if (fits_get_rowsize(fptr, &step, &status) || step <= 0)
+	{
+		status = 0;
+		step = nrows;
+	}
+	for (long firstrow = 0; firstrow < nrows; firstrow += step)
+	{
+		long number = firstrow + step < nrows ? step : nrows - firstrow;
+		for (unsigned i = 0; i < names.size(); ++i)
+		{
+			if(columns[i]->size() < unsigned(firstrow + number))
+			{
+				cerr<<"Error : column "<<columns[i]->name<<" has less values than the number of rows"<<endl;
+				continue;
+			}
+			void* array = columns[i]->fieldData(fields[i], firstrow, number);
+			int error;
+			if(datatypes[i] == TSTRING)
+				error = fits_write_col_str(fptr, colnums[i], firstrow + 1, 1, number, (char**) array, &status);
+			else
+				error = fits_write_col(fptr, datatypes[i], colnums[i], firstrow + 1, 1, number, array, &status);
+			if (error)
+			{
+				cerr<<"Error : writing values to column "<<names[i]<<" in file "<<filename<<" :"<< status <<endl;
+				fits_report_error(stderr, status);
+				return *this;
+			}
+		}
+	}
+	return *this;
+}
+
+FitsFile& FitsFile::readColumns(FitsTable& table)
+{
+	if (isClosed())
+	{
+		cerr<<"Error reading columns, "<<filename<<" is closed"<<endl;
+		return *this;
+	}
+	if(!isGood())
+	{
+		cerr<<"Error "<<filename<<" is not good"<<endl;
+		return *this;
+	}
+	
+	// We get the number of rows and adjust the size of the table accordingly
+	long nrows = 0;
+	if(fits_get_num_rows(fptr, &nrows, &status))
+	{
+		cerr<<"Error : reading number of rows in table of file "<<filename<<" :"<< status <<endl;
+		fits_report_error(stderr, status);
+		return *this;
+	}
+	table.resize(nrows);
+	
+	// We search for the fields, the columns that are missing are left empty
+	vector<FitsTable::Column*> columns;
+	vector<unsigned> fields;
+	vector<int> datatypes, colnums;
+	for (unsigned c = 0; c < table.numberColumns(); ++c)
+	{
+		for (unsigned f = 0; f < table[c]->numberFields(); ++f)
+		{
+			int colnum = find_column(table[c]->fieldName(f));
+			if(colnum == 0)
+			{
+				table[c]->resize(0);
+				break;
+			}
+			int datatype = fitsDataType(table[c]->fieldType(f));
+			if (datatype == 0)
+			{
+				cerr<<"Error reading column "<<table[c]->name<<" from file "<<filename<<" : Unknown type "<< table[c]->fieldType(f).name() <<endl;
+				continue;
+			}
+			if(datatype == TSTRING)
+			{
+				int width = 1000;
+				if(fits_get_col_display_width(fptr, colnum, &width, &status))
+				{
+					cerr<<"Error : determinig max string size of column "<<table[c]->fieldName(f)<<" in file "<<filename<<" :"<< status <<endl;
+					fits_report_error(stderr, status);
+					status = 0;
+				}
+				table[c]->setFieldWidth(f, width);
+			}
+			columns.push_back(table[c]);
+			fields.push_back(f);
+			datatypes.push_back(datatype);
+			colnums.push_back(colnum);
+		}
+	}
+	
+	// We read the data by groups of rows
+	long step = 0;
+	if (fits_get_rowsize(fptr, &step, &status) || step <= 0)
+	{
+		status = 0;
+		step = nrows;
+	}
+	char nulstr[] = "";
+	int anynul;
+	for (long firstrow = 0; firstrow < nrows; firstrow += step)
+	{
+		long number = firstrow + step < nrows ? step : nrows - firstrow;
+		for (unsigned i = 0; i < columns.size(); ++i)
+		{
+			if(columns[i]->size() == 0)
+				continue;
+			void* array = columns[i]->fieldBuffer(fields[i], firstrow, number);
+			int error;
+			if(datatypes[i] == TSTRING)
+				error = fits_read_col_str(fptr, colnums[i], firstrow + 1, 1, number, nulstr, (char**) array, &anynul, &status);
+			else
+				error = fits_read_col(fptr, datatypes[i], colnums[i], firstrow + 1, 1, number, NULL, array, &anynul, &status);
+			if (error)
+			{
+				cerr<<"Error : reading values from column "<<columns[i]->fieldName(fields[i])<<" in file "<<filename<<" :"<< status <<endl;
+				fits_report_error(stderr, status);
+				return *this;
+			}
+			columns[i]->fieldRead(fields[i], firstrow, number);
+		}
+	}
+	return *this;
+}
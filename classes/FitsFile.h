@@ -16,6 +16,7 @@
 #include "constants.h"
 #include "Header.h"
 #include "Coordinate.h"
+#include "FitsTable.h"
 
 
 //! Class that manage i/o to a fits file
@@ -80,6 +81,11 @@ class FitsFile
 		FitsFile& moveTo(const std::string& extension_name);
 		//! Routine to test if an HDU exist
 		bool has(const std::string& extension_name);
+		//! Routine to test if the current HDU is a table
+		bool isTable();
+		//! Routine to compute the checksum of the data of the current HDU
+		/*! The sum is the one of the DATASUM keyword, it can be used to know if the data of an HDU has changed */
+		unsigned long dataSum();
 		
 		//! Routine to read a Fits header
 		FitsFile& readHeader(Header& header);
@@ -95,12 +101,28 @@ class FitsFile
 		/*! @param mode The mode specifies how to write the image.
 				Possible values are FitsFile::update and/or FitsFile::compress (they can be specified together with a | )
 				By default a new image will be appended to the fits file.
+			@param bitpix The bitpix of the image in the file, by default the one of the type of the pixels.
+				The pixels are converted by cfitsio, so their values must fit in it.
 		*/
 		template<class T>
-		FitsFile& writeImage(T* image, const unsigned X, const unsigned Y, int mode = 0, const std::string name = "");
+		FitsFile& writeImage(T* image, const unsigned X, const unsigned Y, int mode = 0, const std::string name = "", int bitpix = 0);
+		
+		//! Routine to write a 2D image quantized on 8 or 16 bits
+		/*! The values between min and max are mapped linearly to integers, the mapping is stored in the BSCALE and BZERO keywords.
+			Values outside the range are clipped, and non finite values are written as BLANK.
+			Readers that apply the scaling (like readImage) get back the values with a precision of (max - min)/254 or (max - min)/65534.
+			@param mode Possible value is FitsFile::compress
+		*/
+		FitsFile& writeQuantizedImage(const Real* image, const unsigned X, const unsigned Y, const Real min, const Real max, const unsigned bits = 16, int mode = 0, const std::string name = "");
+		//! Routine to read a 2D image quantized on 8 or 16 bits without applying the scaling
+		/*! The value of a pixel is zero + scale * value, except if the value is blank */
+		FitsFile& readQuantizedImage(std::vector<short>& values, unsigned &X, unsigned& Y, Real& scale, Real& zero, short& blank);
 		
 		//! Routine to write a binary table
 		FitsFile& writeTable(const std::string &name, const unsigned number_rows = 0);
+		//! Routine to change the number of rows of the current table
+		/*! Rows are added or removed at the end of the table */
+		FitsFile& resizeTable(const unsigned number_rows);
 		//! Routine to write a column in the current table
 		//! @tparam T Type of the column data
 		/*! @param mode The mode specifies how to write the column.
@@ -114,6 +136,17 @@ class FitsFile
 		template<class T>
 		FitsFile& readColumn(const std::string &name, std::vector<T>& data);
 	
+		//! Routine to write all the columns of a table in the current table
+		/*! The fields are created together, and the rows are written in groups of the optimal size for cfitsio.
+			@param mode The mode specifies how to write the columns.
+				Possible value are FitsFile::overwrite 
+				By default the columns are appended to the table.
+		*/
+		FitsFile& writeColumns(FitsTable& table, const int mode = 0);
+		//! Routine to read all the columns of a table from the current table
+		/*! The columns that are not in the current table are left empty */
+		FitsFile& readColumns(FitsTable& table);
+	
 		//! Routine to find a column by it's name in a table
 		int find_column(const std::string &name);
 	
@@ -124,6 +157,8 @@ class FitsFile
 		static const int update = 2;
 		//! Constants for mode options
 		static const int compress = 4;
+		//! Constants for mode options, to write a ColorMap as a table of runs
+		static const int runlength = 8;
 };
 
 //! Routine that convert a string date (iso/fits formed) to a time_t
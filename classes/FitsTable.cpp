@@ -0,0 +1,193 @@
+#include "FitsTable.h"
+#include <cstring>
+
+using namespace std;
+
+//! Column of strings, the width of the field is the size of the longest string
+class StringColumn : public FitsTable::TypedColumn<string>
+{
+	private :
+		vector<char*> pointers;
+		vector<char> buffer;
+		unsigned width;
+
+	public :
+		StringColumn(const string& name, const unsigned rows) : FitsTable::TypedColumn<string>(name, rows), width(0) {}
+
+		// Strings are passed to cfitsio as char*
+		const type_info& fieldType(const unsigned /*f*/) const { return typeid(char*); }
+
+		unsigned fieldWidth(const unsigned /*f*/) const
+		{
+			unsigned max_width = width;
+			for (unsigned r = 0; r < values.size(); ++r)
+				max_width = values[r].length() > max_width ? values[r].length() : max_width;
+			return max_width > 0 ? max_width : 1;
+		}
+
+		void setFieldWidth(const unsigned /*f*/, const unsigned width) { this->width = width; }
+
+		void* fieldData(const unsigned /*f*/, const unsigned first, const unsigned number)
+		{
+			pointers.resize(number);
+			for (unsigned r = 0; r < number; ++r)
+				pointers[r] = const_cast<char *>(values[first + r].c_str());
+			return &(pointers[0]);
+		}
+
+		void* fieldBuffer(const unsigned f, const unsigned /*first*/, const unsigned number)
+		{
+			unsigned stride = fieldWidth(f) + 1;
+			buffer.assign(number * stride, '\0');
+			pointers.resize(number);
+			for (unsigned r = 0; r < number; ++r)
+				pointers[r] = &(buffer[r * stride]);
+			return &(pointers[0]);
+		}
+
+		void fieldRead(const unsigned /*f*/, const unsigned first, const unsigned number)
+		{
+			for (unsigned r = 0; r < number; ++r)
+				values[first + r] = pointers[r];
+		}
+};
+
+//! Column of coordinates, stored as 2 fields
+/*!
+@tparam C Type of the coordinate
+@tparam T Type of the fields
+*/
+template<class C, class T>
+class CoordinateColumn : public FitsTable::TypedColumn<C>
+{
+	protected :
+		std::vector<T> field;
+		std::string prefixes[2];
+		//! Conversion between a coordinate and the field values
+		virtual T get(const C& c, const unsigned f) const = 0;
+		virtual void set(C& c, const unsigned f, const T& value) const = 0;
+
+	public :
+		CoordinateColumn(const string& name, const unsigned rows, const string& xprefix, const string& yprefix) : FitsTable::TypedColumn<C>(name, rows)
+		{
+			prefixes[0] = xprefix;
+			prefixes[1] = yprefix;
+		}
+
+		unsigned numberFields() const { return 2; }
+
+		string fieldName(const unsigned f) const { return prefixes[f] + this->name; }
+
+		const type_info& fieldType(const unsigned /*f*/) const { return typeid(T); }
+
+		void* fieldData(const unsigned f, const unsigned first, const unsigned number)
+		{
+			field.resize(number);
+			for (unsigned r = 0; r < number; ++r)
+				field[r] = get(this->values[first + r], f);
+			return &(field[0]);
+		}
+
+		void* fieldBuffer(const unsigned /*f*/, const unsigned /*first*/, const unsigned number)
+		{
+			field.resize(number);
+			return &(field[0]);
+		}
+
+		void fieldRead(const unsigned f, const unsigned first, const unsigned number)
+		{
+			for (unsigned r = 0; r < number; ++r)
+				set(this->values[first + r], f, field[r]);
+		}
+};
+
+//! Column of PixLoc, 1 is added to conform to fits standard
+class PixLocColumn : public CoordinateColumn<PixLoc, unsigned>
+{
+	protected :
+		unsigned get(const PixLoc& c, const unsigned f) const { return (f == 0 ? c.x : c.y) + 1; }
+		void set(PixLoc& c, const unsigned f, const unsigned& value) const { (f == 0 ? c.x : c.y) = value - 1; }
+	public :
+		PixLocColumn(const string& name, const unsigned rows) : CoordinateColumn<PixLoc, unsigned>(name, rows, "X", "Y") {}
+};
+
+//! Column of RealPixLoc, 1 is added to conform to fits standard
+class RealPixLocColumn : public CoordinateColumn<RealPixLoc, Real>
+{
+	protected :
+		Real get(const RealPixLoc& c, const unsigned f) const { return (f == 0 ? c.x : c.y) + 1; }
+		void set(RealPixLoc& c, const unsigned f, const Real& value) const { (f == 0 ? c.x : c.y) = value - 1; }
+	public :
+		RealPixLocColumn(const string& name, const unsigned rows) : CoordinateColumn<RealPixLoc, Real>(name, rows, "X", "Y") {}
+};
+
+//! Column of HGS coordinates
+class HGSColumn : public CoordinateColumn<HGS, Real>
+{
+	protected :
+		Real get(const HGS& c, const unsigned f) const { return f == 0 ? c.longitude : c.latitude; }
+		void set(HGS& c, const unsigned f, const Real& value) const { (f == 0 ? c.longitude : c.latitude) = value; }
+	public :
+		HGSColumn(const string& name, const unsigned rows) : CoordinateColumn<HGS, Real>(name, rows, "LONGITUDE", "LATITUDE") {}
+};
+
+template<>
+FitsTable::Column* FitsTable::create<string>(const string& name)
+{
+	return new StringColumn(name, number_rows);
+}
+
+template<>
+FitsTable::Column* FitsTable::create<PixLoc>(const string& name)
+{
+	return new PixLocColumn(name, number_rows);
+}
+
+template<>
+FitsTable::Column* FitsTable::create<RealPixLoc>(const string& name)
+{
+	return new RealPixLocColumn(name, number_rows);
+}
+
+template<>
+FitsTable::Column* FitsTable::create<HGS>(const string& name)
+{
+	return new HGSColumn(name, number_rows);
+}
+
+FitsTable::FitsTable(const unsigned number_rows)
+:number_rows(number_rows)
+{}
+
+FitsTable::~FitsTable()
+{
+	for (unsigned c = 0; c < columns.size(); ++c)
+		delete columns[c];
+}
+
+bool FitsTable::has(const string& name) const
+{
+	return names.count(name) > 0;
+}
+
+unsigned FitsTable::numberRows() const
+{
+	return number_rows;
+}
+
+void FitsTable::resize(const unsigned number_rows)
+{
+	this->number_rows = number_rows;
+	for (unsigned c = 0; c < columns.size(); ++c)
+		columns[c]->resize(number_rows);
+}
+
+unsigned FitsTable::numberColumns() const
+{
+	return columns.size();
+}
+
+FitsTable::Column* FitsTable::operator[](const unsigned c)
+{
+	return columns.at(c);
+}
@@ -0,0 +1,172 @@
+#pragma once
+#ifndef FitsTable_H
+#define FitsTable_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include <typeinfo>
+#include <stdexcept>
+
+#include "constants.h"
+#include "Coordinate.h"
+
+//! Class that buffers the rows of a fits binary table in columns
+/*!
+The schema of the table is declared once by requesting the columns by name and type, in the order they must appear in the table.
+The rows are then filled directly in the column vectors.
+The table is written or read in one pass by FitsFile::writeColumns and FitsFile::readColumns, that process all columns together, by groups of rows.
+
+A column of coordinates (PixLoc, RealPixLoc, HGS) is stored in the fits table as 2 fields, in the same way as FitsFile::writeColumn does.
+
+Example:
+@code
+FitsTable table(regions.size());
+std::vector<unsigned>& id = table.column<unsigned>("ID");
+std::vector<PixLoc>& boxmin = table.column<PixLoc>("BOXMIN");
+for(unsigned r = 0; r < regions.size(); ++r)
+{
+	id[r] = regions[r]->Id();
+	boxmin[r] = regions[r]->Boxmin();
+}
+file.writeColumns(table);
+@endcode
+*/
+
+class FitsTable
+{
+	public :
+		//! Base class of a column of the table
+		/*! A column can span several fields (i.e. fits columns) */
+		class Column
+		{
+			public :
+				//! Name of the column
+				std::string name;
+
+				//! Constructor
+				Column(const std::string& name) : name(name) {}
+				//! Destructor
+				virtual ~Column() {}
+
+				//! Number of rows in the column
+				virtual unsigned size() const = 0;
+				//! Routine to change the number of rows in the column
+				virtual void resize(const unsigned rows) = 0;
+
+				//! Number of fields of the column
+				virtual unsigned numberFields() const { return 1; }
+				//! Name of the field f
+				virtual std::string fieldName(const unsigned /*f*/) const { return name; }
+				//! Type of the values of the field f
+				virtual const std::type_info& fieldType(const unsigned f) const = 0;
+				//! Width of the field f (only meaningfull for strings)
+				virtual unsigned fieldWidth(const unsigned /*f*/) const { return 1; }
+				//! Routine to set the width of the field f before reading it (only meaningfull for strings)
+				virtual void setFieldWidth(const unsigned /*f*/, const unsigned /*width*/) {}
+
+				//! Return a pointer to the values of field f for number rows, starting at row first, to write them
+				virtual void* fieldData(const unsigned f, const unsigned first, const unsigned number) = 0;
+				//! Return a pointer to a buffer to read the values of field f for number rows, starting at row first
+				virtual void* fieldBuffer(const unsigned f, const unsigned first, const unsigned number) { return fieldData(f, first, number); }
+				//! Routine to store the values read into the buffer returned by fieldBuffer
+				virtual void fieldRead(const unsigned /*f*/, const unsigned /*first*/, const unsigned /*number*/) {}
+		};
+
+		//! Column of simple numerical values
+		template<class T>
+		class TypedColumn : public Column
+		{
+			public :
+				std::vector<T> values;
+
+				TypedColumn(const std::string& name, const unsigned rows) : Column(name), values(rows) {}
+				unsigned size() const { return values.size(); }
+				void resize(const unsigned rows) { values.resize(rows); }
+				const std::type_info& fieldType(const unsigned /*f*/) const { return typeid(T); }
+				void* fieldData(const unsigned /*f*/, const unsigned first, const unsigned /*number*/) { return &(values[first]); }
+		};
+
+	private :
+		//! Number of rows of the table
+		unsigned number_rows;
+
+		//! The columns, in the order they were declared
+		std::vector<Column*> columns;
+
+		//! Index of the columns by name
+		std::map<std::string, unsigned> names;
+
+		//! Routine to create a column of type T
+		template<class T>
+		Column* create(const std::string& name);
+
+	public :
+		//! Constructor
+		FitsTable(const unsigned number_rows = 0);
+
+		//! Destructor
+		~FitsTable();
+
+		//! Return the vector of values of the column name, the column is created if it does not exist yet
+		template<class T>
+		std::vector<T>& column(const std::string& name);
+
+		//! Test if the column has been declared
+		bool has(const std::string& name) const;
+
+		//! Return the number of rows
+		unsigned numberRows() const;
+
+		//! Routine to change the number of rows of all the columns
+		void resize(const unsigned number_rows);
+
+		//! Return the number of columns
+		unsigned numberColumns() const;
+
+		//! Accessor to a column
+		Column* operator[](const unsigned c);
+
+	private :
+		// The table owns the columns, so it cannot be copied
+		FitsTable(const FitsTable&);
+		FitsTable& operator=(const FitsTable&);
+};
+
+template<class T>
+FitsTable::Column* FitsTable::create(const std::string& name)
+{
+	return new TypedColumn<T>(name, number_rows);
+}
+
+template<>
+FitsTable::Column* FitsTable::create<std::string>(const std::string& name);
+
+template<>
+FitsTable::Column* FitsTable::create<PixLoc>(const std::string& name);
+
+template<>
+FitsTable::Column* FitsTable::create<RealPixLoc>(const std::string& name);
+
+template<>
+FitsTable::Column* FitsTable::create<HGS>(const std::string& name);
+
+template<class T>
+std::vector<T>& FitsTable::column(const std::string& name)
+{
+	std::map<std::string, unsigned>::iterator c = names.find(name);
+	if(c == names.end())
+	{
+		c = names.insert(std::make_pair(name, unsigned(columns.size()))).first;
+		columns.push_back(create<T>(name));
+	}
+	// All the column classes derive from TypedColumn
+	TypedColumn<T>* typed = dynamic_cast<TypedColumn<T>*>(columns[c->second]);
+	if(typed == NULL)
+	{
+		throw std::invalid_argument("Column " + name + " was declared with a different type");
+	}
+	return typed->values;
+}
+
+#endif
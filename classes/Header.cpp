@@ -1,8 +1,82 @@
 #include "Header.h"
 #include "tools.h"
+#include <cstdlib>
+#include <pthread.h>
 
 using namespace std;
 
+//! Maximal number of templates kept by Header::expand
+static const unsigned maxExpandTemplates = 256;
+//! Templates already split by Header::expand, shared by all the headers
+static map<string, vector<string> > expandTemplates;
+//! Mutex for the threads expanding texts at the same time
+static pthread_mutex_t expandTemplatesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Hash function for the keyword names (FNV-1a)
+static inline unsigned hashKey(const char* key, const size_t length)
+{
+	unsigned hash = 2166136261u;
+	for(size_t c = 0; c < length; ++c)
+	{
+		hash ^= (unsigned char)(key[c]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+void Header::Keyword::parse()
+{
+	integer = 0;
+	real = 0;
+	size_t start = value.find_first_not_of(" \t");
+	if(start == string::npos)
+	{
+		type = EMPTY;
+		return;
+	}
+	size_t end = value.find_last_not_of(" \t") + 1;
+	if(end - start == 1 && (value[start] == 'T' || value[start] == 'F'))
+	{
+		type = LOGICAL;
+		integer = value[start] == 'T' ? 1 : 0;
+		real = integer;
+		return;
+	}
+	if(value.find_first_not_of(" \t0123456789+-.eEdD", start) != string::npos)
+	{
+		type = STRING;
+		return;
+	}
+	// Fits allows D as an exponent, strtod does not
+	string number = value.substr(start, end - start);
+	for(size_t c = 0; c < number.length(); ++c)
+	{
+		if(number[c] == 'd' || number[c] == 'D')
+			number[c] = 'E';
+	}
+	const char* begin = number.c_str();
+	char* stop = NULL;
+	if(number.find_first_of(".eE") == string::npos)
+	{
+		integer = strtol(begin, &stop, 10);
+		if(stop == begin + number.length())
+		{
+			type = INTEGER;
+			real = integer;
+			return;
+		}
+	}
+	real = strtod(begin, &stop);
+	if(stop == begin + number.length())
+	{
+		type = REAL;
+		return;
+	}
+	integer = 0;
+	real = 0;
+	type = STRING;
+}
+
 Header::~Header()
 {
 	#if defined VERBOSE
@@ -14,48 +88,110 @@ Header::Header()
 {}
 
 Header::Header(const Header& i)
+:keywords(i.keywords), index(i.index)
+{}
+
+
+Header::Header(const Header* i)
+:keywords(i->keywords), index(i->index)
+{}
+
+Header& Header::operator=(const Header& i)
 {
 	keywords = i.keywords;
+	index = i.index;
+	return *this;
 }
 
 
-Header::Header(const Header* i)
+int Header::find(const char* key, const size_t length) const
 {
-	keywords = i->keywords;
+	if(index.empty())
+		return -1;
+	const size_t mask = index.size() - 1;
+	for(size_t slot = hashKey(key, length) & mask; index[slot] != 0; slot = (slot + 1) & mask)
+	{
+		const Keyword& k = keywords[index[slot] - 1];
+		if(k.key.length() == length && k.key.compare(0, length, key, length) == 0)
+			return index[slot] - 1;
+	}
+	return -1;
 }
 
+void Header::rehash(const size_t size)
+{
+	index.assign(size, 0);
+	const size_t mask = size - 1;
+	for(unsigned k = 0; k < keywords.size(); ++k)
+	{
+		size_t slot = hashKey(keywords[k].key.c_str(), keywords[k].key.length()) & mask;
+		while(index[slot] != 0)
+			slot = (slot + 1) & mask;
+		index[slot] = k + 1;
+	}
+}
+
+Header::Keyword& Header::keyword(const string& key)
+{
+	int k = find(key.c_str(), key.length());
+	if(k >= 0)
+		return keywords[k];
 
+	keywords.push_back(Keyword(key));
+	// We keep the load of the hash table under one half
+	if(2 * keywords.size() > index.size())
+	{
+		rehash(index.size() < 64 ? 128 : 2 * index.size());
+	}
+	else
+	{
+		const size_t mask = index.size() - 1;
+		size_t slot = hashKey(key.c_str(), key.length()) & mask;
+		while(index[slot] != 0)
+			slot = (slot + 1) & mask;
+		index[slot] = keywords.size();
+	}
+	return keywords.back();
+}
 
 bool Header::has(const string& key) const
 {
-	return keywords.find(key) != keywords.end();
+	return find(key.c_str(), key.length()) >= 0;
 }
 
 
 bool Header::has(const char* key) const
 {
-	return  keywords.find(key) != keywords.end();
+	return find(key, strlen(key)) >= 0;
 }
 
 template<>
 string Header::get<string>(const string& key) const
 {
-	map<string,string>::const_iterator it = keywords.find(key);
-	if(it == keywords.end())
+	int k = find(key.c_str(), key.length());
+	if(k < 0)
 	{
 		#if defined VERBOSE
 		cerr<<"Warning : No such key in keywords "<<key<<endl;
 		#endif
 		return "";
 	}
-	return it->second;
+	return keywords[k].value;
+}
+
+Header::ValueType Header::type(const string& key) const
+{
+	int k = find(key.c_str(), key.length());
+	if(k < 0)
+		return EMPTY;
+	return keywords[k].type;
 }
 
 string Header::comment(const string& key) const
 {
-	map<string,string>::const_iterator i = keywords_comments.find(key);
-	if(i != keywords_comments.end())
-		return i->second;
+	int k = find(key.c_str(), key.length());
+	if(k >= 0)
+		return keywords[k].comment;
 	else
 		return "";
 }
@@ -63,40 +199,91 @@ string Header::comment(const string& key) const
 template<>
 void Header::set<string>(const string& key, const string& value, const string& comment)
 {
-	keywords[key] = value;
+	Keyword& k = keyword(key);
+	const bool isString = k.type == STRING;
+	k.value = value;
+	k.parse();
+	// A keyword that had a string value keeps it, even if the new value looks like a number or a logical
+	if(isString && k.type != EMPTY)
+	{
+		k.type = STRING;
+		k.integer = 0;
+		k.real = 0;
+	}
+	if(!comment.empty())
+		k.comment = comment;
+}
+
+void Header::set(const string& key, const char* value, const string& comment)
+{
+	set<string>(key, string(value), comment);
+}
+
+void Header::setString(const string& key, const string& value, const string& comment)
+{
+	Keyword& k = keyword(key);
+	k.value = value;
+	k.type = STRING;
+	k.integer = 0;
+	k.real = 0;
 	if(!comment.empty())
-		keywords_comments[key] = comment;
+		k.comment = comment;
 }
 
+/*!
+The text is split once into a list of segments, alternatively a literal text and a keyword name.
+The list is kept so that expanding the same text for several headers does not need to scan it again.
+*/
 string Header::expand(const string& text)
 {
-	string result = text;
-	size_t key_start = result.find_first_of('{');
-	while (key_start != string::npos)
+	vector<string> segments;
+	pthread_mutex_lock(&expandTemplatesMutex);
+	map<string, vector<string> >::const_iterator t = expandTemplates.find(text);
+	if(t != expandTemplates.end())
+		segments = t->second;
+	pthread_mutex_unlock(&expandTemplatesMutex);
+
+	if(segments.empty())
 	{
-		size_t key_end = result.find_first_of('}', key_start);
-		if(key_end != string::npos)
+		size_t literal_start = 0;
+		size_t key_start = text.find_first_of('{');
+		while (key_start != string::npos)
 		{
-			string key_name = result.substr(key_start + 1, key_end - key_start - 1);
-			string value = "";
-			if(has(key_name))
+			size_t key_end = text.find_first_of('}', key_start);
+			if(key_end == string::npos)
 			{
-				value = get<string>(key_name);
+				cerr<<"Warning: malformed string, no closing } after position "<<key_start<<" in "<<text<<endl;
+				break;
 			}
-			else
-			{
-				cerr<<"Warning: key_name "<<key_name<<" requested in "<<text<<" not found in header."<<endl;
-			}
-			result.replace(key_start, key_end - key_start + 1, value);
+			segments.push_back(replaceAll(text.substr(literal_start, key_start - literal_start), "\\n", "\n"));
+			segments.push_back(text.substr(key_start + 1, key_end - key_start - 1));
+			literal_start = key_end + 1;
+			key_start = text.find_first_of('{', literal_start);
+		}
+		segments.push_back(replaceAll(text.substr(literal_start), "\\n", "\n"));
+
+		// The templates are only a cache, when there are too many we start over
+		pthread_mutex_lock(&expandTemplatesMutex);
+		if(expandTemplates.size() >= maxExpandTemplates)
+			expandTemplates.clear();
+		expandTemplates.insert(make_pair(text, segments));
+		pthread_mutex_unlock(&expandTemplatesMutex);
+	}
+
+	string result = segments[0];
+	for(unsigned s = 1; s + 1 < segments.size(); s += 2)
+	{
+		int k = find(segments[s].c_str(), segments[s].length());
+		if(k >= 0)
+		{
+			result += keywords[k].value;
 		}
 		else
 		{
-			cerr<<"Warning: malformed string, no closing } after position "<<key_start<<" in "<<text<<endl;
-			break;
+			cerr<<"Warning: key_name "<<segments[s]<<" requested in "<<text<<" not found in header."<<endl;
 		}
-		key_start = result.find_first_of('{');
+		result += segments[s + 1];
 	}
-	result = replaceAll(result, "\\n", "\n");
 	#if defined VERBOSE
 	cout<<endl<<text<<" has been expanded to: "<<result<<endl;
 	#endif
@@ -8,6 +8,7 @@
 #include <typeinfo>
 #include <limits>
 #include <string>
+#include <vector>
 #include <map>
 #include <ctime>
 #include <cstring>
@@ -15,13 +16,70 @@
 #include "constants.h"
 
 
+//! Class that stores the keywords of a fits header
+/*!
+The keywords are kept in the order they were set, together with their comment, so that they can be written back in the same order.
+They are indexed by a flat open addressing hash table on the keyword name.
+
+The value of a keyword is parsed only once, when it is set, into a typed slot (integer, real, logical or string).
+Getting a numerical value is then a simple conversion, and does not need to parse the string again.
+*/
+
 class Header
 {
-	private:
-		std::map<std::string,std::string> keywords;
-		std::map<std::string,std::string> keywords_comments;
 	public :
-		
+		//! Type of the value of a keyword
+		enum ValueType {EMPTY, STRING, INTEGER, REAL, LOGICAL};
+
+		//! A keyword of the header, with its value already parsed
+		class Keyword
+		{
+			public :
+				//! Name of the keyword
+				std::string key;
+				//! Value of the keyword as a string
+				std::string value;
+				//! Comment of the keyword
+				std::string comment;
+				//! Type of the value
+				ValueType type;
+				//! Value of the keyword if it is an integer or a logical
+				long integer;
+				//! Value of the keyword if it is a number
+				double real;
+
+				//! Constructor
+				Keyword(const std::string& key = "")
+				:key(key), type(EMPTY), integer(0), real(0)
+				{}
+
+				//! Routine to determine the type and the value of the keyword from the string value
+				void parse();
+		};
+
+	private :
+		//! The keywords in the order they were set
+		std::vector<Keyword> keywords;
+
+		//! Hash table of the position of the keywords in the keywords vector (+1, 0 means empty slot)
+		std::vector<unsigned> index;
+
+		//! Routine to search a keyword by it's name
+		/*! @return The position of the keyword in keywords, or -1 if it is not in the header */
+		int find(const char* key, const size_t length) const;
+
+		//! Routine to search a keyword by it's name, and to create it if it does not exist
+		Keyword& keyword(const std::string& key);
+
+		//! Routine to rebuild the hash table with a new size
+		void rehash(const size_t size);
+
+		//! Helper to convert the value of a keyword to a type T
+		template<class T, bool numerical = std::numeric_limits<T>::is_specialized>
+		struct Value;
+
+	public :
+
 		//! Constructor
 		Header();
 		//! Copy Constructor
@@ -30,30 +88,45 @@ class Header
 		Header(const Header* i);
 		//! Destructor
 		~Header();
-		
+		//! Assignment operator
+		Header& operator=(const Header& i);
+
 		//! Ckeck if the keyword key is in the header
 		bool has(const std::string& key) const;
 		//! Ckeck if the keyword key is in the header
 		bool has(const char* key) const;
-		
+
 		//! Return the value of the keyword key
 		template<class T>
 		T get(const std::string& key) const;
-		
+
+		//! Return the type of the value of the keyword key
+		ValueType type(const std::string& key) const;
+
 		//! Get comment for keyword key
 		std::string comment(const std::string& key) const;
-		
+
 		//! Set/Update the value and the comment of the keyword key
 		template<class T>
 		void set(const std::string& key, const T& value, const std::string& comment = "");
 		
+		//! Set/Update the value and the comment of the keyword key
+		void set(const std::string& key, const char* value, const std::string& comment = "");
+
+		//! Set/Update the keyword key with a string value, even if the value looks like a number or a logical
+		void setString(const std::string& key, const std::string& value, const std::string& comment = "");
+
 		//! Expand the text repacing all keywords between {} by their value in the header, and \n by newline
 		std::string expand(const std::string& text);
-		
+
+		//! Number of keywords in the header
+		unsigned size() const { return keywords.size(); }
+
 		//! Iterator
-		typedef std::map<std::string,std::string>::iterator iterator;
+		/*! The key of a keyword must not be modified through the iterator, and Keyword::parse must be called if it's value is modified */
+		typedef std::vector<Keyword>::iterator iterator;
 		//! Const Iterator
-		typedef std::map<std::string,std::string>::const_iterator const_iterator;
+		typedef std::vector<Keyword>::const_iterator const_iterator;
 		iterator begin() { return keywords.begin(); }
 		iterator end() { return keywords.end(); }
 		const_iterator begin() const { return keywords.begin(); }
@@ -61,21 +134,74 @@ class Header
 
 };
 
+//! Conversion of a keyword value to a non numerical type, the string value is parsed
+template<class T, bool numerical>
+struct Header::Value
+{
+	static T get(const Keyword& keyword)
+	{
+		T value = 0;
+		std::istringstream ss(keyword.value);
+		ss >> value;
+		return value;
+	}
+
+	static void set(Keyword& keyword, const T& value)
+	{
+		std::ostringstream ss;
+		ss << value;
+		keyword.value = ss.str();
+		keyword.parse();
+	}
+};
+
+//! Conversion of a keyword value to a numerical type, the typed slot is used
 template<class T>
-T Header::get(const std::string& key) const
+struct Header::Value<T, true>
 {
-	T value = 0;
-	std::map<std::string,std::string>::const_iterator it = keywords.find(key);
-	if(it == keywords.end())
+	static T get(const Keyword& keyword)
 	{
-		throw std::runtime_error("No keywords " + key + " in header");
+		switch(keyword.type)
+		{
+			case INTEGER:
+			case LOGICAL:
+				return T(keyword.integer);
+			case REAL:
+				return T(keyword.real);
+			default:
+				return Value<T, false>::get(keyword);
+		}
+	}
+
+	static void set(Keyword& keyword, const T& value)
+	{
+		std::ostringstream ss;
+		if(std::numeric_limits<T>::is_integer)
+		{
+			ss << value;
+			keyword.type = INTEGER;
+			keyword.integer = long(value);
+			keyword.real = double(value);
+		}
+		else
+		{
+			ss << std::fixed << std::showpoint << std::setprecision(std::numeric_limits<double>::digits10 + 2) << value;
+			keyword.type = REAL;
+			keyword.real = double(value);
+		}
+		keyword.value = ss.str();
 	}
-	else
+};
+
+template<class T>
+T Header::get(const std::string& key) const
+{
+	int k = find(key.c_str(), key.length());
+	if(k < 0)
 	{
-		std::istringstream ss(it->second);
-		ss >> value;
+		throw std::runtime_error("No keywords " + key + " in header");
 	}
-	return value;
+	return Value<T>::get(keywords[k]);
 }
 
 template<>
@@ -84,18 +210,10 @@ std::string Header::get(const std::string& key) const;
 template<class T>
 void Header::set(const std::string& key, const T& value, const std::string& comment)
 {
-	std::ostringstream ss;
-	if(typeid(T) == typeid(float) || typeid(T) == typeid(double))
-	{
-		ss << std::fixed << std::showpoint << std::setprecision(std::numeric_limits<double>::digits10 + 2) << value;
-	}
-	else
-	{
-		ss << value;
-	}
-	keywords[key] = ss.str();
+	Keyword& k = keyword(key);
+	Value<T>::set(k, value);
 	if(!comment.empty())
-		keywords_comments[key] = comment;
+		k.comment = comment;
 }
 
 template<>
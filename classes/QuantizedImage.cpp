@@ -0,0 +1,35 @@
+#include "QuantizedImage.h"
+
+using namespace std;
+
+QuantizedImage::QuantizedImage()
+:xAxes(0), yAxes(0), scale(1), zero(0), blank(0)
+{}
+
+FitsFile& QuantizedImage::readFits(FitsFile& file)
+{
+	file.readHeader(header);
+	file.readQuantizedImage(values, xAxes, yAxes, scale, zero, blank);
+	
+	// The WCS is parsed from the header as for any sun image
+	EUVImage image(header);
+	wcs = image.getWCS();
+	return file;
+}
+
+EUVImage* QuantizedImage::dequantize(EUVImage* image) const
+{
+	if(image)
+	{
+		image->resize(xAxes, yAxes);
+		image->getHeader() = header;
+		image->getWCS() = wcs;
+	}
+	else
+	{
+		image = new EUVImage(header, xAxes, yAxes);
+	}
+	for (unsigned j = 0; j < values.size(); ++j)
+		image->pixel(j) = pixel(j);
+	return image;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#ifndef QuantizedImage_H
+#define QuantizedImage_H
+
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include "constants.h"
+#include "Coordinate.h"
+#include "Header.h"
+#include "WCS.h"
+#include "FitsFile.h"
+#include "EUVImage.h"
+
+//! Class for a sun image stored quantized on 8 or 16 bits
+/*!
+The pixels are kept quantized in memory, and are converted to their real value only when they are accessed.
+A map with values between 0 and 1, like a fuzzy map, takes 4 times less memory than an EUVImage.
+
+The image must have been written by FitsFile::writeQuantizedImage, or have BSCALE/BZERO keywords.
+*/
+
+class QuantizedImage
+{
+	private :
+		//! Size of the X axes of the image
+		unsigned xAxes;
+		//! Size of the Y axes of the image
+		unsigned yAxes;
+		//! The quantized values of the pixels
+		std::vector<short> values;
+		//! Scaling of the quantized values
+		Real scale;
+		//! Offset of the quantized values
+		Real zero;
+		//! Quantized value of the null pixels
+		short blank;
+		//! The header of the image
+		Header header;
+		//! The WCS of the image
+		WCS wcs;
+
+	public :
+		//! Constructor
+		QuantizedImage();
+		
+		//! Routine to read the image from the current HDU of the fits file
+		FitsFile& readFits(FitsFile& file);
+		
+		//! Accessor to retrieve the size of the X axes
+		unsigned Xaxes() const
+		{return xAxes;}
+		
+		//! Accessor to retrieve the size of the Y axes
+		unsigned Yaxes() const
+		{return yAxes;}
+		
+		//! Accessor to retrieve the number of pixels
+		unsigned NumberPixels() const
+		{return values.size();}
+		
+		//! Accessor to retrieve the value of the pixel j
+		Real pixel(const unsigned j) const
+		{return values[j] == blank ? NAN : zero + scale * values[j];}
+		
+		//! Accessor to retrieve the value of the pixel x, y
+		Real pixel(const unsigned x, const unsigned y) const
+		{return pixel(x + y * xAxes);}
+		
+		//! Accessor to retrieve the header
+		const Header& getHeader() const
+		{return header;}
+		
+		//! Accessor to retrieve the SunCenter
+		RealPixLoc SunCenter() const
+		{return wcs.sun_center;}
+		
+		//! Accessor to retrieve the SunRadius
+		Real SunRadius() const
+		{return wcs.sun_radius;}
+		
+		//! Routine to convert all the pixels to an EUVImage
+		EUVImage* dequantize(EUVImage* image = NULL) const;
+};
+
+#endif
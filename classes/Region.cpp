@@ -1,4 +1,5 @@
 #include "Region.h"
+#include "ConnectedComponents.h"
 #include <map>
 
 using namespace std;
@@ -154,6 +155,106 @@ string Region::toString(const string& separator, bool header) const
 	}
 }
 
+bool Region::hasRuns() const
+{
+	return !runs.empty();
+}
+
+const vector<Region::Run>& Region::Runs() const
+{
+	return runs;
+}
+
+void Region::setRuns(const vector<Run>& runs)
+{
+	this->runs = runs;
+}
+
+void Region::computeRuns(const ColorMap* map)
+{
+	runs.clear();
+	if(!boxmin || !boxmax || !first)
+		return;
+	// The color of the region may not be the color of it's pixels in the map, e.g. after tracking
+	const ColorType mapColor = map->pixel(first);
+	for(unsigned y = boxmin.y; y <= boxmax.y; ++y)
+	{
+		for(unsigned x = boxmin.x; x <= boxmax.x; ++x)
+		{
+			if(map->pixel(x, y) != mapColor)
+				continue;
+			if(!runs.empty() && runs.back().y == y && runs.back().start + runs.back().length == x)
+				++runs.back().length;
+			else
+				runs.push_back(Run(y, x, 1));
+		}
+	}
+}
+
+void Region::computeRuns(const ColorRuns* footprint)
+{
+	runs.clear();
+	if(!boxmin || !boxmax || !first)
+		return;
+	const ColorType mapColor = footprint->pixel(first.x, first.y);
+	for(unsigned y = boxmin.y; y <= boxmax.y && y < footprint->Yaxes(); ++y)
+	{
+		for(vector<ColorRuns::Run>::const_iterator r = footprint->row_begin(y); r != footprint->row_end(y); ++r)
+		{
+			if(r->color != mapColor)
+				continue;
+			// We keep only the part of the run in the bounding box
+			const unsigned start = r->start > boxmin.x ? r->start : boxmin.x;
+			const unsigned end = r->start + r->length - 1 < boxmax.x ? r->start + r->length - 1 : boxmax.x;
+			if(start <= end)
+				runs.push_back(Run(y, start, end - start + 1));
+		}
+	}
+}
+
+unsigned Region::overlap(const Region& region) const
+{
+	unsigned intersectPixels = 0;
+	// The runs are sorted by row, then by start, so we can intersect them in one pass
+	vector<Run>::const_iterator r1 = runs.begin();
+	vector<Run>::const_iterator r2 = region.runs.begin();
+	while(r1 != runs.end() && r2 != region.runs.end())
+	{
+		if(r1->y < r2->y)
+		{
+			++r1;
+		}
+		else if(r2->y < r1->y)
+		{
+			++r2;
+		}
+		else
+		{
+			const unsigned end1 = r1->start + r1->length;
+			const unsigned end2 = r2->start + r2->length;
+			const unsigned start = r1->start > r2->start ? r1->start : r2->start;
+			const unsigned end = end1 < end2 ? end1 : end2;
+			if(end > start)
+				intersectPixels += end - start;
+			if(end1 < end2)
+				++r1;
+			else
+				++r2;
+		}
+	}
+	return intersectPixels;
+}
+
+void Region::recolor(ColorMap* map, const ColorType color) const
+{
+	for(vector<Run>::const_iterator r = runs.begin(); r != runs.end(); ++r)
+	{
+		ColorType* j = &(map->pixel(r->start, r->y));
+		for(unsigned l = 0; l < r->length; ++l)
+			j[l] = color;
+	}
+}
+
 inline void Region::add(const PixLoc& coordinate, const bool& atBorder, const RealPixLoc& sunCenter, const Real& sun_radius, const Real pixelLength, const Real pixelWidth)
 {
 	
@@ -224,256 +325,347 @@ inline void Region::add(const PixLoc& coordinate, const bool& atBorder, const Re
 		areaDeprojectedUncertainity += pixelAreaMm2 * areaCorrectionFactor;
 }
 
-vector<Region*> getRegions(const ColorMap* coloredMap)
+void Region::merge(const Region& part, const RealPixLoc& sunCenter)
 {
-	unsigned id = 0;
-	map<ColorType, Region*> regions;
-	
-	for (unsigned y = 0; y < coloredMap->Yaxes(); ++y)
+	if(part.numberPixels == 0)
+		return;
+	if(!first || part.first.y < first.y || (part.first.y == first.y && part.first.x < first.x))
+		first = part.first;
+	if(!boxmin)
+	{
+		boxmin = part.boxmin;
+		boxmax = part.boxmax;
+	}
+	else
+	{
+		boxmin.x = part.boxmin.x < boxmin.x ? part.boxmin.x : boxmin.x;
+		boxmin.y = part.boxmin.y < boxmin.y ? part.boxmin.y : boxmin.y;
+		boxmax.x = part.boxmax.x > boxmax.x ? part.boxmax.x : boxmax.x;
+		boxmax.y = part.boxmax.y > boxmax.y ? part.boxmax.y : boxmax.y;
+	}
+	numberPixels += part.numberPixels;
+	center.x += part.center.x;
+	center.y += part.center.y;
+	centerxError = fabs(center.x/numberPixels - sunCenter.x);
+	centeryError = fabs(center.y/numberPixels - sunCenter.y);
+	areaProjected += part.areaProjected;
+	areaProjectedUncertainity += part.areaProjectedUncertainity;
+	areaDeprojected += part.areaDeprojected;
+	areaDeprojectedUncertainity += part.areaDeprojectedUncertainity;
+	// The parts are merged in the order of the pixels
+	runs.insert(runs.end(), part.runs.begin(), part.runs.end());
+}
+
+RegionAccumulator::RegionAccumulator(const ColorMap* colorMap, const int requestedStatistics, unsigned numberThreads)
+:colorMap(colorMap), statistics(requestedStatistics & RUNS ? requestedStatistics | REGIONS : requestedStatistics)
+{
+	const unsigned yAxes = colorMap->Yaxes();
+	if(colorMap->Xaxes() == 0 || yAxes == 0)
+		return;
+	if(numberThreads > yAxes / minimalStripRows)
+		numberThreads = yAxes / minimalStripRows;
+	if(numberThreads < 1)
+		numberThreads = 1;
+
+	vector<Strip> strips(numberThreads);
+	for(unsigned s = 0; s < numberThreads; ++s)
+	{
+		strips[s].self = this;
+		strips[s].firstRow = (s * yAxes) / numberThreads;
+		strips[s].lastRow = ((s + 1) * yAxes) / numberThreads;
+	}
+	runStrips(strips, accumulateStrip);
+
+	// We merge the slots of the strips in order, so that the slots stay in the order of the first pixel
+	const RealPixLoc sunCenter = colorMap->SunCenter();
+	for(unsigned s = 0; s < strips.size(); ++s)
 	{
-		for (unsigned x = 0; x < coloredMap->Xaxes(); ++x)
+		const Slots& part = strips[s].slots;
+		for(unsigned p = 0; p < part.colors.size(); ++p)
 		{
-			if(coloredMap->pixel(x,y) != coloredMap->null())
+			map<ColorType, unsigned>::iterator c = colorSlots.find(part.colors[p]);
+			if(c == colorSlots.end())
 			{
-				const ColorType& color = coloredMap->pixel(x,y);
-				// If no region of that color exist we create it
-				if(regions.count(color) == 0)
-				{
-					regions[color] = new Region(coloredMap->ObservationTime(), id, color);
-					++id;
-				}
-				
-				// Is the pixel in the contour (<=> there is a neighboor pixel != pixel color)
-				bool atBorder = coloredMap->pixel(x-1,y) != color || coloredMap->pixel(x+1,y) != color || coloredMap->pixel(x,y-1) != color || coloredMap->pixel(x,y+1) != color;
-				
-				// We add the pixel to the region
-				regions[color]->add(PixLoc(x,y), atBorder, coloredMap->SunCenter(), coloredMap->SunRadius(), coloredMap->PixelLength(), coloredMap->PixelWidth());
+				colorSlots.insert(make_pair(part.colors[p], unsigned(slots.colors.size())));
+				slots.colors.push_back(part.colors[p]);
+				slots.numberPixels.push_back(part.numberPixels[p]);
+				if(statistics & REAL_AREA)
+					slots.realAreas.push_back(part.realAreas[p]);
+				if(statistics & REGIONS)
+					slots.regions.push_back(part.regions[p]);
+			}
+			else
+			{
+				slots.numberPixels[c->second] += part.numberPixels[p];
+				if(statistics & REAL_AREA)
+					slots.realAreas[c->second] += part.realAreas[p];
+				if(statistics & REGIONS)
+					slots.regions[c->second].merge(part.regions[p], sunCenter);
 			}
 		}
 	}
-	return values(regions);
 }
 
-vector<Region*> getRegions(const ColorMap* coloredMap, const set<ColorType>& colors)
+void* RegionAccumulator::accumulateStrip(void* arg)
 {
-	unsigned id = 0;
-	
-	map<ColorType, Region*> regions;
-	
-	for (unsigned y = 0; y < coloredMap->Yaxes(); ++y)
-	{
-		for (unsigned x = 0; x < coloredMap->Xaxes(); ++x)
+	Strip& strip = *static_cast<Strip*>(arg);
+	const ColorMap* colorMap = strip.self->colorMap;
+	const int statistics = strip.self->statistics;
+	Slots& slots = strip.slots;
+
+	const unsigned xAxes = colorMap->Xaxes();
+	const unsigned yAxes = colorMap->Yaxes();
+	const ColorType* pixels = &(colorMap->pixel(0));
+	const ColorType null = colorMap->null();
+	const time_t observationTime = colorMap->ObservationTime();
+	const RealPixLoc sunCenter = colorMap->SunCenter();
+	const Real sunRadius = colorMap->SunRadius();
+	const Real pixelLength = colorMap->PixelLength();
+	const Real pixelWidth = colorMap->PixelWidth();
+
+	map<ColorType, unsigned> colorSlots;
+	ColorType lastColor = null;
+	unsigned slot = 0;
+	for(unsigned y = strip.firstRow; y < strip.lastRow; ++y)
+	{
+		unsigned j = y * xAxes;
+		for(unsigned x = 0; x < xAxes; ++x, ++j)
 		{
-			if(coloredMap->pixel(x,y) != coloredMap->null())
+			const ColorType color = pixels[j];
+			if(color == null)
+				continue;
+			// The regions are contiguous, so we only need to search the slot when the color changes
+			if(color != lastColor)
 			{
-				const ColorType& color = coloredMap->pixel(x,y);
-				if(colors.count(color) > 1)
+				map<ColorType, unsigned>::iterator c = colorSlots.find(color);
+				if(c == colorSlots.end())
 				{
-					// If no region of that color exist we create it
-					if(regions.count(color) == 0)
-					{
-						regions[color] = new Region(coloredMap->ObservationTime(),id, color);
-						++id;
-					}
-					// Is the pixel in the contour (<=> there is a neighboor pixel != pixel color)
-					bool atBorder = coloredMap->pixel(x-1,y) != color || coloredMap->pixel(x+1,y) != color || coloredMap->pixel(x,y-1) != color || coloredMap->pixel(x,y+1) != color;
-					
-					// We add the pixel to the region
-					regions[color]->add(PixLoc(x,y), atBorder, coloredMap->SunCenter(), coloredMap->SunRadius(), coloredMap->PixelLength(), coloredMap->PixelWidth());
+					c = colorSlots.insert(make_pair(color, unsigned(slots.colors.size()))).first;
+					slots.colors.push_back(color);
+					slots.numberPixels.push_back(0);
+					if(statistics & REAL_AREA)
+						slots.realAreas.push_back(0);
+					if(statistics & REGIONS)
+						slots.regions.push_back(Region(observationTime, 0, color));
 				}
+				slot = c->second;
+				lastColor = color;
+			}
+			++slots.numberPixels[slot];
+			if(statistics & REAL_AREA)
+				slots.realAreas[slot] += colorMap->RealPixelArea(RealPixLoc(x, y));
+			if(statistics & REGIONS)
+			{
+				// Is the pixel in the contour (<=> there is a neighboor pixel != pixel color, or it is at the border of the map)
+				bool atBorder = x == 0 || x + 1 == xAxes || y == 0 || y + 1 == yAxes || pixels[j-1] != color || pixels[j+1] != color || pixels[j-xAxes] != color || pixels[j+xAxes] != color;
+				slots.regions[slot].add(PixLoc(x,y), atBorder, sunCenter, sunRadius, pixelLength, pixelWidth);
+			}
+			if(statistics & RUNS)
+			{
+				vector<Region::Run>& runs = slots.regions[slot].runs;
+				if(!runs.empty() && runs.back().y == y && runs.back().start + runs.back().length == x)
+					++runs.back().length;
+				else
+					runs.push_back(Region::Run(y, x, 1));
 			}
 		}
 	}
-	return values(regions);
+	return NULL;
 }
 
-FitsFile& writeRegions(FitsFile& file, const vector<Region*>& regions)
+unsigned RegionAccumulator::slot(const ColorType color) const
 {
-	{
-		vector<unsigned> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->Id();
-		file.writeColumn("ID", data);
-	}
-
-	{
-		vector<string> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->HekLabel();
-		file.writeColumn("HEKID", data);
-	}
-
-	{
-		vector<ColorType> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->Color();
-		file.writeColumn("COLOR", data);
-	}
-
-	{
-		vector<string> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->ObservationDate();
-		file.writeColumn("DATE_OBS", data);
-	}
-
-	{
-		vector<string> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->FirstObservationDate();
-		file.writeColumn("FIRST_DATE_OBS", data);
-	}
-
-	
-	{
-		vector<PixLoc> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->Boxmin();
-		file.writeColumn("BOXMIN", data);
-	}
-
-	{
-		vector<PixLoc> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->Boxmax();
-		file.writeColumn("BOXMAX", data);
-	}
-
-	{
-		vector<PixLoc> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->FirstPixel();
-		file.writeColumn("FIRST", data);
-	}
+	map<ColorType, unsigned>::const_iterator c = colorSlots.find(color);
+	return c == colorSlots.end() ? numberSlots() : c->second;
+}
 
+vector<Region*> RegionAccumulator::getRegions(const set<ColorType>* colors) const
+{
+	vector<Region*> regions;
+	if(!(statistics & REGIONS))
+		return regions;
+	// The ids are given in the order of the first pixel of the regions
+	vector<unsigned> ids(numberSlots(), 0);
+	unsigned id = 0;
+	for(unsigned s = 0; s < numberSlots(); ++s)
 	{
-		vector<unsigned> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->NumberPixels();
-		file.writeColumn("NUMBER_PIXELS", data);
+		if(colors == NULL || colors->count(slots.colors[s]) > 0)
+			ids[s] = id++;
 	}
-
+	// colorSlots is sorted by color
+	for(map<ColorType, unsigned>::const_iterator c = colorSlots.begin(); c != colorSlots.end(); ++c)
 	{
-		vector<RealPixLoc> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->Center();
-		file.writeColumn("CENTER", data);
+		if(colors == NULL || colors->count(c->first) > 0)
+		{
+			Region* region = new Region(slots.regions[c->second]);
+			region->setId(ids[c->second]);
+			regions.push_back(region);
+		}
 	}
+	return regions;
+}
 
-	{
-		vector<Real> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->CenterxError();
-		file.writeColumn("XCENTER_ERROR", data);
+void RegionAccumulator::erase(ColorMap* map, const vector<bool>& erased) const
+{
+	ColorType* pixels = &(map->pixel(0));
+	const ColorType null = map->null();
+	const unsigned numberPixels = map->NumberPixels();
+	ColorType lastColor = null;
+	bool erase = false;
+	for(unsigned j = 0; j < numberPixels; ++j)
+	{
+		if(pixels[j] == null)
+			continue;
+		if(pixels[j] != lastColor)
+		{
+			lastColor = pixels[j];
+			unsigned s = slot(lastColor);
+			erase = s < erased.size() && erased[s];
+		}
+		if(erase)
+			pixels[j] = null;
 	}
+}
 
-	{
-		vector<Real> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->CenteryError();
-		file.writeColumn("YCENTER_ERROR", data);
-	}
+vector<Region*> getRegions(const ColorMap* coloredMap, const bool runs)
+{
+	RegionAccumulator accumulator(coloredMap, runs ? RegionAccumulator::RUNS : RegionAccumulator::REGIONS);
+	return accumulator.getRegions();
+}
 
-	{
-		vector<Real> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->Area_Projected();
-		file.writeColumn("AREA_PROJECTED", data);
-	}
+vector<Region*> getRegions(const ColorMap* coloredMap, const set<ColorType>& colors, const bool runs)
+{
+	RegionAccumulator accumulator(coloredMap, runs ? RegionAccumulator::RUNS : RegionAccumulator::REGIONS);
+	return accumulator.getRegions(&colors);
+}
 
-	{
-		vector<Real> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->Area_Projected_Uncertainity();
-		file.writeColumn("AREA_PROJECTED_UNCERTAINITY", data);
-	}
+FitsFile& writeRegions(FitsFile& file, const vector<Region*>& regions)
+{
+	FitsTable table(regions.size());
+	vector<unsigned>& id = table.column<unsigned>("ID");
+	vector<string>& hekid = table.column<string>("HEKID");
+	vector<ColorType>& color = table.column<ColorType>("COLOR");
+	vector<string>& date_obs = table.column<string>("DATE_OBS");
+	vector<string>& first_date_obs = table.column<string>("FIRST_DATE_OBS");
+	vector<PixLoc>& boxmin = table.column<PixLoc>("BOXMIN");
+	vector<PixLoc>& boxmax = table.column<PixLoc>("BOXMAX");
+	vector<PixLoc>& first = table.column<PixLoc>("FIRST");
+	vector<unsigned>& number_pixels = table.column<unsigned>("NUMBER_PIXELS");
+	vector<RealPixLoc>& center = table.column<RealPixLoc>("CENTER");
+	vector<Real>& xcenter_error = table.column<Real>("XCENTER_ERROR");
+	vector<Real>& ycenter_error = table.column<Real>("YCENTER_ERROR");
+	vector<Real>& area_projected = table.column<Real>("AREA_PROJECTED");
+	vector<Real>& area_projected_uncertainity = table.column<Real>("AREA_PROJECTED_UNCERTAINITY");
+	vector<Real>& area_deprojected = table.column<Real>("AREA_DEPROJECTED");
+	vector<Real>& area_deprojected_uncertainity = table.column<Real>("AREA_DEPROJECTED_UNCERTAINITY");
+
+	for(unsigned r = 0; r < regions.size(); ++r)
+	{
+		id[r] = regions[r]->Id();
+		hekid[r] = regions[r]->HekLabel();
+		color[r] = regions[r]->Color();
+		date_obs[r] = regions[r]->ObservationDate();
+		first_date_obs[r] = regions[r]->FirstObservationDate();
+		boxmin[r] = regions[r]->Boxmin();
+		boxmax[r] = regions[r]->Boxmax();
+		first[r] = regions[r]->FirstPixel();
+		number_pixels[r] = regions[r]->NumberPixels();
+		center[r] = regions[r]->Center();
+		xcenter_error[r] = regions[r]->CenterxError();
+		ycenter_error[r] = regions[r]->CenteryError();
+		area_projected[r] = regions[r]->Area_Projected();
+		area_projected_uncertainity[r] = regions[r]->Area_Projected_Uncertainity();
+		area_deprojected[r] = regions[r]->Area_Deprojected();
+		area_deprojected_uncertainity[r] = regions[r]->Area_Deprojected_Uncertainity();
+	}
+
+	return file.writeColumns(table);
+}
 
-	{
-		vector<Real> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->Area_Deprojected();
-		file.writeColumn("AREA_DEPROJECTED", data);
-	}
+FitsFile& readRegions(FitsFile& file, vector<Region*>& regions, bool getTrackedColors)
+{
+	FitsTable table;
+	vector<unsigned>& id = table.column<unsigned>("ID");
+	// If there is no tracked color, the color is set to 0
+	vector<ColorType>& color = table.column<ColorType>(getTrackedColors ? "TRACKED_COLOR" : "COLOR");
+	vector<string>& date_obs = table.column<string>("DATE_OBS");
+	vector<string>& first_date_obs = table.column<string>("FIRST_DATE_OBS");
+	vector<PixLoc>& boxmin = table.column<PixLoc>("BOXMIN");
+	vector<PixLoc>& boxmax = table.column<PixLoc>("BOXMAX");
+	vector<PixLoc>& first = table.column<PixLoc>("FIRST");
+	file.readColumns(table);
 
-	{
-		vector<Real> data(regions.size());
-		for(unsigned r = 0; r < regions.size(); ++r)
-			data[r] = regions[r]->Area_Deprojected_Uncertainity();
-		file.writeColumn("AREA_DEPROJECTED_UNCERTAINITY", data);
+	// We augment the regions vector
+	regions.reserve(regions.size() + id.size());
+	for(unsigned i = 0; i < id.size(); ++i)
+	{
+		Region* region = new Region(id[i]);
+		if(i < color.size())
+			region->color = color[i];
+		else if(getTrackedColors)
+			region->color = 0;
+		if(i < date_obs.size())
+			region->observationTime = iso2ctime(date_obs[i]);
+		if(i < first_date_obs.size())
+			region->firstObservationTime = iso2ctime(first_date_obs[i]);
+		if(i < boxmin.size())
+			region->boxmin = boxmin[i];
+		if(i < boxmax.size())
+			region->boxmax = boxmax[i];
+		if(i < first.size())
+			region->first = first[i];
+		regions.push_back(region);
 	}
 
 	return file;
 }
 
-FitsFile& readRegions(FitsFile& file, vector<Region*>& regions, bool getTrackedColors)
+FitsFile& writeRegionRuns(FitsFile& file, const vector<Region*>& regions)
 {
-	// We augment the regions vector
-	int firstRegion = regions.size();
-	{
-		vector<unsigned> data;
-		file.readColumn("ID", data);
-		for(unsigned i = 0; i < data.size(); ++i)
-			regions.push_back(new Region(data[i]));
-		
-	}
-	if(getTrackedColors)
+	FitsTable table;
+	vector<unsigned>& id = table.column<unsigned>("ID");
+	vector<PixLoc>& start = table.column<PixLoc>("START");
+	vector<unsigned>& length = table.column<unsigned>("LENGTH");
+
+	for(unsigned r = 0; r < regions.size(); ++r)
 	{
-		if(file.find_column("TRACKED_COLOR"))
-		{
-			vector<unsigned> data;
-			file.readColumn("TRACKED_COLOR", data);
-			for(unsigned r = firstRegion, i = 0; r < regions.size() && i < data.size(); ++r, ++i)
-				regions[r]->color = data[i];
-		}
-		else
+		const vector<Region::Run>& runs = regions[r]->Runs();
+		for(unsigned i = 0; i < runs.size(); ++i)
 		{
-			for(unsigned r = firstRegion; r < regions.size(); ++r)
-				regions[r]->color = 0;
+			id.push_back(regions[r]->Id());
+			start.push_back(PixLoc(runs[i].start, runs[i].y));
+			length.push_back(runs[i].length);
 		}
 	}
-	else
-	{
-		vector<unsigned> data;
-		file.readColumn("COLOR", data);
-		for(unsigned r = firstRegion, i = 0; r < regions.size() && i < data.size(); ++r, ++i)
-			regions[r]->color = data[i];
-	}
+	table.resize(id.size());
+	file.writeColumns(table);
+	return file;
+}
 
+FitsFile& readRegionRuns(FitsFile& file, vector<Region*>& regions)
+{
+	FitsTable table;
+	vector<unsigned>& id = table.column<unsigned>("ID");
+	vector<PixLoc>& start = table.column<PixLoc>("START");
+	vector<unsigned>& length = table.column<unsigned>("LENGTH");
+	file.readColumns(table);
+	if(start.size() != id.size() || length.size() != id.size())
 	{
-		vector<string> data;
-		file.readColumn("DATE_OBS", data);
-		for(unsigned r = firstRegion, i = 0; r < regions.size() && i < data.size(); ++r, ++i)
-			regions[r]->observationTime = iso2ctime(data[i]);
-	}
-	
-	{
-		vector<string> data;
-		file.readColumn("FIRST_DATE_OBS", data);
-		for(unsigned r = firstRegion, i = 0; r < regions.size() && i < data.size(); ++r, ++i)
-			regions[r]->firstObservationTime = iso2ctime(data[i]);
+		cerr<<"Error : the table of runs of regions is missing columns"<<endl;
+		return file;
 	}
 
+	map<unsigned, vector<Region::Run> > runs;
+	for(unsigned i = 0; i < id.size(); ++i)
 	{
-		vector<PixLoc> data;
-		file.readColumn("BOXMIN", data);
-		for(unsigned r = firstRegion, i = 0; r < regions.size() && i < data.size(); ++r, ++i)
-			regions[r]->boxmin = data[i];
+		runs[id[i]].push_back(Region::Run(start[i].y, start[i].x, length[i]));
 	}
-	
+	for(unsigned r = 0; r < regions.size(); ++r)
 	{
-		vector<PixLoc> data;
-		file.readColumn("BOXMAX", data);
-		for(unsigned r = firstRegion, i = 0; r < regions.size() && i < data.size(); ++r, ++i)
-			regions[r]->boxmax = data[i];
+		map<unsigned, vector<Region::Run> >::iterator it = runs.find(regions[r]->Id());
+		if(it != runs.end())
+			regions[r]->setRuns(it->second);
 	}
-
-	{
-		vector<PixLoc> data;
-		file.readColumn("FIRST", data);
-		for(unsigned r = firstRegion, i = 0; r < regions.size() && i < data.size(); ++r, ++i)
-			regions[r]->first = data[i];
-	}
-
 	return file;
 }
 
@@ -513,6 +705,16 @@ vector<PixLoc> Region::chainCode(const ColorMap* image, const unsigned min_point
 	
 	// We search the left most pixel on the external border
 	PixLoc firstPixel = PixLoc(boxmin.x, boxmax.y);
+	// With the runs, it is the start of the highest run that starts on the left most column
+	if(hasRuns())
+	{
+		firstPixel = PixLoc(runs.front().start, runs.front().y);
+		for(vector<Run>::const_iterator r = runs.begin(); r != runs.end(); ++r)
+		{
+			if(r->start < firstPixel.x || (r->start == firstPixel.x && r->y > firstPixel.y))
+				firstPixel = PixLoc(r->start, r->y);
+		}
+	}
 	while(image->pixel(firstPixel) != color)
 	{
 		if(firstPixel.y == boxmin.y)
@@ -8,17 +8,36 @@
 #include <ctime>
 #include <string>
 #include <set>
+#include <map>
+#include <vector>
 
 #include "constants.h"
 #include "tools.h"
 #include "Coordinate.h"
 #include "ColorMap.h"
+#include "ColorRuns.h"
 #include "FitsFile.h"
 
 //! Class to obtain information about the position in space and time of a region
 
 class Region
 {
+	public :
+		//! A run of pixels of the region in a row
+		struct Run
+		{
+			//! Row of the run
+			unsigned y;
+			//! Position in the row of the first pixel of the run
+			unsigned start;
+			//! Number of pixels of the run
+			unsigned length;
+
+			Run(const unsigned y = 0, const unsigned start = 0, const unsigned length = 0)
+			:y(y), start(start), length(length)
+			{}
+		};
+
 	protected :
 		//! Unique and invariable identifier for a region at time observationTime
 		unsigned id;
@@ -50,6 +69,10 @@ class Region
 		//! Accumulators to compute the area and the errors
 		Real centerxError, centeryError, areaProjected, areaProjectedUncertainity, areaDeprojected, areaDeprojectedUncertainity;
 		
+		//! The runs of pixels of the region, in the order of the pixels
+		/*! They are optional, and only computed on request (cf. getRegions) */
+		std::vector<Run> runs;
+		
 	public :
 		//! Constructor
 		Region(const unsigned id = 0);
@@ -130,26 +153,142 @@ class Region
 		//! Routine to update a region with a new pixel coordinate
 		void add(const PixLoc& coordinate, const bool& atBorder, const RealPixLoc& sunCenter, const Real& sun_radius, const Real pixelLength, const Real pixelWidth);
 		
+		//! Routine to add the pixels of another part of the same region (e.g. accumulated on another part of the map)
+		void merge(const Region& part, const RealPixLoc& sunCenter);
+		
+		//! Test if the runs of pixels of the region are known
+		bool hasRuns() const;
+		
+		//! Accessor to retrieve the runs of pixels of the region
+		const std::vector<Run>& Runs() const;
+		
+		//! Accessor to set the runs of pixels of the region, they must be in the order of the pixels
+		void setRuns(const std::vector<Run>& runs);
+		
+		//! Routine to compute the runs of pixels of the region from a map
+		/*! The pixels of the region are the pixels of the bounding box with the color of the first pixel in map, so the region may have been recolored */
+		void computeRuns(const ColorMap* map);
+		
+		//! Routine to compute the runs of pixels of the region from the runs of a map
+		/*! Same as computeRuns(const ColorMap*), without decoding the map */
+		void computeRuns(const ColorRuns* footprint);
+		
+		//! Return the number of pixels common to the runs of this region and of region
+		unsigned overlap(const Region& region) const;
+		
+		//! Routine to set the pixels of the runs of the region to color in map
+		void recolor(ColorMap* map, const ColorType color) const;
+		
 		//! Routine that generate a chaincode for the connected component indicated by firstPixel
 		std::vector<PixLoc> chainCode(const ColorMap* image, const unsigned min_points, const unsigned max_points, Real max_deviation = 0.) const;
 
 	public :
 		friend FitsFile& readRegions(FitsFile& file, std::vector<Region*>& regions, bool getTrackedColors);
+		friend class RegionAccumulator;
+
+};
+
+//! Class that accumulates the statistics of the regions of a ColorMap in one pass over the map
+/*!
+Each color found in the map is given a slot, in the order of the first pixel of the color.
+The color of a pixel is looked up only when it differs from the previous pixel, the statistics are then accumulated in flat arrays indexed by the slot.
+
+The map is split in strips of rows that are accumulated in parallel, each strip has it's own slots, that are merged in the order of the strips.
+
+The statistics to compute are selected with a combination of the Statistics flags, the number of pixels is always computed.
+*/
+class RegionAccumulator
+{
+	public :
+		//! The statistics that can be accumulated
+		/*! RUNS also accumulates the runs of pixels of the regions, it implies REGIONS */
+		enum Statistics {NUMBER_PIXELS = 0, REAL_AREA = 1, REGIONS = 2, RUNS = 4};
+
+	private :
+		//! The statistics accumulated for a part of the map
+		struct Slots
+		{
+			std::vector<ColorType> colors;
+			std::vector<unsigned> numberPixels;
+			std::vector<Real> realAreas;
+			std::vector<Region> regions;
+		};
+
+		//! A strip of rows accumulated by one thread
+		struct Strip
+		{
+			const RegionAccumulator* self;
+			unsigned firstRow;
+			unsigned lastRow;
+			Slots slots;
+		};
+
+		//! The map of the regions
+		const ColorMap* colorMap;
+		//! The statistics to compute
+		int statistics;
+		//! The statistics of the whole map
+		Slots slots;
+		//! The slot of each color
+		std::map<ColorType, unsigned> colorSlots;
+
+		//! Thread routine that accumulates a strip
+		static void* accumulateStrip(void* strip);
+
+	public :
+		//! Constructor, accumulates the statistics of the regions of map
+		RegionAccumulator(const ColorMap* map, const int statistics = NUMBER_PIXELS, unsigned numberThreads = NUMBER_THREADS);
 
+		//! Return the number of slots (i.e. of colors in the map)
+		unsigned numberSlots() const
+		{
+			return slots.colors.size();
+		}
+
+		//! Return the slot of color, or numberSlots() if the color is not in the map
+		unsigned slot(const ColorType color) const;
+
+		//! Return the color of the slot
+		ColorType color(const unsigned s) const
+		{
+			return slots.colors[s];
+		}
+
+		//! Return the number of pixels of the slot
+		unsigned numberPixels(const unsigned s) const
+		{
+			return slots.numberPixels[s];
+		}
+
+		//! Return the sum of the real area (cf. SunImage::RealPixelArea) of the pixels of the slot, only if REAL_AREA was accumulated
+		Real realArea(const unsigned s) const
+		{
+			return slots.realAreas[s];
+		}
+
+		//! Return a new Region for each slot whose color is in colors (all slots if colors is NULL), only if REGIONS was accumulated
+		/*! The regions are sorted by color, their id is given in the order of their first pixel */
+		std::vector<Region*> getRegions(const std::set<ColorType>* colors = NULL) const;
+
+		//! Routine to set to null the pixels of the slots that are erased
+		/*! The map must be the one that was accumulated */
+		void erase(ColorMap* map, const std::vector<bool>& erased) const;
 };
 
 //! Extraction of the regions from a ColorMap
 /*
 @param map A map of the region, each one must have a different color
+@param runs If the runs of pixels of the regions must be extracted
 */
-std::vector<Region*> getRegions(const ColorMap* coloredMap);
+std::vector<Region*> getRegions(const ColorMap* coloredMap, const bool runs = false);
 
 //! Extraction of the regions from a ColorMap
 /*
 @param map A map of the region, each one must have a different color
 @param colors The regions color for which to compute the stats
+@param runs If the runs of pixels of the regions must be extracted
 */
-std::vector<Region*> getRegions(const ColorMap* coloredMap, const std::set<ColorType>& colors);
+std::vector<Region*> getRegions(const ColorMap* coloredMap, const std::set<ColorType>& colors, const bool runs = false);
 
 //! Write the regions into a fits file as column into the current table
 FitsFile& writeRegions(FitsFile& file, const std::vector<Region*>& regions);
@@ -157,4 +296,11 @@ FitsFile& writeRegions(FitsFile& file, const std::vector<Region*>& regions);
 //! Read the regions from the fits file current table
 FitsFile& readRegions(FitsFile& file, std::vector<Region*>& regions, bool getTrackedColors = false);
 
+//! Write the runs of pixels of the regions into a fits file as column into the current table
+/*! The table has one row per run, with the columns ID, XSTART, YSTART and LENGTH */
+FitsFile& writeRegionRuns(FitsFile& file, const std::vector<Region*>& regions);
+
+//! Read the runs of pixels of the regions from the fits file current table, the runs are matched to the regions by their id
+FitsFile& readRegionRuns(FitsFile& file, std::vector<Region*>& regions);
+
 #endif
@@ -320,6 +320,30 @@ vector<RegionStats*> getRegionStats(const ColorMap* coloredMap, const EUVImage*
 	RealPixLoc sunCenter = image->SunCenter();
 	Real sunRadius = image->SunRadius();
 	
+	// If we have the runs of all the regions, we only scan their pixels
+	bool runs = true;
+	for(unsigned r = 0; r < regions.size() && runs; ++r)
+		runs = regions[r]->hasRuns();
+	if(runs)
+	{
+		for(unsigned r = 0; r < regions.size(); ++r)
+		{
+			const ColorType color = regions[r]->Color();
+			RegionStats* stats = regions_stats[color];
+			const vector<Region::Run>& region_runs = regions[r]->Runs();
+			for(vector<Region::Run>::const_iterator run = region_runs.begin(); run != region_runs.end(); ++run)
+			{
+				const unsigned y = run->y;
+				for (unsigned x = run->start; x < run->start + run->length; ++x)
+				{
+					bool atBorder = coloredMap->pixel(x-1,y) != color || coloredMap->pixel(x+1,y) != color || coloredMap->pixel(x,y-1) != color || coloredMap->pixel(x,y+1) != color;
+					stats->add(PixLoc(x,y), image->pixel(x, y), sunCenter, atBorder, sunRadius);
+				}
+			}
+		}
+		return values(regions_stats);
+	}
+	
 	for (unsigned y = 0; y < coloredMap->Yaxes(); ++y)
 	{
 		for (unsigned x = 0; x < coloredMap->Xaxes(); ++x)
@@ -411,167 +435,57 @@ vector<SegmentationStats*> getTotalRegionStats(const ColorMap* coloredMap, const
 
 FitsFile& writeRegions(FitsFile& file, const vector<RegionStats*>& regions_stats)
 {
-	{
-		vector<unsigned> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Id();
-		file.writeColumn("ID", data);
-	}
-	
-	{
-		vector<string> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->ObservationDate();
-		file.writeColumn("DATE_OBS", data);
-	}
-	
-	{
-		vector<unsigned> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->NumberPixels();
-		file.writeColumn("NUMBER_PIXELS", data);
-	}
-
-	{
-		vector<unsigned> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->NumberGoodPixels();
-		file.writeColumn("NUMBER_GOOD_PIXELS", data);
-	}
-
-	{
-		vector<RealPixLoc> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Center();
-		file.writeColumn("CENTER", data);
-	}
-	
-	{
-		vector<RealPixLoc> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Barycenter();
-		file.writeColumn("BARYCENTER", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->MinIntensity();
-		file.writeColumn("MIN_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->MaxIntensity();
-		file.writeColumn("MAX_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Mean();
-		file.writeColumn("MEAN_INTENSITY", data);
-	}
-	
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Median();
-		file.writeColumn("MEDIAN_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->LowerQuartile();
-		file.writeColumn("LOWERQUARTILE_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->UpperQuartile();
-		file.writeColumn("UPPERQUARTILE_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Variance();
-		file.writeColumn("VARIANCE", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Skewness();
-		file.writeColumn("SKEWNESS", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Kurtosis();
-		file.writeColumn("KURTOSIS", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->TotalIntensity();
-		file.writeColumn("TOTAL_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->CenterxError();
-		file.writeColumn("XCENTER_ERROR", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->CenteryError();
-		file.writeColumn("YCENTER_ERROR", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Area_Raw();
-		file.writeColumn("RAW_AREA", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Area_RawUncert();
-		file.writeColumn("RAW_AREA_UNCERTAINITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Area_AtDiskCenter();
-		file.writeColumn("AREA_ATDISKCENTER", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->Area_AtDiskCenterUncert();
-		file.writeColumn("AREA_ATDISKCENTER_UNCERTAINITY", data);
-	}
-	
-	{
-		vector<string> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r]->ClippedSpatial() ? "T" : "F";
-		file.writeColumn("CLIPPED_SPATIAL", data);
-	}
-	
-	return file;
-
+	FitsTable table(regions_stats.size());
+	vector<unsigned>& id = table.column<unsigned>("ID");
+	vector<string>& date_obs = table.column<string>("DATE_OBS");
+	vector<unsigned>& number_pixels = table.column<unsigned>("NUMBER_PIXELS");
+	vector<unsigned>& number_good_pixels = table.column<unsigned>("NUMBER_GOOD_PIXELS");
+	vector<RealPixLoc>& center = table.column<RealPixLoc>("CENTER");
+	vector<RealPixLoc>& barycenter = table.column<RealPixLoc>("BARYCENTER");
+	vector<Real>& min_intensity = table.column<Real>("MIN_INTENSITY");
+	vector<Real>& max_intensity = table.column<Real>("MAX_INTENSITY");
+	vector<Real>& mean_intensity = table.column<Real>("MEAN_INTENSITY");
+	vector<Real>& median_intensity = table.column<Real>("MEDIAN_INTENSITY");
+	vector<Real>& lowerquartile_intensity = table.column<Real>("LOWERQUARTILE_INTENSITY");
+	vector<Real>& upperquartile_intensity = table.column<Real>("UPPERQUARTILE_INTENSITY");
+	vector<Real>& variance = table.column<Real>("VARIANCE");
+	vector<Real>& skewness = table.column<Real>("SKEWNESS");
+	vector<Real>& kurtosis = table.column<Real>("KURTOSIS");
+	vector<Real>& total_intensity = table.column<Real>("TOTAL_INTENSITY");
+	vector<Real>& xcenter_error = table.column<Real>("XCENTER_ERROR");
+	vector<Real>& ycenter_error = table.column<Real>("YCENTER_ERROR");
+	vector<Real>& raw_area = table.column<Real>("RAW_AREA");
+	vector<Real>& raw_area_uncertainity = table.column<Real>("RAW_AREA_UNCERTAINITY");
+	vector<Real>& area_atdiskcenter = table.column<Real>("AREA_ATDISKCENTER");
+	vector<Real>& area_atdiskcenter_uncertainity = table.column<Real>("AREA_ATDISKCENTER_UNCERTAINITY");
+	vector<string>& clipped_spatial = table.column<string>("CLIPPED_SPATIAL");
+
+	for(unsigned r = 0; r < regions_stats.size(); ++r)
+	{
+		id[r] = regions_stats[r]->Id();
+		date_obs[r] = regions_stats[r]->ObservationDate();
+		number_pixels[r] = regions_stats[r]->NumberPixels();
+		number_good_pixels[r] = regions_stats[r]->NumberGoodPixels();
+		center[r] = regions_stats[r]->Center();
+		barycenter[r] = regions_stats[r]->Barycenter();
+		min_intensity[r] = regions_stats[r]->MinIntensity();
+		max_intensity[r] = regions_stats[r]->MaxIntensity();
+		mean_intensity[r] = regions_stats[r]->Mean();
+		median_intensity[r] = regions_stats[r]->Median();
+		lowerquartile_intensity[r] = regions_stats[r]->LowerQuartile();
+		upperquartile_intensity[r] = regions_stats[r]->UpperQuartile();
+		variance[r] = regions_stats[r]->Variance();
+		skewness[r] = regions_stats[r]->Skewness();
+		kurtosis[r] = regions_stats[r]->Kurtosis();
+		total_intensity[r] = regions_stats[r]->TotalIntensity();
+		xcenter_error[r] = regions_stats[r]->CenterxError();
+		ycenter_error[r] = regions_stats[r]->CenteryError();
+		raw_area[r] = regions_stats[r]->Area_Raw();
+		raw_area_uncertainity[r] = regions_stats[r]->Area_RawUncert();
+		area_atdiskcenter[r] = regions_stats[r]->Area_AtDiskCenter();
+		area_atdiskcenter_uncertainity[r] = regions_stats[r]->Area_AtDiskCenterUncert();
+		clipped_spatial[r] = regions_stats[r]->ClippedSpatial() ? "T" : "F";
+	}
+
+	return file.writeColumns(table);
 }
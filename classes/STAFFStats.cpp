@@ -252,6 +252,25 @@ vector<STAFFStats*> getSTAFFStats(const ColorMap* coloredMap, const EUVImage* im
 	RealPixLoc sunCenter = coloredMap->SunCenter();
 	Real sunRadius = coloredMap->SunRadius();
 	
+	// If we have the runs of all the regions, we only scan their pixels
+	bool runs = true;
+	for(unsigned r = 0; r < regions.size() && runs; ++r)
+		runs = regions[r]->hasRuns();
+	if(runs)
+	{
+		for(unsigned r = 0; r < regions.size(); ++r)
+		{
+			STAFFStats* stats = regions_stats[regions[r]->Color()];
+			const vector<Region::Run>& region_runs = regions[r]->Runs();
+			for(vector<Region::Run>::const_iterator run = region_runs.begin(); run != region_runs.end(); ++run)
+			{
+				for (unsigned x = run->start; x < run->start + run->length; ++x)
+					stats->add(PixLoc(x,run->y), image->pixel(x, run->y), sunCenter, sunRadius);
+			}
+		}
+		return values(regions_stats);
+	}
+	
 	for (unsigned y = 0; y < coloredMap->Yaxes(); ++y)
 	{
 		for (unsigned x = 0; x < coloredMap->Xaxes(); ++x)
@@ -348,110 +367,41 @@ vector<STAFFStats> getSTAFFStats(const ColorMap* CHMap, ColorType CHClass, const
 
 FitsFile& writeRegions(FitsFile& file, const vector<STAFFStats>& regions_stats)
 {
+	FitsTable table(regions_stats.size());
+	vector<unsigned>& id = table.column<unsigned>("ID");
+	vector<string>& date_obs = table.column<string>("DATE_OBS");
+	vector<Real>& min_intensity = table.column<Real>("MIN_INTENSITY");
+	vector<Real>& max_intensity = table.column<Real>("MAX_INTENSITY");
+	vector<Real>& mean_intensity = table.column<Real>("MEAN_INTENSITY");
+	vector<Real>& median_intensity = table.column<Real>("MEDIAN_INTENSITY");
+	vector<Real>& lowerquartile_intensity = table.column<Real>("LOWERQUARTILE_INTENSITY");
+	vector<Real>& upperquartile_intensity = table.column<Real>("UPPERQUARTILE_INTENSITY");
+	vector<Real>& variance = table.column<Real>("VARIANCE");
+	vector<Real>& skewness = table.column<Real>("SKEWNESS");
+	vector<Real>& kurtosis = table.column<Real>("KURTOSIS");
+	vector<Real>& total_intensity = table.column<Real>("TOTAL_INTENSITY");
+	vector<Real>& raw_area = table.column<Real>("RAW_AREA");
+	vector<Real>& area_atdiskcenter = table.column<Real>("AREA_ATDISKCENTER");
+	vector<Real>& filling_factor = table.column<Real>("FILLING_FACTOR");
+
+	for(unsigned r = 0; r < regions_stats.size(); ++r)
 	{
-		vector<unsigned> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].Id();
-		file.writeColumn("ID", data);
-	}
-	
-	{
-		vector<string> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].ObservationDate();
-		file.writeColumn("DATE_OBS", data);
-	}
-	
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].MinIntensity();
-		file.writeColumn("MIN_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].MaxIntensity();
-		file.writeColumn("MAX_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].Mean();
-		file.writeColumn("MEAN_INTENSITY", data);
-	}
-	
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].Median();
-		file.writeColumn("MEDIAN_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].LowerQuartile();
-		file.writeColumn("LOWERQUARTILE_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].UpperQuartile();
-		file.writeColumn("UPPERQUARTILE_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].Variance();
-		file.writeColumn("VARIANCE", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].Skewness();
-		file.writeColumn("SKEWNESS", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].Kurtosis();
-		file.writeColumn("KURTOSIS", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].TotalIntensity();
-		file.writeColumn("TOTAL_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].Area_Raw();
-		file.writeColumn("RAW_AREA", data);
-	}
-
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].Area_AtDiskCenter();
-		file.writeColumn("AREA_ATDISKCENTER", data);
-	}
-	
-	{
-		vector<Real> data(regions_stats.size());
-		for(unsigned r = 0; r < regions_stats.size(); ++r)
-			data[r] = regions_stats[r].FillingFactor();
-		file.writeColumn("FILLING_FACTOR", data);
+		id[r] = regions_stats[r].Id();
+		date_obs[r] = regions_stats[r].ObservationDate();
+		min_intensity[r] = regions_stats[r].MinIntensity();
+		max_intensity[r] = regions_stats[r].MaxIntensity();
+		mean_intensity[r] = regions_stats[r].Mean();
+		median_intensity[r] = regions_stats[r].Median();
+		lowerquartile_intensity[r] = regions_stats[r].LowerQuartile();
+		upperquartile_intensity[r] = regions_stats[r].UpperQuartile();
+		variance[r] = regions_stats[r].Variance();
+		skewness[r] = regions_stats[r].Skewness();
+		kurtosis[r] = regions_stats[r].Kurtosis();
+		total_intensity[r] = regions_stats[r].TotalIntensity();
+		raw_area[r] = regions_stats[r].Area_Raw();
+		area_atdiskcenter[r] = regions_stats[r].Area_AtDiskCenter();
+		filling_factor[r] = regions_stats[r].FillingFactor();
 	}
 
-	return file;
+	return file.writeColumns(table);
 }
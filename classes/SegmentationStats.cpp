@@ -319,118 +319,43 @@ vector<SegmentationStats*> getSegmentationStats(const ColorMap* coloredMap, cons
 
 FitsFile& writeRegions(FitsFile& file, const vector<SegmentationStats*>& segmentation_stats)
 {
+	FitsTable table(segmentation_stats.size());
+	vector<unsigned>& id = table.column<unsigned>("ID");
+	vector<string>& date_obs = table.column<string>("DATE_OBS");
+	vector<unsigned>& number_pixels = table.column<unsigned>("NUMBER_PIXELS");
+	vector<Real>& min_intensity = table.column<Real>("MIN_INTENSITY");
+	vector<Real>& max_intensity = table.column<Real>("MAX_INTENSITY");
+	vector<Real>& mean_intensity = table.column<Real>("MEAN_INTENSITY");
+	vector<Real>& median_intensity = table.column<Real>("MEDIAN_INTENSITY");
+	vector<Real>& lowerquartile_intensity = table.column<Real>("LOWERQUARTILE_INTENSITY");
+	vector<Real>& upperquartile_intensity = table.column<Real>("UPPERQUARTILE_INTENSITY");
+	vector<Real>& variance = table.column<Real>("VARIANCE");
+	vector<Real>& skewness = table.column<Real>("SKEWNESS");
+	vector<Real>& kurtosis = table.column<Real>("KURTOSIS");
+	vector<Real>& total_intensity = table.column<Real>("TOTAL_INTENSITY");
+	vector<Real>& raw_area = table.column<Real>("RAW_AREA");
+	vector<Real>& area_atdiskcenter = table.column<Real>("AREA_ATDISKCENTER");
+	vector<Real>& filling_factor = table.column<Real>("FILLING_FACTOR");
+
+	for(unsigned r = 0; r < segmentation_stats.size(); ++r)
 	{
-		vector<unsigned> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->Id();
-		file.writeColumn("ID", data);
+		id[r] = segmentation_stats[r]->Id();
+		date_obs[r] = segmentation_stats[r]->ObservationDate();
+		number_pixels[r] = segmentation_stats[r]->NumberPixels();
+		min_intensity[r] = segmentation_stats[r]->MinIntensity();
+		max_intensity[r] = segmentation_stats[r]->MaxIntensity();
+		mean_intensity[r] = segmentation_stats[r]->Mean();
+		median_intensity[r] = segmentation_stats[r]->Median();
+		lowerquartile_intensity[r] = segmentation_stats[r]->LowerQuartile();
+		upperquartile_intensity[r] = segmentation_stats[r]->UpperQuartile();
+		variance[r] = segmentation_stats[r]->Variance();
+		skewness[r] = segmentation_stats[r]->Skewness();
+		kurtosis[r] = segmentation_stats[r]->Kurtosis();
+		total_intensity[r] = segmentation_stats[r]->TotalIntensity();
+		raw_area[r] = segmentation_stats[r]->Area_Raw();
+		area_atdiskcenter[r] = segmentation_stats[r]->Area_AtDiskCenter();
+		filling_factor[r] = segmentation_stats[r]->FillingFactor();
 	}
-	
-	{
-		vector<string> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->ObservationDate();
-		file.writeColumn("DATE_OBS", data);
-	}
-	
-	{
-		vector<unsigned> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->NumberPixels();
-		file.writeColumn("NUMBER_PIXELS", data);
-	}
-	
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->MinIntensity();
-		file.writeColumn("MIN_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->MaxIntensity();
-		file.writeColumn("MAX_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->Mean();
-		file.writeColumn("MEAN_INTENSITY", data);
-	}
-	
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->Median();
-		file.writeColumn("MEDIAN_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->LowerQuartile();
-		file.writeColumn("LOWERQUARTILE_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->UpperQuartile();
-		file.writeColumn("UPPERQUARTILE_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->Variance();
-		file.writeColumn("VARIANCE", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->Skewness();
-		file.writeColumn("SKEWNESS", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->Kurtosis();
-		file.writeColumn("KURTOSIS", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->TotalIntensity();
-		file.writeColumn("TOTAL_INTENSITY", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->Area_Raw();
-		file.writeColumn("RAW_AREA", data);
-	}
-
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->Area_AtDiskCenter();
-		file.writeColumn("AREA_ATDISKCENTER", data);
-	}
-	
-	{
-		vector<Real> data(segmentation_stats.size());
-		for(unsigned r = 0; r < segmentation_stats.size(); ++r)
-			data[r] = segmentation_stats[r]->FillingFactor();
-		file.writeColumn("FILLING_FACTOR", data);
-	}
-	
-	return file;
 
+	return file.writeColumns(table);
 }
@@ -0,0 +1,70 @@
+#include "ShapeCache.h"
+#include "ColorMap.h"
+
+using namespace std;
+
+ShapeCache::ShapeCache(ColorMap* map, const unsigned cellSize)
+:geometry(NULL), xAxes(map->Xaxes()), yAxes(map->Yaxes()), cellSize(cellSize > 0 ? cellSize : 1)
+{
+	// The shapes are computed with b0 disabled
+	WCS wcs = map->getWCS();
+	wcs.cos_b0 = 1;
+	wcs.sin_b0 = 0;
+	geometry = new ColorMap(wcs);
+	xCells = (xAxes + this->cellSize - 1) / this->cellSize;
+	yCells = (yAxes + this->cellSize - 1) / this->cellSize;
+}
+
+ShapeCache::~ShapeCache()
+{
+	delete geometry;
+}
+
+void ShapeCache::computeShape(const PixLoc& center, const vector<HCC>& line, Shape& shape)
+{
+	shape.clear();
+	vector<PixLoc> pixels = geometry->get_shape(center, line);
+	// The pixels of get_shape are already ordered in rows
+	for(unsigned p = 0; p < pixels.size(); ++p)
+	{
+		int dy = int(pixels[p].y) - int(center.y);
+		int dx = int(pixels[p].x) - int(center.x);
+		if(!shape.empty() && shape.back().dy == dy && shape.back().xmax + 1 == dx)
+			shape.back().xmax = dx;
+		else
+			shape.push_back(Span(dy, dx, dx));
+	}
+}
+
+const ShapeCache::Shape& ShapeCache::shape(const PixLoc& pixel, const Real size)
+{
+	map<Real, Shapes>::iterator s = shapes.find(size);
+	if(s == shapes.end())
+	{
+		s = shapes.insert(make_pair(size, Shapes())).first;
+		s->second.line = geometry->get_half_circle(size);
+		s->second.cells.resize(xCells * yCells);
+		s->second.computed.resize(xCells * yCells, false);
+	}
+	Shapes& cache = s->second;
+
+	unsigned cx = pixel.x / cellSize, cy = pixel.y / cellSize;
+	unsigned c = cy * xCells + cx;
+	if(!cache.computed[c])
+	{
+		PixLoc center(cx * cellSize + cellSize / 2, cy * cellSize + cellSize / 2);
+		if(center.x >= xAxes)
+			center.x = xAxes - 1;
+		if(center.y >= yAxes)
+			center.y = yAxes - 1;
+		computeShape(center, cache.line, cache.cells[c]);
+		cache.computed[c] = true;
+	}
+	// The center of the cell is not on the disk
+	if(cache.cells[c].empty())
+	{
+		computeShape(pixel, cache.line, pixelShape);
+		return pixelShape;
+	}
+	return cache.cells[c];
+}
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef ShapeCache_H
+#define ShapeCache_H
+
+#include <vector>
+#include <map>
+
+#include "constants.h"
+#include "Coordinate.h"
+
+class ColorMap;
+
+//! Class that caches the structuring elements of the morphology with a disc projected onto the sun
+/*!
+The shape of a disc projected onto the sun depends only on the position of it's center on the disk.
+The map is divided in square cells of cellSize pixels, and the shape is computed once per cell, at the center of the cell, the first time it is requested.
+The shapes are stored as horizontal spans relative to the center, so that they can be stamped row by row.
+
+A cache can be shared by several morphological operations on maps with the same WCS, e.g. the erosion, dilation and erosion of the aggregation.
+The shapes are cached separately for each radius.
+
+For the cells at the limb, whose center is not on the disk, the shape is computed for each pixel.
+*/
+
+class ShapeCache
+{
+	public :
+		//! A horizontal span of a shape, relative to the center of the shape
+		struct Span
+		{
+			//! Offset of the row of the span
+			int dy;
+			//! Offset of the first pixel of the span
+			int xmin;
+			//! Offset of the last pixel of the span
+			int xmax;
+
+			Span(const int dy = 0, const int xmin = 0, const int xmax = 0)
+			:dy(dy), xmin(xmin), xmax(xmax)
+			{}
+		};
+
+		//! A shape is a list of spans
+		typedef std::vector<Span> Shape;
+
+	private :
+		//! The shapes of all the cells for one radius
+		struct Shapes
+		{
+			//! Half circle of the radius at the center of the sun (cf. ColorMap::get_half_circle)
+			std::vector<HCC> line;
+			//! Shape of each cell
+			std::vector<Shape> cells;
+			//! Whether the shape of each cell has been computed
+			std::vector<bool> computed;
+		};
+
+		//! Map without pixels used to compute the shapes, b0 is disabled
+		ColorMap* geometry;
+		//! Size of the X axes of the map
+		unsigned xAxes;
+		//! Size of the Y axes of the map
+		unsigned yAxes;
+		//! Size in pixels of the side of a cell
+		unsigned cellSize;
+		//! Number of cells along the X axes
+		unsigned xCells;
+		//! Number of cells along the Y axes
+		unsigned yCells;
+		//! The shapes by radius
+		std::map<Real, Shapes> shapes;
+		//! The shape of the last pixel that could not be cached
+		Shape pixelShape;
+
+		//! Routine to compute the shape of the disc of radius line centered on the pixel center
+		void computeShape(const PixLoc& center, const std::vector<HCC>& line, Shape& shape);
+
+	public :
+		//! Constructor
+		/*! The cache can only be used for maps with the same WCS as map */
+		ShapeCache(ColorMap* map, const unsigned cellSize = 4);
+
+		//! Destructor
+		~ShapeCache();
+
+		//! Return the shape of the disc of radius size centered on pixel
+		/*! The reference is valid until the next call */
+		const Shape& shape(const PixLoc& pixel, const Real size);
+
+	private :
+		// The cache owns the geometry, so it cannot be copied
+		ShapeCache(const ShapeCache&);
+		ShapeCache& operator=(const ShapeCache&);
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <assert.h>
 #include "SunImage.h"
+#include "Derotation.h"
 
 using namespace std;
 
@@ -192,18 +193,19 @@ inline void SunImage<T>::rotate(const int delta_t)
 	// We make a copy of the original image
 	Image<T> original(this);
 	
-	//We compute for each pixel in the new image what is the original location
-	RealPixLoc new_location;
+	//We compute for each pixel in the new image what is the original location, row by row
+	Derotation derotation(wcs, delta_t, this->xAxes, this->yAxes);
+	vector<RealPixLoc> original_locations(this->xAxes);
 	T* new_value = this->pixels;
-	for(new_location.y = 0;  new_location.y < this->yAxes; ++new_location.y)
+	for(unsigned y = 0; this->xAxes > 0 && y < this->yAxes; ++y)
 	{
-		for(new_location.x = 0; new_location.x < this->xAxes; ++new_location.x)
+		derotation.derotateRow(y, 0, this->xAxes - 1, &(original_locations[0]));
+		for(unsigned x = 0; x < this->xAxes; ++x)
 		{
-			RealPixLoc original_location = rotate(new_location, delta_t);
-			if(!original_location)
+			if(!original_locations[x])
 				*new_value = this->nullpixelvalue;
 			else
-				*new_value = original.interpolate(original_location);
+				*new_value = original.interpolate(original_locations[x]);
 			
 			++new_value;
 		}
@@ -216,18 +218,19 @@ inline SunImage<T>* SunImage<T>::shifted_like(const SunImage* img) const
 {
 	SunImage<T>* shifted_image = new SunImage<T>(img->wcs, img->xAxes, img->yAxes);
 	
-	//We compute for each pixel in the rotated image what is the original location
-	RealPixLoc shifted_location;
+	//We compute for each pixel in the rotated image what is the original location, row by row
+	Derotation derotation(img->wcs, wcs, img->xAxes, img->yAxes);
+	vector<RealPixLoc> original_locations(img->xAxes);
 	T* shifted_value = shifted_image->pixels;
-	for(shifted_location.y = 0;  shifted_location.y < shifted_image->yAxes; ++shifted_location.y)
+	for(unsigned y = 0; img->xAxes > 0 && y < img->yAxes; ++y)
 	{
-		for(shifted_location.x = 0; shifted_location.x < shifted_image->xAxes; ++shifted_location.x)
+		derotation.derotateRow(y, 0, img->xAxes - 1, &(original_locations[0]));
+		for(unsigned x = 0; x < img->xAxes; ++x)
 		{
-			RealPixLoc original_location = shifted_image->shift_like(shifted_location, this);
-			if(!original_location)
+			if(!original_locations[x])
 				*shifted_value = shifted_image->null();
 			else
-				*shifted_value = Image<T>::interpolate(original_location);
+				*shifted_value = Image<T>::interpolate(original_locations[x]);
 			
 			++shifted_value;
 		}
@@ -243,18 +246,19 @@ inline void SunImage<T>::shift_like(const SunImage* img)
 	// We make a copy of the original image
 	Image<T> original(this);
 	
-	//We compute for each pixel in the new image what is the original location
-	RealPixLoc new_location;
+	//We compute for each pixel in the new image what is the original location, row by row
+	Derotation derotation(img->wcs, wcs, this->xAxes, this->yAxes);
+	vector<RealPixLoc> original_locations(this->xAxes);
 	T* new_value = this->pixels;
-	for(new_location.y = 0;  new_location.y < this->yAxes; ++new_location.y)
+	for(unsigned y = 0; this->xAxes > 0 && y < this->yAxes; ++y)
 	{
-		for(new_location.x = 0; new_location.x < this->xAxes; ++new_location.x)
+		derotation.derotateRow(y, 0, this->xAxes - 1, &(original_locations[0]));
+		for(unsigned x = 0; x < this->xAxes; ++x)
 		{
-			RealPixLoc original_location = img->shift_like(new_location, this);
-			if(!original_location)
+			if(!original_locations[x])
 				*new_value = this->nullpixelvalue;
 			else
-				*new_value = original.interpolate(original_location);
+				*new_value = original.interpolate(original_locations[x]);
 			
 			++new_value;
 		}
@@ -672,6 +676,10 @@ void SunImage<T>::equirectangular_projection(const SunImage<T>* image, bool exac
 	{
 		Real sun_radius = image->SunRadius();
 		RealPixLoc sun_center = image->SunCenter();
+		// The longitude only depends on the column, so we compute it's sinus once for all the rows
+		vector<Real> sin_longitude(this->xAxes);
+		for(unsigned px = 0; px < this->xAxes; ++px)
+			sin_longitude[px] = sin((px * dx) - MIPI);
 		for(unsigned py = 0; py < this->yAxes; ++py)
 		{
 			Real latitude = (py * dy) - MIPI;
@@ -679,8 +687,7 @@ void SunImage<T>::equirectangular_projection(const SunImage<T>* image, bool exac
 			Real iy = sun_center.y + (sin(latitude) * sun_radius);
 			for(unsigned px = 0; px < this->xAxes; ++px)
 			{
-				Real longitude = (px * dx) - MIPI;
-				Real ix = sun_center.x + (sun_radius * cos_lat * sin(longitude));
+				Real ix = sun_center.x + (sun_radius * cos_lat * sin_longitude[px]);
 				*j = image->interpolate(ix, iy);
 				++j;
 			}
@@ -763,6 +770,10 @@ void SunImage<T>::Lambert_cylindrical_projection(const SunImage<T>* image, bool
 	{
 		Real sun_radius = image->SunRadius();
 		RealPixLoc sun_center = image->SunCenter();
+		// The longitude only depends on the column, so we compute it's sinus once for all the rows
+		vector<Real> sin_longitude(this->xAxes);
+		for(unsigned px = 0; px < this->xAxes; ++px)
+			sin_longitude[px] = sin((px * dx) - MIPI);
 		for(unsigned py = 0; py < this->yAxes; ++py)
 		{
 			Real latitude = asin((py * dy) - 1.);
@@ -770,8 +781,7 @@ void SunImage<T>::Lambert_cylindrical_projection(const SunImage<T>* image, bool
 			Real iy = sun_center.y + sin(latitude) * sun_radius;
 			for(unsigned px = 0; px < this->xAxes; ++px)
 			{
-				Real longitude = (px * dx) - MIPI;
-				Real ix = sun_center.x + (sun_radius * cos_lat * sin(longitude));
+				Real ix = sun_center.x + (sun_radius * cos_lat * sin_longitude[px]);
 				*j = image->interpolate(ix, iy);
 				++j;
 			}
@@ -947,13 +957,21 @@ template class SunImage<ColorType>;
 	@return The average angular speed in radians/seconds
 */
 inline Real SunDifferentialAngularSpeed(const Real& latitude)
+{
+	Real sin_latitude_squared = sin(latitude);
+	sin_latitude_squared *= sin_latitude_squared;
+	return SunDifferentialAngularSpeedSquaredSine(sin_latitude_squared);
+}
+
+/*! The speed depends only on the square of the sine of the latitude, so it can be computed without the latitude (cf. Derotation)
+	@return The average angular speed in radians/seconds
+*/
+Real SunDifferentialAngularSpeedSquaredSine(const Real& sin_latitude_squared)
 {
 
 	const Real A = 14.71;
 	const Real B = -2.39;
 	const Real C =  -1.78;
-	Real sin_latitude_squared = sin(latitude);
-	sin_latitude_squared *= sin_latitude_squared;
 	return (A + (B + C * sin_latitude_squared) * sin_latitude_squared) * DEGREE2RADIAN / (24 * 3600);
 }
 
@@ -267,6 +267,8 @@ std::string checkSimilar(const SunImage<T1>* image1, const SunImage<T2>* image2)
 
 //! Routine that computes the average differential rotation speed of the sun for a particular latitude 
 Real SunDifferentialAngularSpeed(const Real& latitude);
+//! Routine that computes the average differential rotation speed of the sun from the square of the sine of the latitude
+Real SunDifferentialAngularSpeedSquaredSine(const Real& sin_latitude_squared);
 //! Routine that computes the distance between the sun and the earth at a given time
 Real distance_sun_earth(const time_t& time_obs);
 //! Routine that computes the sun latitude of the earth at a given time
@@ -71,6 +71,16 @@ See constants.h for the actual values.
 #define NUMBER_BINS 100
 #endif
 
+/*!
+@page Compilation_Options
+@param NUMBER_THREADS The maximal number of threads used by the image routines that are parallelized (e.g. the labeling of connected components)
+<BR> It should be a positive integer, 1 disables the parallelization
+*/
+
+#if ! defined(NUMBER_THREADS)
+#define NUMBER_THREADS 4
+#endif
+
 /*!
 @page Compilation_Options
 
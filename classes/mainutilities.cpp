@@ -1,5 +1,6 @@
 #include "mainutilities.h"
 #include <algorithm>
+#include <dirent.h>
 
 using namespace std;
 
@@ -427,3 +428,93 @@ bool reorderImages(vector<EUVImage*>& images, const vector<string>& channels)
 	}
 	return true;
 }
+
+bool hasSuffix(const string& name, const string& suffix)
+{
+	return name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void listFitsFiles(const string& path, vector<string>& filenames)
+{
+	DIR* directory = opendir(path.c_str());
+	if(directory == NULL)
+	{
+		cerr<<"Error : could not open directory "<<path<<endl;
+		return;
+	}
+	vector<string> entries;
+	for(struct dirent* entry = readdir(directory); entry != NULL; entry = readdir(directory))
+	{
+		string name = entry->d_name;
+		if(name == "." || name == "..")
+			continue;
+		if(hasSuffix(name, ".fits") || hasSuffix(name, ".fts") || hasSuffix(name, ".fits.gz"))
+		{
+			string filename = path + "/" + name;
+			if(isFile(filename))
+				entries.push_back(filename);
+		}
+	}
+	closedir(directory);
+	sort(entries.begin(), entries.end());
+	filenames.insert(filenames.end(), entries.begin(), entries.end());
+}
+
+pthread_mutex_t fitsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//! Work queue shared by the threads of processWorkQueue
+struct WorkQueue
+{
+	unsigned numberItems;
+	unsigned next;
+	void (*process)(const unsigned item, void* data);
+	void* data;
+	pthread_mutex_t mutex;
+};
+
+//! Thread routine that processes the items of the queue until it is empty
+static void* workQueueThread(void* arg)
+{
+	WorkQueue* queue = static_cast<WorkQueue*>(arg);
+	while(true)
+	{
+		pthread_mutex_lock(&(queue->mutex));
+		unsigned item = queue->next++;
+		pthread_mutex_unlock(&(queue->mutex));
+		if(item >= queue->numberItems)
+			break;
+		queue->process(item, queue->data);
+	}
+	return NULL;
+}
+
+void processWorkQueue(const unsigned numberItems, void (*process)(const unsigned item, void* data), void* data, unsigned numberThreads)
+{
+	WorkQueue queue;
+	queue.numberItems = numberItems;
+	queue.next = 0;
+	queue.process = process;
+	queue.data = data;
+	if(numberThreads > numberItems)
+		numberThreads = numberItems;
+	pthread_mutex_init(&(queue.mutex), NULL);
+	vector<pthread_t> threads(numberThreads);
+	unsigned startedThreads = 0;
+	for(unsigned t = 0; t < numberThreads; ++t)
+	{
+		if(pthread_create(&(threads[t]), NULL, workQueueThread, &queue) != 0)
+		{
+			cerr<<"Error : could not create thread "<<t<<endl;
+			break;
+		}
+		++startedThreads;
+	}
+	// If no thread could be started, we process the items ourselves
+	if(startedThreads == 0)
+		workQueueThread(&queue);
+	for(unsigned t = 0; t < startedThreads; ++t)
+	{
+		pthread_join(threads[t], NULL);
+	}
+	pthread_mutex_destroy(&(queue.mutex));
+}
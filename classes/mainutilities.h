@@ -15,6 +15,7 @@
 #include <sys/stat.h>
 #include <limits>
 #include <stdexcept>
+#include <pthread.h>
 
 #include "FeatureVector.h"
 #include "EUVImage.h"
@@ -76,4 +77,19 @@ std::vector<Real> median(const std::deque< std::vector<Real> >& Etas);
 //! Reorder the vecort of images according to the channels
 bool reorderImages(std::vector<EUVImage*>& images, const std::vector<std::string>& channels);
 
+//! Return true if name is longer than suffix and ends with it
+bool hasSuffix(const std::string& name, const std::string& suffix);
+
+//! Add to filenames the fits files (.fits, .fts or .fits.gz) in the directory path, sorted by name
+void listFitsFiles(const std::string& path, std::vector<std::string>& filenames);
+
+//! Mutex to access the fits files one thread at a time, cfitsio may not be reentrant
+extern pthread_mutex_t fitsMutex;
+
+//! Process the items 0 to numberItems - 1 with numberThreads threads
+/*! Each thread calls process(item, data) for the next item of a shared queue until it is empty, so the items can be processed in any order.
+	If no thread can be started, the items are processed by the calling thread.
+*/
+void processWorkQueue(const unsigned numberItems, void (*process)(const unsigned item, void* data), void* data, unsigned numberThreads);
+
 #endif
@@ -8,6 +8,12 @@ ColorType newColor;
 
 // Compute the number of pixels common to 2 regions from 2 images, with derotation
 unsigned overlay_derotate(ColorMap* image1, const Region* region1, ColorMap* image2, const Region* region2)
+{
+	return overlay_derotate(Derotation(image2->getWCS(), image1->getWCS(), image2->Xaxes(), image2->Yaxes()), image1, region1, image2, region2);
+}
+
+// Compute the number of pixels common to 2 regions from 2 images, with the derotation of image2 into image1
+unsigned overlay_derotate(const Derotation& derotation, ColorMap* image1, const Region* region1, ColorMap* image2, const Region* region2)
 {
 	unsigned intersectPixels = 0;
 	ColorType setValue1 = image1->pixel(region1->FirstPixel());
@@ -34,6 +40,28 @@ unsigned overlay_derotate(ColorMap* image1, const Region* region1, ColorMap* ima
 	unsigned Xmax = unsigned(r1_boxmax.x < r2_boxmax.x ? r1_boxmax.x : r2_boxmax.x);
 	unsigned Ymax = unsigned(r1_boxmax.y < r2_boxmax.y ? r1_boxmax.y : r2_boxmax.y);
 
+	// If we have the runs of region2, we scan only it's pixels in the intersection
+	if(region2->hasRuns())
+	{
+		const vector<Region::Run>& runs = region2->Runs();
+		for(vector<Region::Run>::const_iterator r = runs.begin(); r != runs.end(); ++r)
+		{
+			if(r->y < Ymin || r->y > Ymax)
+				continue;
+			PixLoc c2(r->start > Xmin ? r->start : Xmin, r->y);
+			const unsigned Xend = r->start + r->length - 1 < Xmax ? r->start + r->length - 1 : Xmax;
+			for (; c2.x <= Xend; ++c2.x)
+			{
+				RealPixLoc c1 = derotation.derotate(c2.x, c2.y);
+				if (!c1)
+					continue;
+				if(image1->interpolate(c1) == setValue1)
+					++intersectPixels;
+			}
+		}
+		return intersectPixels;
+	}
+
 	// We scan the intersection in the coordinates of image2
 	PixLoc c2;
 	for (c2.y = Ymin; c2.y <= Ymax; ++c2.y)
@@ -41,7 +69,7 @@ unsigned overlay_derotate(ColorMap* image1, const Region* region1, ColorMap* ima
 		for (c2.x = Xmin; c2.x <= Xmax; ++c2.x)
 		{
 			// We project back the coordinate of image2 into the coordinate of image1
-			RealPixLoc  c1 = image2->shift_like(c2, image1);
+			RealPixLoc  c1 = derotation.derotate(c2.x, c2.y);
 			// The projection of the coordinate may lie outside of the sundisc ==> the projection is null
 			if (!c1)
 				continue;
@@ -59,6 +87,10 @@ unsigned overlay_derotate(ColorMap* image1, const Region* region1, ColorMap* ima
 // Compute the number of pixels common to 2 regions from 2 images
 unsigned overlay(ColorMap* image1, const Region* region1, ColorMap* image2, const Region* region2)
 {
+	// If we have the runs of the 2 regions, we can intersect them without looking at the images
+	if(region1->hasRuns() && region2->hasRuns())
+		return region1->overlap(*region2);
+
 	unsigned intersectPixels = 0;
 	ColorType setValue1 = image1->pixel(region1->FirstPixel());
 	ColorType setValue2 = image2->pixel(region2->FirstPixel());
@@ -89,19 +121,288 @@ unsigned overlay(ColorMap* image1, const Region* region1, ColorMap* image2, cons
 
 }
 
-// Color a node
+// Return the position of the region of each color of the image
+static map<ColorType, unsigned> regionIndexes(ColorMap* image, const vector<Region*>& regions)
+{
+	map<ColorType, unsigned> indexes;
+	for (unsigned r = 0; r < regions.size(); ++r)
+		indexes[image->pixel(regions[r]->FirstPixel())] = r;
+	return indexes;
+}
+
+// Return the position of the region of each color of the runs of a map
+static map<ColorType, unsigned> regionIndexes(const ColorRuns* footprint, const ColorType null, const vector<Region*>& regions)
+{
+	map<ColorType, unsigned> indexes;
+	for (unsigned r = 0; r < regions.size(); ++r)
+		indexes[footprint->pixel(regions[r]->FirstPixel().x, regions[r]->FirstPixel().y, null)] = r;
+	return indexes;
+}
+
+// Size in pixels of the cells of the grid of region boxes
+static const unsigned gridCellSize = 16;
+
+/*!
+Return for each cell of the grid of image2 if its pixels may derotate into the bounding box of a region of image1.
+The boxes of the regions of image1 are rasterized on a grid of image1, and summed as an integral image to test a rectangle of cells in constant time.
+The corners of the cells of image2 are derotated into image1, a cell is a candidate if the box of its corners, plus a margin for the interpolation, meets a region box.
+A cell with a corner that cannot be derotated (e.g. at the limb) is always a candidate.
+*/
+static vector<bool> derotationCandidates(const PixLoc& size1, const vector<Region*>& regions1, const Derotation& derotation, const PixLoc& size2, unsigned& cellsX2)
+{
+	const unsigned cellsX1 = size1.x / gridCellSize + 1, cellsY1 = size1.y / gridCellSize + 1;
+	vector<unsigned> boxes((cellsX1 + 1) * (cellsY1 + 1), 0);
+	for (unsigned r = 0; r < regions1.size(); ++r)
+	{
+		const PixLoc boxmin = regions1[r]->Boxmin(), boxmax = regions1[r]->Boxmax();
+		for (unsigned cy = boxmin.y / gridCellSize; cy <= boxmax.y / gridCellSize && cy < cellsY1; ++cy)
+			for (unsigned cx = boxmin.x / gridCellSize; cx <= boxmax.x / gridCellSize && cx < cellsX1; ++cx)
+				boxes[(cy + 1) * (cellsX1 + 1) + cx + 1] = 1;
+	}
+	for (unsigned cy = 1; cy <= cellsY1; ++cy)
+		for (unsigned cx = 1; cx <= cellsX1; ++cx)
+			boxes[cy * (cellsX1 + 1) + cx] += boxes[(cy - 1) * (cellsX1 + 1) + cx] + boxes[cy * (cellsX1 + 1) + cx - 1] - boxes[(cy - 1) * (cellsX1 + 1) + cx - 1];
+
+	cellsX2 = size2.x / gridCellSize + 1;
+	const unsigned cellsY2 = size2.y / gridCellSize + 1;
+	vector<RealPixLoc> corners((cellsX2 + 1) * (cellsY2 + 1));
+	for (unsigned cy = 0; cy <= cellsY2; ++cy)
+		for (unsigned cx = 0; cx <= cellsX2; ++cx)
+			corners[cy * (cellsX2 + 1) + cx] = derotation.derotate(cx * gridCellSize, cy * gridCellSize);
+
+	vector<bool> candidates(cellsX2 * cellsY2, true);
+	for (unsigned cy = 0; cy < cellsY2; ++cy)
+	{
+		for (unsigned cx = 0; cx < cellsX2; ++cx)
+		{
+			const RealPixLoc cellCorners[] = {corners[cy * (cellsX2 + 1) + cx], corners[cy * (cellsX2 + 1) + cx + 1], corners[(cy + 1) * (cellsX2 + 1) + cx], corners[(cy + 1) * (cellsX2 + 1) + cx + 1]};
+			bool known = true;
+			Real minx = cellCorners[0].x, maxx = cellCorners[0].x, miny = cellCorners[0].y, maxy = cellCorners[0].y;
+			for (unsigned c = 0; c < 4 && known; ++c)
+			{
+				known = !(!cellCorners[c]);
+				minx = min(minx, cellCorners[c].x);
+				maxx = max(maxx, cellCorners[c].x);
+				miny = min(miny, cellCorners[c].y);
+				maxy = max(maxy, cellCorners[c].y);
+			}
+			if(!known)
+				continue;
+			// The interpolation looks at the next pixels, and the derotation is not exactly linear inside a cell
+			minx -= 2; miny -= 2; maxx += 2; maxy += 2;
+			if(maxx < 0 || maxy < 0 || minx >= Real(size1.x) || miny >= Real(size1.y))
+			{
+				candidates[cy * cellsX2 + cx] = false;
+				continue;
+			}
+			const unsigned x0 = minx > 0 ? unsigned(minx) / gridCellSize : 0;
+			const unsigned y0 = miny > 0 ? unsigned(miny) / gridCellSize : 0;
+			const unsigned x1 = min(unsigned(maxx) / gridCellSize + 1, cellsX1);
+			const unsigned y1 = min(unsigned(maxy) / gridCellSize + 1, cellsY1);
+			candidates[cy * cellsX2 + cx] = boxes[y1 * (cellsX1 + 1) + x1] + boxes[y0 * (cellsX1 + 1) + x0] - boxes[y0 * (cellsX1 + 1) + x1] - boxes[y1 * (cellsX1 + 1) + x0] > 0;
+		}
+	}
+	return candidates;
+}
+
+// Compute the number of pixels common to each pair of regions from 2 images, in one pass over the images
+map<pair<unsigned,unsigned>, unsigned> overlay_matrix(ColorMap* image1, const vector<Region*>& regions1, ColorMap* image2, const vector<Region*>& regions2, bool derotate)
+{
+	map<pair<unsigned,unsigned>, unsigned> intersectPixels;
+	if(regions1.empty() || regions2.empty())
+		return intersectPixels;
+	if(!derotate && (image1->Xaxes() != image2->Xaxes() || image1->Yaxes() != image2->Yaxes()))
+	{
+		cerr<<"Error : cannot overlay images of different size without derotation."<<endl;
+		return intersectPixels;
+	}
+
+	const map<ColorType, unsigned> indexes1 = regionIndexes(image1, regions1);
+	const map<ColorType, unsigned> indexes2 = regionIndexes(image2, regions2);
+	const ColorType null1 = image1->null();
+	const ColorType null2 = image2->null();
+
+	// We only need to scan the bounding box of the regions of image2
+	PixLoc boxmin = regions2[0]->Boxmin(), boxmax = regions2[0]->Boxmax();
+	for (unsigned r = 1; r < regions2.size(); ++r)
+	{
+		boxmin.x = min(boxmin.x, regions2[r]->Boxmin().x);
+		boxmin.y = min(boxmin.y, regions2[r]->Boxmin().y);
+		boxmax.x = max(boxmax.x, regions2[r]->Boxmax().x);
+		boxmax.y = max(boxmax.y, regions2[r]->Boxmax().y);
+	}
+
+	// When derotating, we skip the pixels that cannot derotate into a region of image1
+	const Derotation derotation(image2->getWCS(), image1->getWCS(), derotate ? image2->Xaxes() : 0, derotate ? image2->Yaxes() : 0);
+	unsigned cellsX2 = 0;
+	const vector<bool> candidates = derotate ? derotationCandidates(PixLoc(image1->Xaxes(), image1->Yaxes()), regions1, derotation, PixLoc(image2->Xaxes(), image2->Yaxes()), cellsX2) : vector<bool>();
+
+	// Consecutive pixels often have the same colors, so we remember the last lookup
+	ColorType lastColor1 = null1, lastColor2 = null2;
+	map<ColorType, unsigned>::const_iterator index1 = indexes1.end(), index2 = indexes2.end();
+	map<pair<unsigned,unsigned>, unsigned>::iterator lastPair = intersectPixels.end();
+	PixLoc c2;
+	for (c2.y = boxmin.y; c2.y <= boxmax.y; ++c2.y)
+	{
+		for (c2.x = boxmin.x; c2.x <= boxmax.x; ++c2.x)
+		{
+			const ColorType color2 = image2->pixel(c2);
+			if(color2 == null2)
+				continue;
+			ColorType color1 = null1;
+			if(derotate)
+			{
+				if(!candidates[(c2.y / gridCellSize) * cellsX2 + c2.x / gridCellSize])
+					continue;
+				// We project back the coordinate of image2 into the coordinate of image1
+				RealPixLoc c1 = derotation.derotate(c2.x, c2.y);
+				// The projection of the coordinate may lie outside of the sundisc ==> the projection is null
+				if(!c1)
+					continue;
+				color1 = image1->interpolate(c1);
+			}
+			else
+			{
+				color1 = image1->pixel(c2);
+			}
+			if(color1 == null1)
+				continue;
+
+			if(color1 != lastColor1 || color2 != lastColor2 || lastPair == intersectPixels.end())
+			{
+				lastColor1 = color1;
+				lastColor2 = color2;
+				index1 = indexes1.find(color1);
+				index2 = indexes2.find(color2);
+				if(index1 == indexes1.end() || index2 == indexes2.end())
+				{
+					lastPair = intersectPixels.end();
+					continue;
+				}
+				lastPair = intersectPixels.insert(make_pair(make_pair(index1->second, index2->second), 0)).first;
+			}
+			++(lastPair->second);
+		}
+	}
+	return intersectPixels;
+}
+
+/*!
+Same as overlay_matrix on the images, but the pixels are looked up in the runs of the maps, so the images only need their header.
+Only the pixels of the runs of footprint2 are visited, and the color of their derotated position is interpolated on the runs of footprint1.
+*/
+map<pair<unsigned,unsigned>, unsigned> overlay_matrix(ColorMap* image1, const ColorRuns* footprint1, const vector<Region*>& regions1, ColorMap* image2, const ColorRuns* footprint2, const vector<Region*>& regions2, bool derotate)
+{
+	map<pair<unsigned,unsigned>, unsigned> intersectPixels;
+	if(regions1.empty() || regions2.empty())
+		return intersectPixels;
+	const ColorType null1 = image1->null();
+	const ColorType null2 = image2->null();
+	const map<ColorType, unsigned> indexes1 = regionIndexes(footprint1, null1, regions1);
+	const map<ColorType, unsigned> indexes2 = regionIndexes(footprint2, null2, regions2);
+
+	if(!derotate)
+	{
+		if(footprint1->Xaxes() != footprint2->Xaxes() || footprint1->Yaxes() != footprint2->Yaxes())
+		{
+			cerr<<"Error : cannot overlay images of different size without derotation."<<endl;
+			return intersectPixels;
+		}
+		const map<pair<ColorType, ColorType>, unsigned> overlap = footprint1->overlap(*footprint2);
+		for (map<pair<ColorType, ColorType>, unsigned>::const_iterator it = overlap.begin(); it != overlap.end(); ++it)
+		{
+			map<ColorType, unsigned>::const_iterator index1 = indexes1.find(it->first.first);
+			map<ColorType, unsigned>::const_iterator index2 = indexes2.find(it->first.second);
+			if(index1 != indexes1.end() && index2 != indexes2.end())
+				intersectPixels[make_pair(index1->second, index2->second)] += it->second;
+		}
+		return intersectPixels;
+	}
+
+	const Derotation derotation(image2->getWCS(), image1->getWCS(), footprint2->Xaxes(), footprint2->Yaxes());
+	unsigned cellsX2 = 0;
+	const vector<bool> candidates = derotationCandidates(PixLoc(footprint1->Xaxes(), footprint1->Yaxes()), regions1, derotation, PixLoc(footprint2->Xaxes(), footprint2->Yaxes()), cellsX2);
+
+	ColorType lastColor1 = null1;
+	map<ColorType, unsigned>::const_iterator index1 = indexes1.end();
+	map<pair<unsigned,unsigned>, unsigned>::iterator lastPair = intersectPixels.end();
+	PixLoc c2;
+	for (c2.y = 0; c2.y < footprint2->Yaxes(); ++c2.y)
+	{
+		for (vector<ColorRuns::Run>::const_iterator r = footprint2->row_begin(c2.y); r != footprint2->row_end(c2.y); ++r)
+		{
+			map<ColorType, unsigned>::const_iterator index2 = indexes2.find(r->color);
+			if(r->color == null2 || index2 == indexes2.end())
+				continue;
+			lastColor1 = null1;
+			for (c2.x = r->start; c2.x < r->start + r->length; ++c2.x)
+			{
+				if(!candidates[(c2.y / gridCellSize) * cellsX2 + c2.x / gridCellSize])
+					continue;
+				// We project back the coordinate of image2 into the coordinate of image1
+				RealPixLoc c1 = derotation.derotate(c2.x, c2.y);
+				// The projection of the coordinate may lie outside of the sundisc ==> the projection is null
+				if(!c1)
+					continue;
+				const ColorType color1 = footprint1->interpolate(c1, null1);
+				if(color1 == null1)
+					continue;
+				if(color1 != lastColor1 || lastPair == intersectPixels.end())
+				{
+					lastColor1 = color1;
+					index1 = indexes1.find(color1);
+					if(index1 == indexes1.end())
+					{
+						lastPair = intersectPixels.end();
+						continue;
+					}
+					lastPair = intersectPixels.insert(make_pair(make_pair(index1->second, index2->second), 0)).first;
+				}
+				++(lastPair->second);
+			}
+		}
+	}
+	return intersectPixels;
+}
+
+/*!
+The parents of a node must be colored before it, so we color the parents that are not colored yet first, in the order of the in edges.
+This is a depth first search on the parents, done with an explicit stack so that long chains of regions cannot overflow the call stack.
+*/
 void RegionGraph::node::colorize()
 {
 	//If I'm already colored than I am fine
 	if(region->Color() != 0)
 		return;
 
-	// I need all my parents to have their color
+	vector<pair<node*, const_iterator> > stack;
+	stack.push_back(make_pair(this, in_begin()));
+	while(!stack.empty())
+	{
+		node* n = stack.back().first;
+		const_iterator it = stack.back().second;
+		// We skip the parents that are already colored
+		while(it != n->in_end() && it->from->get_region()->Color() != 0)
+			++it;
+		stack.back().second = it;
+		if(it != n->in_end())
+		{
+			stack.push_back(make_pair(it->from, it->from->in_begin()));
+		}
+		else
+		{
+			n->colorizeFromParents();
+			stack.pop_back();
+		}
+	}
+}
+
+// Color a node whose parents are all colored
+void RegionGraph::node::colorizeFromParents()
+{
 	RegionGraph::node::const_iterator biggestInEdge = in_begin();
 	for (RegionGraph::node::const_iterator it = in_begin(); it != in_end(); ++it)
 	{
-		//Carefull there is recursion here
-		it->from->colorize();
 		// We search for the biggest parent
 		if(it->weight > biggestInEdge->weight)
 			biggestInEdge = it;
@@ -121,6 +422,176 @@ void RegionGraph::node::colorize()
 		region->setColor(++newColor);
 }
 
+// Color all the nodes, in the order of their id
+void RegionGraph::colorize()
+{
+	for (unsigned n = 0; n < nodes.size(); ++n)
+		nodes[n].colorize();
+}
+
+/*!
+The edges are stored in the order they are added, and sorted by destination and by source only when they are iterated.
+The sort is a stable counting sort, so the in and out edges of a node stay in the order they were added.
+*/
+void RegionGraph::compress() const
+{
+	if(compressed)
+		return;
+	in_offsets.assign(nodes.size() + 1, 0);
+	out_offsets.assign(nodes.size() + 1, 0);
+	for (unsigned e = 0; e < edges.size(); ++e)
+	{
+		++in_offsets[edges[e].to->id + 1];
+		++out_offsets[edges[e].from->id + 1];
+	}
+	for (unsigned n = 0; n < nodes.size(); ++n)
+	{
+		in_offsets[n + 1] += in_offsets[n];
+		out_offsets[n + 1] += out_offsets[n];
+	}
+	in_edges.assign(edges.size(), edge(NULL, NULL, 0));
+	out_edges.assign(edges.size(), edge(NULL, NULL, 0));
+	vector<unsigned> in_positions(in_offsets.begin(), in_offsets.end() - 1);
+	vector<unsigned> out_positions(out_offsets.begin(), out_offsets.end() - 1);
+	for (unsigned e = 0; e < edges.size(); ++e)
+	{
+		in_edges[in_positions[edges[e].to->id]++] = edges[e];
+		out_edges[out_positions[edges[e].from->id]++] = edges[e];
+	}
+	compressed = true;
+}
+
+
+static const unsigned bitsPerWord = 8 * sizeof(unsigned long);
+
+// Tell if a set contains the id
+bool RegionGraph::contains(const idset& set, const unsigned id)
+{
+	const unsigned w = id / bitsPerWord;
+	return w >= set.first && w - set.first < set.words.size() && (set.words[w - set.first] & (1UL << (id % bitsPerWord)));
+}
+
+// Make a set span the words from first to last, the set grows only to the words it needs
+void RegionGraph::span(idset& set, const unsigned first, const unsigned last)
+{
+	if(set.words.empty())
+	{
+		set.first = first;
+		set.words.assign(last - first + 1, 0);
+		return;
+	}
+	if(first < set.first)
+	{
+		set.words.insert(set.words.begin(), set.first - first, 0);
+		set.first = first;
+	}
+	if(last - set.first >= set.words.size())
+		set.words.resize(last - set.first + 1, 0);
+}
+
+// Add an id to a set
+void RegionGraph::insert(idset& set, const unsigned id)
+{
+	const unsigned w = id / bitsPerWord;
+	span(set, w, w);
+	set.words[w - set.first] |= 1UL << (id % bitsPerWord);
+}
+
+// Add the ids of other to a set
+void RegionGraph::unite(idset& set, const idset& other)
+{
+	if(other.words.empty())
+		return;
+	span(set, other.first, other.first + other.words.size() - 1);
+	const unsigned offset = other.first - set.first;
+	for (unsigned w = 0; w < other.words.size(); ++w)
+		set.words[offset + w] |= other.words[w];
+}
+
+// Return the ids of a set
+vector<unsigned> RegionGraph::elements(const idset& set)
+{
+	vector<unsigned> ids;
+	for (unsigned w = 0; w < set.words.size(); ++w)
+	{
+		for (unsigned b = 0; b < bitsPerWord && set.words[w] >> b; ++b)
+		{
+			if(set.words[w] & (1UL << b))
+				ids.push_back((set.first + w) * bitsPerWord + b);
+		}
+	}
+	return ids;
+}
+
+// Remove the ids before id from a set
+void RegionGraph::erase_before(idset& set, const unsigned id)
+{
+	const unsigned w = id / bitsPerWord;
+	if(set.words.empty() || w < set.first)
+		return;
+	if(w - set.first >= set.words.size())
+	{
+		set = idset();
+		return;
+	}
+	set.words.erase(set.words.begin(), set.words.begin() + (w - set.first));
+	set.first = w;
+	set.words[0] &= ~0UL << (id % bitsPerWord);
+}
+
+/*!
+The graph keeps the transitive closure of the edges as 2 sets per node: the nodes it reaches, and the nodes that reach it.
+When an edge from -> to is added, every node that reaches from now reaches every node reached by to.
+Edges are only added, so the update costs one set union per node whose set changes, and a path test is a single bit test.
+The sets are bitsets that only span the ids they contain, and the ids of the nodes follow time,
+so they only span the nodes within the time a region can be tracked, and not the whole graph.
+The edges go from an older to a newer node, so the ancestors are the only sets that reach back in time.
+They are cut at the start of the window of the closure (cf. slide_closure), so that the sets do not grow with the length of the tracks.
+*/
+void RegionGraph::add_edge(node* from, node* to, int weight)
+{
+	edges.push_back(edge(from, to, weight));
+	compressed = false;
+
+	// The paths from or to the nodes out of the window of the closure are not kept
+	if(from->id < closure_start || to->id < closure_start || reachable(from, to))
+		return;
+
+	idset newDescendants = descendants[to->id - closure_start];
+	insert(newDescendants, to->id);
+	idset newAncestors = ancestors[from->id - closure_start];
+	insert(newAncestors, from->id);
+
+	const vector<unsigned> ancestorIds = elements(newAncestors);
+	for (unsigned a = 0; a < ancestorIds.size(); ++a)
+		unite(descendants[ancestorIds[a] - closure_start], newDescendants);
+	const vector<unsigned> descendantIds = elements(newDescendants);
+	for (unsigned d = 0; d < descendantIds.size(); ++d)
+		unite(ancestors[descendantIds[d] - closure_start], newAncestors);
+}
+
+// Tell if there is a path between 2 nodes
+bool RegionGraph::reachable(const node* from, const node* to) const
+{
+	return from == to || (from->id >= closure_start && contains(descendants[from->id - closure_start], to->id));
+}
+
+/*!
+When a map can not be compared anymore with the next maps, no path from or to its regions will be tested.
+Their sets are removed from the front of the window, and the ancestors of the other nodes are cut at the first node of the window,
+so the nodes out of the window are also not updated anymore when edges are added.
+*/
+void RegionGraph::slide_closure(const unsigned firstId)
+{
+	const unsigned last = firstId < nodes.size() ? firstId : nodes.size();
+	if(last <= closure_start)
+		return;
+	descendants.erase(descendants.begin(), descendants.begin() + (last - closure_start));
+	ancestors.erase(ancestors.begin(), ancestors.begin() + (last - closure_start));
+	closure_start = last;
+	for (unsigned n = 0; n < ancestors.size(); ++n)
+		erase_before(ancestors[n], closure_start);
+}
 
 // Tell if there is a path between a node and a region
 bool RegionGraph::node::path(const RegionGraph::node* to, std::set<node*>* visited)
@@ -135,7 +606,7 @@ bool RegionGraph::node::path(const RegionGraph::node* to, std::set<node*>* visit
 		return true;
 	}
 
-	for (std::vector<edge>::const_iterator it = out_edges.begin(); it != out_edges.end(); ++it)
+	for (const_iterator it = out_begin(); it != out_end(); ++it)
 	{
 		if(it->to->path(to, visited))
 			return true;
@@ -257,8 +728,43 @@ inline vector<unsigned> imageOrder(const vector<ColorMap*>& images)
 	return indices;
 }
 
+/*!
+The lifetime of a track goes from the earliest first observation time of it's regions to the latest observation time,
+so a track that continues a track of previous maps already tracked keeps the first observation of that track.
+The regions that have not been colored yet (i.e. with color 0) are not counted.
+*/
+map<ColorType, TrackLifetime> trackLifetimes(const RegionGraph& tracking_graph)
+{
+	map<ColorType, TrackLifetime> lifetimes;
+	for (RegionGraph::const_iterator n = tracking_graph.begin(); n != tracking_graph.end(); ++n)
+	{
+		const Region* region = n->get_region();
+		if(region->Color() == 0)
+			continue;
+		TrackLifetime& lifetime = lifetimes[region->Color()];
+		if(lifetime.numberObservations == 0 || region->FirstObservationTime() < lifetime.firstObservationTime)
+			lifetime.firstObservationTime = region->FirstObservationTime();
+		if(lifetime.numberObservations == 0 || region->ObservationTime() > lifetime.lastObservationTime)
+			lifetime.lastObservationTime = region->ObservationTime();
+		++lifetime.numberObservations;
+	}
+	return lifetimes;
+}
+
 void recolorFromRegions(ColorMap* image, const vector<Region*>& regions)
 {
+	// If we have the runs of all the regions, we only need to fill them
+	bool runs = true;
+	for (unsigned r = 0; r < regions.size() && runs; ++r)
+		runs = regions[r]->hasRuns();
+	if(runs)
+	{
+		image->zero(image->null());
+		for (unsigned r = 0; r < regions.size(); ++r)
+			regions[r]->recolor(image, regions[r]->Color());
+		return;
+	}
+
 	map<ColorType,ColorType> colorTransfo;
 	for (unsigned r = 0; r < regions.size(); ++r)
 	{
@@ -282,12 +788,13 @@ void recolorFromRegions(ColorMap* image, const vector<Region*>& regions)
 
 FitsFile& writeTrackingRelations(FitsFile& file, const vector<Region*>& regions, const RegionGraph& tracking_graph, const Real pixel_area)
 {
-	vector<string> past_dates_obs;
-	vector<ColorType> past_colors;
-	vector<string> present_dates_obs;
-	vector<ColorType> present_colors;
-	vector<int> overlap_number_pixels;
-	vector<Real> overlap_area_projected;
+	FitsTable table;
+	vector<string>& past_dates_obs = table.column<string>("PAST_DATE_OBS");
+	vector<ColorType>& past_colors = table.column<ColorType>("PAST_COLOR");
+	vector<string>& present_dates_obs = table.column<string>("PRESENT_DATE_OBS");
+	vector<ColorType>& present_colors = table.column<ColorType>("PRESENT_COLOR");
+	vector<int>& overlap_number_pixels = table.column<int>("OVERLAP_NUMBER_PIXELS");
+	vector<Real>& overlap_area_projected = table.column<Real>("OVERLAP_AREA_PROJECTED");
 	
 	for (unsigned r = 0; r < regions.size(); ++r)
 	{
@@ -304,13 +811,9 @@ FitsFile& writeTrackingRelations(FitsFile& file, const vector<Region*>& regions,
 		}
 	}
 	
+	table.resize(past_colors.size());
 	file.writeTable("TrackingRelations");
-	file.writeColumn("PAST_DATE_OBS", past_dates_obs);
-	file.writeColumn("PAST_COLOR", past_colors);
-	file.writeColumn("PRESENT_DATE_OBS", present_dates_obs);
-	file.writeColumn("PRESENT_COLOR", present_colors);
-	file.writeColumn("OVERLAP_NUMBER_PIXELS", overlap_number_pixels);
-	file.writeColumn("OVERLAP_AREA_PROJECTED", overlap_area_projected);
+	file.writeColumns(table);
 	
 	return file;
 }
@@ -14,11 +14,14 @@
 
 #include <map>
 #include <set>
+#include <deque>
 
 #include "tools.h"
 #include "constants.h"
 #include "ColorMap.h"
+#include "ColorRuns.h"
 #include "Region.h"
+#include "Derotation.h"
 #include "gradient.h"
 
 extern std::string filenamePrefix;
@@ -31,31 +34,31 @@ public:
 
 	class const_iterator {
 		const RegionGraph * graph;
-		std::map<Region*,node>::const_iterator it;
+		std::deque<node>::const_iterator it;
 		
 	public:
-		const_iterator(const RegionGraph* graph, std::map<Region*,node>::const_iterator it) : graph(graph), it(it) {}
+		const_iterator(const RegionGraph* graph, std::deque<node>::const_iterator it) : graph(graph), it(it) {}
 
-		const node& operator*() { return it->second; }
+		const node& operator*() { return *it; }
 		void operator++() { ++it; }
 		void operator++(int) { operator++(); }
 		bool operator==(const const_iterator& other) { return it == other.it; }
 		bool operator!=(const const_iterator& other) { return !(operator==(other)); }
-		const node* operator->() { return &(it->second); }
+		const node* operator->() { return &(*it); }
 	};
 
 	class iterator {
 		RegionGraph * graph;
-		std::map<Region*,node>::iterator it;
+		std::deque<node>::iterator it;
 	public:
-		iterator(RegionGraph* graph, std::map<Region*,node>::iterator it) : graph(graph), it(it) {}
+		iterator(RegionGraph* graph, std::deque<node>::iterator it) : graph(graph), it(it) {}
 
-		node& operator*() { return it->second; }
+		node& operator*() { return *it; }
 		void operator++() { ++it; }
 		void operator++(int) { operator++(); }
 		bool operator==(const iterator& other) { return it == other.it; }
 		bool operator!=(const iterator& other) { return !(operator==(other)); }
-		node* operator->() { return &(it->second); }
+		node* operator->() { return &(*it); }
 	};
 
 	class edge {
@@ -73,75 +76,183 @@ public:
 	class node {
 		const RegionGraph* graph;
 		Region* region;
-		std::vector<edge> in_edges;
-		std::vector<edge> out_edges;
+		// Dense identifier of the node, in the order the nodes were added to the graph
+		unsigned id;
 
 		class edge_cmp {
 		public:
       			bool operator()(const edge& a, const edge& b) { return a.weight < b.weight; }
 		};
+
+		// Color the node from it's parents, they must already be colored
+		void colorizeFromParents();
 	public:
 		typedef std::vector<edge>::const_iterator const_iterator;
 		
-		node() {}
-		node(const RegionGraph * graph, Region* region) : graph(graph), region(region) {}
+		node() : graph(NULL), region(NULL), id(0) {}
+		node(const RegionGraph * graph, Region* region, unsigned id) : graph(graph), region(region), id(id) {}
 			
 		const node* biggestParent() const {
-			return std::max_element(in_edges.begin(), in_edges.end(), edge_cmp())->from;
+			return std::max_element(in_begin(), in_end(), edge_cmp())->from;
 		}
 
 		const node* biggestSon() const {
-			return std::max_element(out_edges.begin(), out_edges.end(), edge_cmp())->to;
+			return std::max_element(out_begin(), out_end(), edge_cmp())->to;
 		}
 		
 		Region* get_region() const {
 			return region;
 		}
 
-		bool path(const node* to, std::set<node*>* visited);
+		unsigned get_id() const {
+			return id;
+		}
 
-		bool path(const node* to) {
-			std::set<node*> visited;
+		bool path(const node* to, std::set<node*>* visited);
 
-			return path(to, &visited);
+		// Tell if there is a path to a node, using the reachability sets of the graph
+		bool path(const node* to) const {
+			return graph->reachable(this, to);
 		}
 
 		void colorize();
 
-		const_iterator in_begin() const { return in_edges.begin(); }
-		const_iterator in_end() const { return in_edges.end(); }
-		const_iterator out_begin() const { return out_edges.begin(); }
-		const_iterator out_end() const { return out_edges.end(); }
+		const_iterator in_begin() const { return graph->in_begin(id); }
+		const_iterator in_end() const { return graph->in_begin(id + 1); }
+		const_iterator out_begin() const { return graph->out_begin(id); }
+		const_iterator out_end() const { return graph->out_begin(id + 1); }
 
 		friend class RegionGraph;
 	};
 
 private:
-	std::map<Region*, node> nodes;
+	// A set of node ids, stored as bits starting at the word first, so that it only spans the ids it contains
+	struct idset {
+		unsigned first;
+		std::vector<unsigned long> words;
+		idset() : first(0) {}
+	};
 
-public:
-	void add_edge(node* from, node* to, int weight) {
-		from->out_edges.push_back(edge(from, to, weight));
-		to->in_edges.push_back(edge(from, to, weight));
+	// The nodes, in a deque so that the pointers to the nodes stay valid when nodes are added
+	std::deque<node> nodes;
+	// The id of the node of each region
+	std::map<Region*, unsigned> ids;
+	// The edges in the order they were added
+	std::vector<edge> edges;
+	// The edges sorted by destination and by source, in compressed sparse row form, built from edges when needed
+	mutable std::vector<edge> in_edges;
+	mutable std::vector<unsigned> in_offsets;
+	mutable std::vector<edge> out_edges;
+	mutable std::vector<unsigned> out_offsets;
+	mutable bool compressed;
+	// For each node of the window of the closure, the set of the nodes it has a path to
+	// The set of the node id is at id - closure_start, so that only the sets of the window are stored
+	std::deque<idset> descendants;
+	// For each node of the window of the closure, the set of the nodes that have a path to it
+	std::deque<idset> ancestors;
+	// The id of the first node of the window of the closure
+	unsigned closure_start;
+
+	// Build the compressed sparse rows of the edges
+	void compress() const;
+
+	// The in edges of the node id start at the edge in_begin(id), and end at in_begin(id + 1)
+	std::vector<edge>::const_iterator in_begin(const unsigned id) const {
+		compress();
+		return in_edges.begin() + in_offsets[id];
+	}
+	std::vector<edge>::const_iterator out_begin(const unsigned id) const {
+		compress();
+		return out_edges.begin() + out_offsets[id];
 	}
 
+	static bool contains(const idset& set, const unsigned id);
+	static void span(idset& set, const unsigned first, const unsigned last);
+	static void insert(idset& set, const unsigned id);
+	static void unite(idset& set, const idset& other);
+	static std::vector<unsigned> elements(const idset& set);
+	static void erase_before(idset& set, const unsigned id);
+
+public:
+	RegionGraph() : compressed(true), closure_start(0) {}
+
+	// Add an edge, and update the reachability sets of the nodes
+	void add_edge(node* from, node* to, int weight);
+
+	// Tell if there is a path between 2 nodes, in constant time
+	// The nodes must be in the window of the closure
+	bool reachable(const node* from, const node* to) const;
+
+	// Slide the window of the closure to start at the node firstId
+	// The paths from and to the nodes before firstId are forgotten, so the closure only grows with the window
+	void slide_closure(const unsigned firstId);
+
 	node* get_node(Region* region) {
-		return &nodes[region];
+		return &nodes[ids.at(region)];
 	}
 	const node* get_node(Region* region) const {
-		return &nodes.at(region);
+		return &nodes[ids.at(region)];
+	}
+	node* get_node(const unsigned id) {
+		return &nodes[id];
+	}
+	const node* get_node(const unsigned id) const {
+		return &nodes[id];
+	}
+	unsigned number_nodes() const {
+		return nodes.size();
 	}
 	
-	void add_node(Region* region) {
-		nodes[region] = node(this, region);
+	node* add_node(Region* region) {
+		std::map<Region*, unsigned>::const_iterator it = ids.find(region);
+		if(it != ids.end())
+			return &nodes[it->second];
+		ids[region] = nodes.size();
+		nodes.push_back(node(this, region, nodes.size()));
+		descendants.push_back(idset());
+		ancestors.push_back(idset());
+		compressed = false;
+		return &nodes.back();
+	}
+
+	// Add the nodes of regions, return the id of the first one
+	// The regions get consecutive ids, unless they were already in the graph
+	unsigned add_nodes(const std::vector<Region*>& regions) {
+		const unsigned first = nodes.size();
+		for (unsigned r = 0; r < regions.size(); ++r)
+			add_node(regions[r]);
+		return first;
 	}
 
+	// Color all the nodes, in the order of their id
+	void colorize();
+
 	const_iterator begin() const { return const_iterator(this, nodes.begin()); }
 	const_iterator end() const { return const_iterator(this, nodes.end()); }
 	iterator begin() { return iterator(this, nodes.begin()); }
 	iterator end() { return iterator(this, nodes.end()); }
 };
 
+// The lifetime of a track, i.e. of the regions of the same color
+struct TrackLifetime {
+	// The earliest first observation time of the regions of the track
+	time_t firstObservationTime;
+	// The latest observation time of the regions of the track
+	time_t lastObservationTime;
+	// The number of regions of the track
+	unsigned numberObservations;
+
+	TrackLifetime() : firstObservationTime(0), lastObservationTime(0), numberObservations(0) {}
+
+	// The number of seconds between the first and the last observation of the track
+	unsigned Lifetime() const {
+		return unsigned(difftime(lastObservationTime, firstObservationTime));
+	}
+};
+
+// Compute the lifetime of the tracks of the colored regions of the graph, by color
+std::map<ColorType, TrackLifetime> trackLifetimes(const RegionGraph& tracking_graph);
+
 
 
 //Ordonate the images according to time
@@ -153,9 +264,20 @@ std::vector<unsigned> imageOrder(const std::vector<ColorMap*>& images);
 // Compute the number of pixels common to 2 regions from 2 images, with derotation
 unsigned overlay_derotate(ColorMap* image1, const Region* region1, ColorMap* image2, const Region* region2);
 
+// Compute the number of pixels common to 2 regions from 2 images, with the derotation of image2 into image1
+// The derotation can be shared by all the pairs of regions of the 2 images
+unsigned overlay_derotate(const Derotation& derotation, ColorMap* image1, const Region* region1, ColorMap* image2, const Region* region2);
+
 // Compute the number of pixels common to 2 regions from 2 images
 unsigned overlay(ColorMap* image1, const Region* region1, ColorMap* image2, const Region* region2);
 
+// Compute the number of pixels common to each pair of regions from 2 images, in one pass over the images
+// The key of the map is the position of the regions in regions1 and regions2
+std::map<std::pair<unsigned,unsigned>, unsigned> overlay_matrix(ColorMap* image1, const std::vector<Region*>& regions1, ColorMap* image2, const std::vector<Region*>& regions2, bool derotate = true);
+
+// Compute the number of pixels common to each pair of regions from the runs of pixels of 2 maps, the images give only the coordinates
+std::map<std::pair<unsigned,unsigned>, unsigned> overlay_matrix(ColorMap* image1, const ColorRuns* footprint1, const std::vector<Region*>& regions1, ColorMap* image2, const ColorRuns* footprint2, const std::vector<Region*>& regions2, bool derotate = true);
+
 // Output a graph in the dot format
 void ouputGraph(const RegionGraph& g, const std::vector<std::vector<Region*> >& regions, const std::string graphName, bool isColored = true);
 
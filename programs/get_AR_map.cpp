@@ -63,9 +63,13 @@ mapPreprocessing parameters:
 
 @param cleaning	Cleaning factor in arcsec.
 
+@param footprints	Write the runs of pixels of the map in a Footprints table, so that the regions can be tracked without reading the map.
+
 @param minimalSize	Minal size of regions in arcsec². Smaller regions will be discarded
 
-@param projection	Projection used for the aggregation.
+@param projection	Projection used for the aggregation: none, equirectangular, lambert, sinusoidal, or exact for the slower morphology with discs projected on the sun.
+
+@param runLength	Write the map as a table of runs of pixels instead of an image.
 
 @param useRawArea	When discarding small regions, use raw area instead of real area.
 
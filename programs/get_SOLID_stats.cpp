@@ -23,6 +23,11 @@ global parameters:
 
 @param computeEta	If the enters file do not contain the values for Eta or if you want to force Eta to be recomputed (slow!).
 
+@param fuzzyMapBits	The number of bits (8 or 16) to quantize the fuzzy maps, all the fuzzy maps are then written in a single file.
+<BR>Set to 0 to write each fuzzy map in a separate file without quantization.
+
+@param fuzzyMapsFile	A fits file of fuzzy maps written with fuzzyMapBits. The fuzzy ring stats are computed from it instead of doing the attribution.
+
 @param fuzzyStats	Set this flag if you want fuzzy ring stats.
 
 @param imagePreprocessing	The steps of preprocessing to apply to the sun images.
@@ -124,6 +129,7 @@ See @ref Compilation_Options for constants and parameters for SPoCA at compilati
 #include "../classes/SPoCA2Classifier.h"
 
 #include "../classes/FitsFile.h"
+#include "../classes/QuantizedImage.h"
 
 
 using std::string; using std::cout; using std::cerr; using std::endl;
@@ -138,7 +144,8 @@ string filenamePrefix;
 float rings[] = {0.07, 0.16, 0.25, 0.35, 0.45, 0.55, 0.65, 0.75, 0.85, 0.95, 1.05, 1.15, 1.25, 1.35};
 unsigned number_rings = sizeof rings / sizeof rings[0];
 
-vector<float> get_fuzzy_ring_stats(const EUVImage* fuzzyMap)
+template<class FuzzyMap>
+vector<float> get_fuzzy_ring_stats(const FuzzyMap* fuzzyMap)
 {
 	// We initialise the vector of results
 	vector<float> stats(number_rings + 2, 0);
@@ -288,6 +295,8 @@ int main(int argc, const char **argv)
 	args["output"] = ArgParser::Parameter(".", 'O', "The name for the output file or of a directory.");
 	args["uncompressed"] = ArgParser::Parameter(false, 'u', "Set this flag if you want results maps to be uncompressed.");
 	args["fuzzyStats"] = ArgParser::Parameter(false, 'F', "Set this flag if you want fuzzy ring stats.");
+	args["fuzzyMapBits"] = ArgParser::Parameter(0, 'B', "The number of bits (8 or 16) to quantize the fuzzy maps, all the fuzzy maps are then written in a single file.\nSet to 0 to write each fuzzy map in a separate file without quantization.");
+	args["fuzzyMapsFile"] = ArgParser::Parameter('f', "A fits file of fuzzy maps written with fuzzyMapBits. The fuzzy ring stats are computed from it instead of doing the attribution.");
 	args["fitsFile"] = ArgParser::RemainingPositionalParameters("Path to a fits file", NUMBERCHANNELS, NUMBERCHANNELS);
 	
 	// We parse the arguments
@@ -377,6 +386,27 @@ int main(int argc, const char **argv)
 		filenamePrefix = stripSuffix(outputFile);
 	}
 	
+	// If we have the fuzzy maps, we do not need to do the attribution
+	if(args["fuzzyMapsFile"].is_set())
+	{
+		FitsFile file(args["fuzzyMapsFile"].as<string>());
+		vector< vector<float> > stats;
+		stats.push_back(vector<float>(number_rings + 2, 0));
+		for (unsigned i = 1; file.has("FuzzyMap" + toString(i)); ++i)
+		{
+			file.moveTo("FuzzyMap" + toString(i));
+			QuantizedImage fuzzyMap;
+			fuzzyMap.readFits(file);
+			stats.push_back(get_fuzzy_ring_stats(&fuzzyMap));
+		}
+		write_ring_stats(outputFile, stats, images[0]->ObservationDate());
+		for (unsigned p = 0; p < images.size(); ++p)
+		{
+			delete images[p];
+		}
+		return EXIT_SUCCESS;
+	}
+	
 	// We initialise the Classifier
 	Classifier* F;
 	bool classifierIsPossibilistic = false;
@@ -517,6 +547,12 @@ int main(int argc, const char **argv)
 		
 		stats.push_back(vector<float>(number_rings + 2, 0));
 		
+		// If the fuzzy maps are quantized, they are all written in the same file
+		const unsigned fuzzyMapBits = args["fuzzyMapBits"];
+		FitsFile* fuzzyMapsFile = NULL;
+		if(args["map"] && fuzzyMapBits > 0)
+			fuzzyMapsFile = new FitsFile(filenamePrefix + "FuzzyMaps.fits", FitsFile::overwrite);
+		
 		// We get the fuzzy map for each class
 		for (unsigned i = 0; i < numberClasses; ++i)
 		{
@@ -529,13 +565,18 @@ int main(int argc, const char **argv)
 			stats.push_back(get_fuzzy_ring_stats(fuzzyMap));
 			
 			// We write down the maps
-			if(args["map"])
+			if(fuzzyMapsFile)
+			{
+				fuzzyMap->writeQuantizedFits(*fuzzyMapsFile, 0, 1, fuzzyMapBits, args["uncompressed"] ? 0 : FitsFile::compress, "FuzzyMap" + toString(i+1));
+			}
+			else if(args["map"])
 			{
 				FitsFile file(filenamePrefix + "FuzzyMap." + toString(i+1) + ".fits", FitsFile::overwrite);
 				fuzzyMap->writeFits(file, args["uncompressed"] ? 0 : FitsFile::compress, "FuzzyMap");
 			}
 		}
 		
+		delete fuzzyMapsFile;
 		delete fuzzyMap;
 	}
 	else
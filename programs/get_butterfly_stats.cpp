@@ -0,0 +1,377 @@
+//! This program computes the area of the regions per latitude of many maps, to make a butterfly diagram.
+
+/*!
+<BR>Version: 3.0
+<BR>Author: Benjamin Mampaey, benjamin.mampaey@sidc.be
+
+@section usage Usage
+<tt> bin/get_butterfly_stats.x [-option optionvalue ...]  fitsFile [ fitsFile ... ] </tt>
+
+@param fitsFile	Path to a map fits file, or to a directory containing map fits files
+
+global parameters:
+
+@param help	Print a help message and exit.
+<BR>If you pass the value doxygen, the help message will follow the doxygen convention.
+<BR>If you pass the value config, the help message will write a configuration file template.
+
+@param config	Program option configuration file.
+
+@param corrected	Set to output the area corrected for the projection instead of the number of pixels.
+
+@param fraction	Set to output the fraction of the disk covered by the regions at each latitude.
+
+@param output	The path of the output csv file.
+
+@param separator	The separator to put between columns.
+
+@param threads	The number of maps to process in parallel.
+
+@param tolerance	The maximal difference in pixels between the WCS of maps that share the same latitude geometry.
+<BR>By default half a pixel, so that the sub-pixel drift of the sun center and radius between maps does not require a new geometry.
+
+The output is a time by latitude matrix: one row per map, in chronological order, with the DATE_OBS of the map and one column per latitude from -91 to 90 degrees.
+The pixels are gathered by the closest inferior integral latitude, i.e. the latitude -0.5 goes into the -1 column.
+
+The latitude and area correction of the pixels are computed once for all the maps with the same WCS (cf. ButterflyGeometry).
+Only the few geometries used last are kept, the maps are processed in the order of their name, so consecutive maps usually share their geometry.
+
+@page get_butterfly_stats get_butterfly_stats.x
+
+See @ref Compilation_Options for constants and parameters at compilation time.
+
+*/
+
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <pthread.h>
+
+#include "../classes/tools.h"
+#include "../classes/constants.h"
+#include "../classes/mainutilities.h"
+#include "../classes/ArgParser.h"
+
+#include "../classes/ColorMap.h"
+#include "../classes/FitsFile.h"
+#include "../classes/ButterflyGeometry.h"
+
+using namespace std;
+
+
+string filenamePrefix;
+
+//! The statistics of a map
+struct ButterflyRow
+{
+	string filename;
+	string date_obs;
+	vector<float> regionNumberOfPixels;
+	vector<float> correctedRegionNumberOfPixels;
+	vector<float> totalNumberOfPixels;
+	vector<float> correctedTotalNumberOfPixels;
+	bool good;
+};
+
+//! Comparison of the rows by observation date
+bool earlier(const ButterflyRow* a, const ButterflyRow* b)
+{
+	return a->date_obs < b->date_obs || (a->date_obs == b->date_obs && a->filename < b->filename);
+}
+
+//! Maximal number of geometries kept in the cache, in addition to the ones being used
+static const unsigned maxGeometries = 4;
+
+//! A geometry of the cache
+struct CachedGeometry
+{
+	ButterflyGeometry* geometry;
+	//! Number of threads using the geometry, it cannot be removed from the cache while it is used
+	unsigned users;
+	//! Time of the last use of the geometry, to remove the least recently used
+	unsigned long lastUse;
+};
+
+//! The maps to process by the threads
+struct MapQueue
+{
+	vector<ButterflyRow*> rows;
+	//! The geometries used last, shared by all the threads
+	vector<CachedGeometry> geometries;
+	//! Number of uses of the geometries, used as a clock for the cache
+	unsigned long uses;
+	//! Number of geometries computed
+	unsigned computedGeometries;
+	Real tolerance;
+	//! Mutex for the geometries
+	pthread_mutex_t mutex;
+};
+
+//! Remove the least recently used geometries that are not used, until the cache is not larger than maxGeometries
+/*! The mutex of the queue must be locked */
+void trimGeometries(MapQueue* queue)
+{
+	while(queue->geometries.size() > maxGeometries)
+	{
+		unsigned oldest = queue->geometries.size();
+		for(unsigned g = 0; g < queue->geometries.size(); ++g)
+		{
+			if(queue->geometries[g].users == 0 && (oldest == queue->geometries.size() || queue->geometries[g].lastUse < queue->geometries[oldest].lastUse))
+				oldest = g;
+		}
+		if(oldest == queue->geometries.size())
+			break;
+		delete queue->geometries[oldest].geometry;
+		queue->geometries.erase(queue->geometries.begin() + oldest);
+	}
+}
+
+//! Return the cached geometry that matches the map, or NULL, the geometry is marked as used
+/*! The mutex of the queue must be locked */
+const ButterflyGeometry* findGeometry(MapQueue* queue, ColorMap* map)
+{
+	for(unsigned g = 0; g < queue->geometries.size(); ++g)
+	{
+		if(queue->geometries[g].geometry->matches(map, queue->tolerance))
+		{
+			++queue->geometries[g].users;
+			queue->geometries[g].lastUse = ++queue->uses;
+			return queue->geometries[g].geometry;
+		}
+	}
+	return NULL;
+}
+
+//! Return the geometry of the map, computing it if no geometry of the cache matches
+/*! The geometry must be released with releaseGeometry once it is not used anymore */
+const ButterflyGeometry* acquireGeometry(MapQueue* queue, ColorMap* map)
+{
+	pthread_mutex_lock(&(queue->mutex));
+	const ButterflyGeometry* found = findGeometry(queue, map);
+	pthread_mutex_unlock(&(queue->mutex));
+	if(found)
+		return found;
+
+	// We compute the geometry without the lock, so the other threads can continue
+	ButterflyGeometry* geometry = new ButterflyGeometry(map);
+
+	pthread_mutex_lock(&(queue->mutex));
+	// Another thread may have added a matching geometry in the meantime
+	found = findGeometry(queue, map);
+	if(found)
+	{
+		delete geometry;
+	}
+	else
+	{
+		CachedGeometry cached;
+		cached.geometry = geometry;
+		cached.users = 1;
+		cached.lastUse = ++queue->uses;
+		queue->geometries.push_back(cached);
+		++queue->computedGeometries;
+		trimGeometries(queue);
+		found = geometry;
+	}
+	pthread_mutex_unlock(&(queue->mutex));
+	return found;
+}
+
+//! Routine to tell the cache that the geometry is not used anymore by the thread
+void releaseGeometry(MapQueue* queue, const ButterflyGeometry* geometry)
+{
+	pthread_mutex_lock(&(queue->mutex));
+	for(unsigned g = 0; g < queue->geometries.size(); ++g)
+	{
+		if(queue->geometries[g].geometry == geometry)
+		{
+			--queue->geometries[g].users;
+			break;
+		}
+	}
+	trimGeometries(queue);
+	pthread_mutex_unlock(&(queue->mutex));
+}
+
+//! Routine to compute the statistics of a map
+void processMap(MapQueue* queue, ButterflyRow& row)
+{
+	row.good = false;
+	try
+	{
+		// Only the reading of the file is serialized, the statistics are computed in parallel
+		ColorMap map;
+		pthread_mutex_lock(&fitsMutex);
+		bool read = false;
+		try
+		{
+			FitsFile file(row.filename);
+			map.readFits(file);
+			read = file.isGood();
+		}
+		catch(const exception& error)
+		{
+			cerr<<"Error : reading map "<<row.filename<<" : "<<error.what()<<endl;
+		}
+		pthread_mutex_unlock(&fitsMutex);
+		if(!read)
+		{
+			cerr<<"Error : could not read map from file "<<row.filename<<endl;
+			return;
+		}
+		row.date_obs = map.ObservationDate();
+		const ButterflyGeometry* geometry = acquireGeometry(queue, &map);
+		geometry->accumulate(&map, row.regionNumberOfPixels, row.correctedRegionNumberOfPixels);
+		row.totalNumberOfPixels = geometry->TotalNumberOfPixels();
+		row.correctedTotalNumberOfPixels = geometry->CorrectedTotalNumberOfPixels();
+		releaseGeometry(queue, geometry);
+		row.good = true;
+	}
+	catch(const exception& error)
+	{
+		cerr<<"Error : processing map "<<row.filename<<" : "<<error.what()<<endl;
+	}
+}
+
+//! Work queue routine that processes the map r of the queue
+void processMaps(const unsigned r, void* arg)
+{
+	MapQueue* queue = static_cast<MapQueue*>(arg);
+	processMap(queue, *(queue->rows[r]));
+}
+
+int main(int argc, const char **argv)
+{
+	// We declare our program description
+	string programDescription = "This program computes the area of the regions per latitude of many maps, to make a butterfly diagram.";
+	programDescription+="\nVersion: 3.0";
+	programDescription+="\nAuthor: Benjamin Mampaey, benjamin.mampaey@sidc.be";
+
+	programDescription+="\nCompiled on "  __DATE__  " with options :";
+	programDescription+="\nNUMBERCHANNELS: " + toString(NUMBERCHANNELS);
+	#if defined DEBUG
+	programDescription+="\nDEBUG: ON";
+	#endif
+	#if defined EXTRA_SAFE
+	programDescription+="\nEXTRA_SAFE: ON";
+	#endif
+	#if defined VERBOSE
+	programDescription+="\nVERBOSE: ON";
+	#endif
+	programDescription+="\nEUVPixelType: " + string(typeid(EUVPixelType).name());
+	programDescription+="\nReal: " + string(typeid(Real).name());
+
+	// We define our program parameters
+	ArgParser args(programDescription);
+
+	args["config"] = ArgParser::ConfigurationFile('C');
+	args["help"] = ArgParser::Help('h');
+
+	args["corrected"] = ArgParser::Parameter(false, 'c', "Set to output the area corrected for the projection instead of the number of pixels.");
+	args["fraction"] = ArgParser::Parameter(false, 'f', "Set to output the fraction of the disk covered by the regions at each latitude.");
+	args["threads"] = ArgParser::Parameter(4, 't', "The number of maps to process in parallel.");
+	args["tolerance"] = ArgParser::Parameter(0.5, 'T', "The maximal difference in pixels between the WCS of maps that share the same latitude geometry.\nBy default half a pixel, so that the sub-pixel drift of the sun center and radius between maps does not require a new geometry.");
+	args["separator"] = ArgParser::Parameter(',', 's', "The separator to put between columns.");
+	args["output"] = ArgParser::Parameter("butterfly.csv", 'O', "The path of the output csv file.");
+	args["fitsFile"] = ArgParser::RemainingPositionalParameters("Path to a map fits file, or to a directory containing map fits files", 1);
+
+	// We parse the arguments
+	try
+	{
+		args.parse(argc, argv);
+	}
+	catch(const invalid_argument& error)
+	{
+		cerr<<"Error : "<<error.what()<<endl;
+		cerr<<args.help_message(argv[0])<<endl;
+		return EXIT_FAILURE;
+	}
+
+	unsigned numberThreads = args["threads"];
+	if(numberThreads < 1)
+	{
+		cerr<<"Error : threads must be at least 1."<<endl;
+		return EXIT_FAILURE;
+	}
+
+	// We list the maps
+	vector<string> filenames;
+	deque<string> paths = args.RemainingPositionalArguments();
+	for (unsigned p = 0; p < paths.size(); ++p)
+	{
+		if(isDir(paths[p]))
+			listFitsFiles(paths[p], filenames);
+		else if(isFile(paths[p]))
+			filenames.push_back(paths[p]);
+		else
+			cerr<<"Error : "<<paths[p]<<" is not a file!"<<endl;
+	}
+
+	vector<ButterflyRow> rows(filenames.size());
+	MapQueue queue;
+	queue.tolerance = args["tolerance"];
+	queue.uses = 0;
+	queue.computedGeometries = 0;
+	for (unsigned f = 0; f < filenames.size(); ++f)
+	{
+		rows[f].filename = filenames[f];
+		rows[f].good = false;
+		queue.rows.push_back(&(rows[f]));
+	}
+
+	// We process the maps in parallel, each thread takes the next map of the queue
+	pthread_mutex_init(&(queue.mutex), NULL);
+	processWorkQueue(queue.rows.size(), processMaps, &queue, numberThreads);
+	pthread_mutex_destroy(&(queue.mutex));
+
+	#if defined VERBOSE
+	cout<<"Processed "<<rows.size()<<" maps with "<<queue.computedGeometries<<" different geometries"<<endl;
+	#endif
+
+	// We write the matrix, one row per map in chronological order
+	vector<const ButterflyRow*> sorted;
+	for (unsigned r = 0; r < rows.size(); ++r)
+	{
+		if(rows[r].good)
+			sorted.push_back(&(rows[r]));
+	}
+	sort(sorted.begin(), sorted.end(), earlier);
+
+	string outputFile = args["output"];
+	ofstream csvFile(outputFile.c_str(), ios_base::trunc);
+	if(!csvFile.good())
+	{
+		cerr<<"Error : could not open output file "<<outputFile<<endl;
+		return EXIT_FAILURE;
+	}
+	string separator = args["separator"];
+	bool corrected = args["corrected"];
+	bool fraction = args["fraction"];
+
+	csvFile<<"DATE_OBS";
+	for (unsigned b = 0; b < ButterflyGeometry::numberBins; ++b)
+		csvFile<<separator<<int(b) - 91;
+	csvFile<<endl;
+	for (unsigned r = 0; r < sorted.size(); ++r)
+	{
+		const vector<float>& region = corrected ? sorted[r]->correctedRegionNumberOfPixels : sorted[r]->regionNumberOfPixels;
+		const vector<float>& total = corrected ? sorted[r]->correctedTotalNumberOfPixels : sorted[r]->totalNumberOfPixels;
+		csvFile<<sorted[r]->date_obs;
+		for (unsigned b = 0; b < ButterflyGeometry::numberBins; ++b)
+		{
+			if(fraction)
+				csvFile<<separator<<(total[b] > 0 ? region[b] / total[b] : 0);
+			else
+				csvFile<<separator<<region[b];
+		}
+		csvFile<<endl;
+	}
+	csvFile.close();
+
+	for (unsigned g = 0; g < queue.geometries.size(); ++g)
+		delete queue.geometries[g].geometry;
+
+	return EXIT_SUCCESS;
+}
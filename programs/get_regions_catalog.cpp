@@ -0,0 +1,436 @@
+//! This program aggregates the region tables of map fits files into a single catalog fits file.
+
+/*!
+<BR>Version: 3.0
+<BR>Author: Benjamin Mampaey, benjamin.mampaey@sidc.be
+
+@section usage Usage
+<tt> bin/get_regions_catalog.x [-option optionvalue ...]  fitsFile [ fitsFile ... ] </tt>
+
+@param fitsFile	Path to a map fits file, or to a directory containing map fits files
+
+global parameters:
+
+@param help	Print a help message and exit.
+<BR>If you pass the value doxygen, the help message will follow the doxygen convention.
+<BR>If you pass the value config, the help message will write a configuration file template.
+
+@param config	Program option configuration file.
+
+@param output	The path of the catalog fits file.
+
+@param rebuild	Set to rebuild the catalog from scratch instead of updating it.
+
+@param regionTableName	The name of the region table Hdu
+
+@param threads	The number of maps to read in parallel.
+
+The catalog contains 2 tables:
+ - Regions: one row per region, with the columns FILE_INDEX, ID, COLOR, TRACKED_COLOR, DATE_OBS, FIRST_DATE_OBS, HGS_LONGITUDE, HGS_LATITUDE, NUMBER_PIXELS, AREA_PROJECTED and AREA_DEPROJECTED. The rows are grouped by map, in chronological order.
+ - Files: the time index, one row per map, with the columns FILENAME, MTIME, DATE_OBS, FIRST_ROW and NUMBER_ROWS. FIRST_ROW is the first row (starting at 0) of the regions of the map in the Regions table.
+
+If the catalog already exists, only the maps that are not in it yet, or that have been modified since, are read.
+
+@page get_regions_catalog get_regions_catalog.x
+
+See @ref Compilation_Options for constants and parameters at compilation time.
+
+*/
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <sys/stat.h>
+#include <pthread.h>
+
+#include "../classes/tools.h"
+#include "../classes/constants.h"
+#include "../classes/mainutilities.h"
+#include "../classes/ArgParser.h"
+
+#include "../classes/ColorMap.h"
+#include "../classes/FitsFile.h"
+#include "../classes/FitsTable.h"
+
+using namespace std;
+
+
+string filenamePrefix;
+
+//! A row of the catalog
+struct CatalogRegion
+{
+	unsigned id;
+	ColorType color, tracked_color;
+	string date_obs, first_date_obs;
+	Real hgs_longitude, hgs_latitude;
+	unsigned number_pixels;
+	Real area_projected, area_deprojected;
+};
+
+//! The entry of a map in the catalog
+struct CatalogFile
+{
+	string filename;
+	long mtime;
+	string date_obs;
+	vector<CatalogRegion> regions;
+	bool good;
+};
+
+//! Comparison of the catalog entries by observation date
+bool earlier(const CatalogFile* a, const CatalogFile* b)
+{
+	return a->date_obs < b->date_obs || (a->date_obs == b->date_obs && a->filename < b->filename);
+}
+
+//! Return the modification time of a file, or -1 if it does not exist
+long modificationTime(const string& filename)
+{
+	struct stat statbuf;
+	if(stat(filename.c_str(), &statbuf) != 0)
+		return -1;
+	return long(statbuf.st_mtime);
+}
+
+//! Routine to read the regions of a map from it's region table
+void readMap(CatalogFile& entry, const string& regionTableName)
+{
+	entry.good = false;
+	entry.regions.clear();
+	Header header;
+	FitsTable table;
+	vector<unsigned>& id = table.column<unsigned>("ID");
+	vector<ColorType>& color = table.column<ColorType>("COLOR");
+	vector<ColorType>& tracked_color = table.column<ColorType>("TRACKED_COLOR");
+	vector<string>& date_obs = table.column<string>("DATE_OBS");
+	vector<string>& first_date_obs = table.column<string>("FIRST_DATE_OBS");
+	vector<RealPixLoc>& center = table.column<RealPixLoc>("CENTER");
+	vector<unsigned>& number_pixels = table.column<unsigned>("NUMBER_PIXELS");
+	vector<Real>& area_projected = table.column<Real>("AREA_PROJECTED");
+	vector<Real>& area_deprojected = table.column<Real>("AREA_DEPROJECTED");
+
+	// Only the reading of the file is serialized, the conversion of the centers is done in parallel
+	pthread_mutex_lock(&fitsMutex);
+	bool read = false;
+	try
+	{
+		FitsFile file(entry.filename);
+		file.readHeader(header);
+		if(!file.has(regionTableName))
+		{
+			cerr<<"Error : no table "<<regionTableName<<" in file "<<entry.filename<<endl;
+		}
+		else
+		{
+			file.moveTo(regionTableName);
+			file.readColumns(table);
+			read = true;
+		}
+	}
+	catch(const exception& error)
+	{
+		cerr<<"Error : reading regions of file "<<entry.filename<<" : "<<error.what()<<endl;
+	}
+	pthread_mutex_unlock(&fitsMutex);
+	if(!read)
+		return;
+
+	try
+	{
+		// We only need the WCS of the map to convert the centers to HGS
+		ColorMap map(header);
+		entry.date_obs = map.ObservationDate();
+		entry.regions.resize(table.numberRows());
+		for(unsigned r = 0; r < entry.regions.size(); ++r)
+		{
+			CatalogRegion& region = entry.regions[r];
+			region.id = r < id.size() ? id[r] : 0;
+			region.color = r < color.size() ? color[r] : 0;
+			// Untracked maps have no TRACKED_COLOR nor FIRST_DATE_OBS
+			region.tracked_color = r < tracked_color.size() ? tracked_color[r] : region.color;
+			region.date_obs = r < date_obs.size() ? date_obs[r] : entry.date_obs;
+			region.first_date_obs = r < first_date_obs.size() ? first_date_obs[r] : region.date_obs;
+			HGS hgs = r < center.size() ? map.toHGS(center[r]) : HGS::null();
+			region.hgs_longitude = hgs.longitude * RADIAN2DEGREE;
+			region.hgs_latitude = hgs.latitude * RADIAN2DEGREE;
+			region.number_pixels = r < number_pixels.size() ? number_pixels[r] : 0;
+			region.area_projected = r < area_projected.size() ? area_projected[r] : 0;
+			region.area_deprojected = r < area_deprojected.size() ? area_deprojected[r] : 0;
+		}
+		entry.good = true;
+	}
+	catch(const exception& error)
+	{
+		cerr<<"Error : reading regions of file "<<entry.filename<<" : "<<error.what()<<endl;
+	}
+}
+
+//! The maps to read by the threads
+struct MapQueue
+{
+	vector<CatalogFile*> entries;
+	string regionTableName;
+};
+
+//! Work queue routine that reads the map e of the queue
+void readMaps(const unsigned e, void* arg)
+{
+	MapQueue* queue = static_cast<MapQueue*>(arg);
+	readMap(*(queue->entries[e]), queue->regionTableName);
+}
+
+//! Routine to read an existing catalog
+bool readCatalog(const string& filename, map<string, CatalogFile>& catalog)
+{
+	try
+	{
+		FitsFile file(filename);
+		if(!file.has("Files") || !file.has("Regions"))
+		{
+			cerr<<"Error : file "<<filename<<" is not a regions catalog"<<endl;
+			return false;
+		}
+		FitsTable files;
+		vector<string>& filenames = files.column<string>("FILENAME");
+		vector<long>& mtime = files.column<long>("MTIME");
+		vector<string>& file_date_obs = files.column<string>("DATE_OBS");
+		vector<unsigned>& first_row = files.column<unsigned>("FIRST_ROW");
+		vector<unsigned>& number_rows = files.column<unsigned>("NUMBER_ROWS");
+		file.moveTo("Files").readColumns(files);
+
+		FitsTable regions;
+		vector<unsigned>& id = regions.column<unsigned>("ID");
+		vector<ColorType>& color = regions.column<ColorType>("COLOR");
+		vector<ColorType>& tracked_color = regions.column<ColorType>("TRACKED_COLOR");
+		vector<string>& date_obs = regions.column<string>("DATE_OBS");
+		vector<string>& first_date_obs = regions.column<string>("FIRST_DATE_OBS");
+		vector<Real>& hgs_longitude = regions.column<Real>("HGS_LONGITUDE");
+		vector<Real>& hgs_latitude = regions.column<Real>("HGS_LATITUDE");
+		vector<unsigned>& number_pixels = regions.column<unsigned>("NUMBER_PIXELS");
+		vector<Real>& area_projected = regions.column<Real>("AREA_PROJECTED");
+		vector<Real>& area_deprojected = regions.column<Real>("AREA_DEPROJECTED");
+		file.moveTo("Regions").readColumns(regions);
+
+		for(unsigned f = 0; f < files.numberRows(); ++f)
+		{
+			if(first_row[f] + number_rows[f] > regions.numberRows())
+			{
+				cerr<<"Error : catalog "<<filename<<" is corrupted, file "<<filenames[f]<<" has rows out of the Regions table"<<endl;
+				return false;
+			}
+			CatalogFile& entry = catalog[filenames[f]];
+			entry.filename = filenames[f];
+			entry.mtime = mtime[f];
+			entry.date_obs = file_date_obs[f];
+			entry.good = true;
+			entry.regions.resize(number_rows[f]);
+			for(unsigned r = 0; r < number_rows[f]; ++r)
+			{
+				unsigned row = first_row[f] + r;
+				CatalogRegion& region = entry.regions[r];
+				region.id = id[row];
+				region.color = color[row];
+				region.tracked_color = tracked_color[row];
+				region.date_obs = date_obs[row];
+				region.first_date_obs = first_date_obs[row];
+				region.hgs_longitude = hgs_longitude[row];
+				region.hgs_latitude = hgs_latitude[row];
+				region.number_pixels = number_pixels[row];
+				region.area_projected = area_projected[row];
+				region.area_deprojected = area_deprojected[row];
+			}
+		}
+	}
+	catch(const exception& error)
+	{
+		cerr<<"Error : reading catalog "<<filename<<" : "<<error.what()<<endl;
+		return false;
+	}
+	return true;
+}
+
+//! Routine to write the catalog, the maps are sorted by observation date
+bool writeCatalog(const string& filename, const map<string, CatalogFile>& catalog)
+{
+	vector<const CatalogFile*> entries;
+	unsigned total_rows = 0;
+	for(map<string, CatalogFile>::const_iterator e = catalog.begin(); e != catalog.end(); ++e)
+	{
+		if(e->second.good)
+		{
+			entries.push_back(&(e->second));
+			total_rows += e->second.regions.size();
+		}
+	}
+	sort(entries.begin(), entries.end(), earlier);
+
+	FitsTable regions(total_rows);
+	vector<unsigned>& file_index = regions.column<unsigned>("FILE_INDEX");
+	vector<unsigned>& id = regions.column<unsigned>("ID");
+	vector<ColorType>& color = regions.column<ColorType>("COLOR");
+	vector<ColorType>& tracked_color = regions.column<ColorType>("TRACKED_COLOR");
+	vector<string>& date_obs = regions.column<string>("DATE_OBS");
+	vector<string>& first_date_obs = regions.column<string>("FIRST_DATE_OBS");
+	vector<Real>& hgs_longitude = regions.column<Real>("HGS_LONGITUDE");
+	vector<Real>& hgs_latitude = regions.column<Real>("HGS_LATITUDE");
+	vector<unsigned>& number_pixels = regions.column<unsigned>("NUMBER_PIXELS");
+	vector<Real>& area_projected = regions.column<Real>("AREA_PROJECTED");
+	vector<Real>& area_deprojected = regions.column<Real>("AREA_DEPROJECTED");
+
+	FitsTable files(entries.size());
+	vector<string>& filenames = files.column<string>("FILENAME");
+	vector<long>& mtime = files.column<long>("MTIME");
+	vector<string>& file_date_obs = files.column<string>("DATE_OBS");
+	vector<unsigned>& first_row = files.column<unsigned>("FIRST_ROW");
+	vector<unsigned>& number_rows = files.column<unsigned>("NUMBER_ROWS");
+
+	unsigned row = 0;
+	for(unsigned f = 0; f < entries.size(); ++f)
+	{
+		filenames[f] = entries[f]->filename;
+		mtime[f] = entries[f]->mtime;
+		file_date_obs[f] = entries[f]->date_obs;
+		first_row[f] = row;
+		number_rows[f] = entries[f]->regions.size();
+		for(unsigned r = 0; r < entries[f]->regions.size(); ++r, ++row)
+		{
+			const CatalogRegion& region = entries[f]->regions[r];
+			file_index[row] = f;
+			id[row] = region.id;
+			color[row] = region.color;
+			tracked_color[row] = region.tracked_color;
+			date_obs[row] = region.date_obs;
+			first_date_obs[row] = region.first_date_obs;
+			hgs_longitude[row] = region.hgs_longitude;
+			hgs_latitude[row] = region.hgs_latitude;
+			number_pixels[row] = region.number_pixels;
+			area_projected[row] = region.area_projected;
+			area_deprojected[row] = region.area_deprojected;
+		}
+	}
+
+	try
+	{
+		FitsFile file(filename, FitsFile::overwrite);
+		file.writeTable("Regions", total_rows).writeColumns(regions);
+		file.writeTable("Files", entries.size()).writeColumns(files);
+	}
+	catch(const exception& error)
+	{
+		cerr<<"Error : writing catalog "<<filename<<" : "<<error.what()<<endl;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, const char **argv)
+{
+	// We declare our program description
+	string programDescription = "This program aggregates the region tables of map fits files into a single catalog fits file.";
+	programDescription+="\nVersion: 3.0";
+	programDescription+="\nAuthor: Benjamin Mampaey, benjamin.mampaey@sidc.be";
+
+	programDescription+="\nCompiled on "  __DATE__  " with options :";
+	programDescription+="\nNUMBERCHANNELS: " + toString(NUMBERCHANNELS);
+	#if defined DEBUG
+	programDescription+="\nDEBUG: ON";
+	#endif
+	#if defined EXTRA_SAFE
+	programDescription+="\nEXTRA_SAFE: ON";
+	#endif
+	#if defined VERBOSE
+	programDescription+="\nVERBOSE: ON";
+	#endif
+	programDescription+="\nEUVPixelType: " + string(typeid(EUVPixelType).name());
+	programDescription+="\nReal: " + string(typeid(Real).name());
+
+	// We define our program parameters
+	ArgParser args(programDescription);
+
+	args["config"] = ArgParser::ConfigurationFile('C');
+	args["help"] = ArgParser::Help('h');
+
+	args["regionTableName"] = ArgParser::Parameter("Regions", 'H', "The name of the region table Hdu");
+	args["threads"] = ArgParser::Parameter(4, 't', "The number of maps to read in parallel.");
+	args["rebuild"] = ArgParser::Parameter(false, 'r', "Set to rebuild the catalog from scratch instead of updating it.");
+	args["output"] = ArgParser::Parameter("regions_catalog.fits", 'O', "The path of the catalog fits file.");
+	args["fitsFile"] = ArgParser::RemainingPositionalParameters("Path to a map fits file, or to a directory containing map fits files", 1);
+
+	// We parse the arguments
+	try
+	{
+		args.parse(argc, argv);
+	}
+	catch(const invalid_argument& error)
+	{
+		cerr<<"Error : "<<error.what()<<endl;
+		cerr<<args.help_message(argv[0])<<endl;
+		return EXIT_FAILURE;
+	}
+
+	string catalogFilename = args["output"];
+	unsigned numberThreads = args["threads"];
+	if(numberThreads < 1)
+	{
+		cerr<<"Error : threads must be at least 1."<<endl;
+		return EXIT_FAILURE;
+	}
+
+	// We read the existing catalog
+	map<string, CatalogFile> catalog;
+	if(!args["rebuild"] && isFile(catalogFilename))
+	{
+		if(!readCatalog(catalogFilename, catalog))
+		{
+			cerr<<"Error : could not update catalog "<<catalogFilename<<", use rebuild to recreate it."<<endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// We list the maps
+	vector<string> filenames;
+	deque<string> paths = args.RemainingPositionalArguments();
+	for (unsigned p = 0; p < paths.size(); ++p)
+	{
+		if(isDir(paths[p]))
+			listFitsFiles(paths[p], filenames);
+		else
+			filenames.push_back(paths[p]);
+	}
+
+	// We only read the maps that are new or have been modified
+	MapQueue queue;
+	queue.regionTableName = args["regionTableName"].as<string>();
+	for (unsigned f = 0; f < filenames.size(); ++f)
+	{
+		long mtime = modificationTime(filenames[f]);
+		if(mtime < 0)
+		{
+			cerr<<"Error : "<<filenames[f]<<" is not a file!"<<endl;
+			continue;
+		}
+		map<string, CatalogFile>::iterator entry = catalog.find(filenames[f]);
+		if(entry != catalog.end() && entry->second.mtime == mtime)
+			continue;
+		if(entry == catalog.end())
+			entry = catalog.insert(make_pair(filenames[f], CatalogFile())).first;
+		entry->second.filename = filenames[f];
+		entry->second.mtime = mtime;
+		queue.entries.push_back(&(entry->second));
+	}
+
+	#if defined VERBOSE
+	cout<<"Reading "<<queue.entries.size()<<" new or modified maps"<<endl;
+	#endif
+
+	// We read the maps in parallel, each thread takes the next map of the queue
+	processWorkQueue(queue.entries.size(), readMaps, &queue, numberThreads);
+
+	if(!writeCatalog(catalogFilename, catalog))
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
@@ -204,7 +204,7 @@ int main(int argc, const char **argv)
 	csvFile<<setiosflags(ios::fixed);
 	
 	// We get the regions
-	vector<Region*> regions = getRegions(regionMap);
+	vector<Region*> regions = getRegions(regionMap, true);
 	
 	if(regions.empty())
 	{
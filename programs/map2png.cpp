@@ -19,14 +19,22 @@ global parameters:
 
 @param config	Program option configuration file.
 
+@param cacheContours	Set to store the contours in the color map FITS file, and to reuse them when the same map is converted again.
+<BR>The contours are recomputed if the regions are filled, recolored or transformed, or if the map has changed.
+
 @param colors	The list of color of the regions to plot separated by commas or a file containg such a list. All regions will be selected if ommited.
 
 @param fill	Set this flag if you want to fill holes in the regions before ploting.
 
+@param width	Set to the width in pixels of the contours if you want to plot the contours of the regions instead of the regions.
+
 @param upperLabel	The label to write on the upper left corner.
 <BR>If set but no value is passed, a default label will be written.
 <BR>You can use keywords from the color map fits file by specifying them between {}
 
+@param internal	Set this flag if you want the contours inside the regions.
+<BR>Will be outside otherwise.
+
 @param lowerLabel	The label to write on the lower left corner.
 <BR>You can use keywords from the color map fits file by specifying them between {}
 
@@ -61,6 +69,7 @@ See @ref Compilation_Options for constants and parameters at compilation time.
 #include "../classes/ArgParser.h"
 
 #include "../classes/ColorMap.h"
+#include "../classes/Contours.h"
 #include "../classes/MagickImage.h"
 
 using namespace std;
@@ -102,6 +111,9 @@ int main(int argc, const char **argv)
 	args["upperLabel"] = ArgParser::Parameter("", 'L', "The label to write on the upper left corner.\nIf set but no value is passed, a default label will be written.\nYou can use keywords from the color map fits file by specifying them between {}");
 	args["lowerLabel"] = ArgParser::Parameter("{CLASTYPE} {CPREPROC}", 'l', "The label to write on the lower left corner.\nYou can use keywords from the color map fits file by specifying them between {}");
 	args["fill"] = ArgParser::Parameter(false, 'f', "Set this flag if you want to fill holes in the regions before ploting.");
+	args["width"] = ArgParser::Parameter(0, 'w', "Set to the width in pixels of the contours if you want to plot the contours of the regions instead of the regions.");
+	args["internal"] = ArgParser::Parameter(false, 'i', "Set this flag if you want the contours inside the regions.\nWill be outside otherwise.");
+	args["cacheContours"] = ArgParser::Parameter(false, 'K', "Set to store the contours in the color map FITS file, and to reuse them when the same map is converted again.\nThe contours are recomputed if the regions are filled, recolored or transformed, or if the map has changed.");
 	args["colors"] = ArgParser::Parameter("", 'c', "The list of color of the regions to plot separated by commas or a file containg such a list. All regions will be selected if ommited.");
 	args["uniqueColor"] = ArgParser::Parameter(7, 'U', "Set to a color if you want all regions to be plotted in that color.\nSee gradient image for the color number.");
 	args["transparent"] = ArgParser::Parameter(false, 't', "If you want the null values to be transparent.");
@@ -268,6 +280,30 @@ int main(int argc, const char **argv)
 		#endif
 	}
 	
+	// We plot the contours if requested
+	unsigned width = args["width"];
+	if(width > 0)
+	{
+		// The contours stored in the map file can be reused only if the regions have not been modified
+		bool cacheContours = args["cacheContours"] && !args["fill"] && colors.empty() && !args["uniqueColor"].is_set() && !args["straightenUp"] && !args["recenter"].is_set() && !args["scaling"].is_set();
+		Contours mapContours;
+		if(!cacheContours || !mapContours.readCache(args["fitsFile"]) || mapContours.Xaxes() != colorMap->Xaxes() || mapContours.Yaxes() != colorMap->Yaxes())
+		{
+			mapContours.extract(colorMap, 0);
+			if(cacheContours)
+				mapContours.writeCache(args["fitsFile"]);
+		}
+		
+		if(args["internal"])
+			mapContours.drawIntern(colorMap, width, 0);
+		else
+			mapContours.drawExtern(colorMap, width, 0);
+		
+		#if defined DEBUG
+		colorMap->writeFits(filenamePrefix + "contours.fits");
+		#endif
+	}
+	
 	// We make the png
 	MagickImage outputImage = colorMap->magick(backgroundColor);
 	
@@ -20,6 +20,9 @@ global parameters:
 
 @param config	Program option configuration file.
 
+@param cacheContours	Set to store the contours in the color map FITS file, and to reuse them when the same map is overlayed again.
+<BR>The contours are recomputed if the regions are filled, recolored or transformed, or if the map has changed.
+
 @param colors	The list of color of the regions to plot separated by commas or a file containg such a list. All regions will be selected if ommited.
 
 @param fill	Set this flag if you want to fill holes in the regions before ploting the contours.
@@ -87,6 +90,7 @@ See @ref Compilation_Options for constants and parameters at compilation time.
 #include "../classes/ArgParser.h"
 
 #include "../classes/ColorMap.h"
+#include "../classes/Contours.h"
 #include "../classes/MagickImage.h"
 #include "../classes/EUVImage.h"
 
@@ -134,6 +138,7 @@ int main(int argc, const char **argv)
 	args["lowerLabel"] = ArgParser::Parameter("{CLASTYPE} {CPREPROC}", 'l', "The label to write on the lower left corner.\nYou can use keywords from the color map fits file by specifying them between {}");
 	args["width"] = ArgParser::Parameter(1, 'w', "The width of the contour in pixels.");
 	args["internal"] = ArgParser::Parameter(false, 'i', "Set this flag if you want the contours inside the regions.\nWill be outside otherwise.");
+	args["cacheContours"] = ArgParser::Parameter(false, 'K', "Set to store the contours in the color map FITS file, and to reuse them when the same map is overlayed again.\nThe contours are recomputed if the regions are filled, recolored or transformed, or if the map has changed.");
 	args["fill"] = ArgParser::Parameter(false, 'f', "Set this flag if you want to fill holes in the regions before ploting the contours.");
 	args["colors"] = ArgParser::Parameter("", 'c', "The list of color of the regions to plot separated by commas or a file containg such a list. All regions will be selected if ommited.");
 	args["uniqueColor"] = ArgParser::Parameter(7, 'U', "Set to a color if you want all contours to be plotted in that color.\nSee gradient image for the color number.");
@@ -309,10 +314,20 @@ int main(int argc, const char **argv)
 		width = toUnsigned(args["width"]);
 	}
 	
+	// The contours stored in the map file can be reused only if the regions have not been modified
+	bool cacheContours = args["cacheContours"] && !args["fill"] && colors.empty() && !args["uniqueColor"].is_set() && !args["straightenUp"] && !args["recenter"].is_set() && !args["scaling"].is_set();
+	Contours mapContours;
+	if(!cacheContours || !mapContours.readCache(args["mapFitsFile"]) || mapContours.Xaxes() != colorMap->Xaxes() || mapContours.Yaxes() != colorMap->Yaxes())
+	{
+		mapContours.extract(colorMap, 0);
+		if(cacheContours)
+			mapContours.writeCache(args["mapFitsFile"]);
+	}
+	
 	if(args["internal"])
-		colorMap->drawInternContours(width, 0);
+		mapContours.drawIntern(colorMap, width, 0);
 	else
-		colorMap->drawExternContours(width, 0);
+		mapContours.drawExtern(colorMap, width, 0);
 	
 	#if defined DEBUG
 	colorMap->writeFits(filenamePrefix + "contours.fits");
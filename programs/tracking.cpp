@@ -23,14 +23,59 @@ global parameters:
 
 @param maxDeltaT	The maximal number of seconds between 2 tracked regions
 
+@param minLifetime	The minimal number of seconds a track must live. The regions of the shorter tracks are flagged in the table of regions, and erased from the maps if recolorImages is set.
+
 @param newColor	The first color to attribute to a new untracked region
 
 @param recolorImages	Set this flag if you want all images to be colored and written to disk.Otherwise only the region table is updated.
 
+@param footprints	Set this flag to keep only the runs of pixels of the maps in memory instead of the full maps.
+
+@param finalize	Set this flag to write the results of all the maps of the tracking window, even the ones whose colors could still change with the next maps.
+
+@param reconcile	The path of a color lookup table file. Set this to reconcile the colors of maps tracked in separate shards, instead of tracking them.
+
 @param regionTableName	The name of the region table Hdu
 
+@param state	The path of a state file to track the maps incrementally.
+
+@param threads	The number of pairs of maps to compare in parallel.
+
 @param uncompressed	Set this flag if you want results maps to be uncompressed.
 
+When all the maps are tracked at once or reconciled, the lifetime of the track of each region (from the earliest FIRST_DATE_OBS to the latest DATE_OBS of it's color)
+and the number of regions of the track are written in the LIFETIME and NUMBER_OBSERVATIONS columns of the table of regions.
+With minLifetime, the regions of the shorter tracks are flagged in the SHORT_LIVED column, and erased from the maps if recolorImages is set,
+in the same pass as the colors are written (this replaces scripts/clean_map_of_shortlived_regions.py).
+
+If a state file is given, the maps are tracked incrementally: the fits files must be more recent than the maps already tracked.
+The state file keeps the tracking window between runs: the header and the regions of the recent maps with their runs of pixels,
+the edges of the tracking graph between them, and the latest color.
+A new map is only compared to the maps of the window, and the fits file of a map is updated only once, when the colors of it's regions cannot change anymore,
+i.e. when a map at least maxDeltaT more recent has been tracked. The maps more than 2 maxDeltaT older than the latest map are removed from the window.
+The colors are the same as when all the maps are tracked at once.
+
+The overlap of the regions of the pairs of maps to compare are computed in parallel, the edges of the tracking graph are then added in the order of time.
+The colors do not depend on the number of threads.
+
+With footprints, each map is kept in memory only as runs of pixels (cf. ColorRuns), which is much smaller than the map, and the overlaps are computed on the runs.
+If a map file has a table of regions and the map is stored as runs, or has a Footprints table (cf. the runLength and footprints parameters of get_AR_map and get_CH_map), the pixels of the map are never read.
+The runs are cropped to the disk, like the full maps.
+The map is decoded from it's runs only when it must be recolored. The colors are the same as when tracking the full maps.
+
+A long period can be tracked in shards, e.g. one per month, by separate runs with disjoint ranges of colors (cf. newColor).
+The maps tracked in the same run are identified by the date of their first map, written in the TSTART keyword of the table of regions.
+The shards are then reconciled by a run with reconcile, given the maps of all the shards (with footprints, only the headers and the runs of the maps around the seams are read).
+Only the maps at most 2 maxDeltaT around a seam are tracked again: the maps at most maxDeltaT around the seam get new colors,
+and the tracks of the second shard that continue across the seam take the new color of their last region near the seam.
+The other maps of the shards are updated with these new colors, in the table of regions, the tracking relations, and the map if recolorImages is set.
+The first observation date of the tracks that start from these tracks after the seam is propagated from the tracking relations.
+The color lookup table from the colors of the shards to the new colors is written to the reconcile file, in the format of recolor_map.x.
+The tracks are the same as when all the maps are tracked at once, but their colors are not.
+The lifetimes of the tracks are then computed again from the tables of regions of all the maps, and the regions of the short-lived tracks are flagged and erased with the minLifetime of the reconcile run, or of the shards if it is not given.
+The short-lived regions of a shard may belong to a track that continues across a seam, so the shards cannot be reconciled if they were tracked with minLifetime and recolorImages.
+A shard must span more than 4 maxDeltaT.
+
 See @ref Compilation_Options for constants and parameters for SPoCA at compilation time.
 
 */
@@ -43,6 +88,8 @@ See @ref Compilation_Options for constants and parameters for SPoCA at compilati
 #include <iomanip>
 #include <ctime>
 #include <algorithm>
+#include <cstdio>
+#include <set>
 
 #include "../classes/tools.h"
 #include "../classes/constants.h"
@@ -50,6 +97,7 @@ See @ref Compilation_Options for constants and parameters for SPoCA at compilati
 #include "../classes/ArgParser.h"
 
 #include "../classes/ColorMap.h"
+#include "../classes/ColorRuns.h"
 #include "../classes/Region.h"
 #include "../classes/trackable.h"
 #include "../classes/TrackingRelation.h"
@@ -61,6 +109,957 @@ using namespace std;
 
 string filenamePrefix;
 
+//! A map of regions to track
+struct TrackedMap
+{
+	string filename;
+	//! The map, when it is tracked from it's footprint the image has only the header and no pixels
+	ColorMap* image;
+	//! The runs of pixels of the map, NULL if it is tracked from it's image
+	ColorRuns* footprint;
+	vector<Region*> regions;
+	//! Id of the node of the first region in the tracking graph, the regions have consecutive ids
+	unsigned firstNode;
+	//! Set when the colors of the regions cannot change anymore and the results have been written
+	bool finalized;
+	//! Observation date of the first map tracked together with this one, it identifies the shard of the map
+	string trackingStart;
+};
+
+//! An edge of the tracking graph, between the regions of the tracking window
+struct TrackedEdge
+{
+	unsigned fromMap, fromRegion, toMap, toRegion;
+	int weight;
+
+	//! Order in which the edges must be added to the graph to be the same as during tracking
+	bool operator<(const TrackedEdge& e) const
+	{
+		if(toMap != e.toMap)
+			return toMap < e.toMap;
+		// The closest maps are compared first
+		if(fromMap != e.fromMap)
+			return fromMap > e.fromMap;
+		if(fromRegion != e.fromRegion)
+			return fromRegion < e.fromRegion;
+		return toRegion < e.toRegion;
+	}
+};
+
+//! Routine to read a map and it's regions from a fits file
+/*! If runs is set, the runs of pixels of the regions are always computed.
+If footprints is set, the map is kept only as runs of pixels. If the file has a region table and the map is stored as runs, or with a table of Footprints, the pixels of the map are not even read. */
+void readTrackedMap(const string& filename, const string& regionTableName, const bool runs, const bool footprints, TrackedMap& map)
+{
+	FitsFile file(filename);
+	map.filename = filename;
+	map.finalized = false;
+	map.footprint = NULL;
+	map.trackingStart = "";
+	if(footprints && file.has(regionTableName) && (file.isTable() || file.has("Footprints")))
+	{
+		// We get only the header of the map, to know it's coordinates
+		Header header;
+		file.readHeader(header);
+		map.image = new ColorMap(header);
+		map.image->parseHeader();
+		if(!file.isTable())
+			file.moveTo("Footprints");
+		map.footprint = new ColorRuns();
+		map.footprint->readFits(file);
+		
+		// We crop the runs, like the image
+		map.footprint->nullifyAboveRadius(map.image->SunCenter(), map.image->SunRadius());
+	}
+	else
+	{
+		// We get the image
+		map.image = new ColorMap();
+		map.image->readFits(file);
+
+		// We crop the image
+		map.image->nullifyAboveRadius(1);
+	}
+
+	// If there is a table of regions, we use it to extract the regions
+	if(file.has(regionTableName))
+	{
+		file.moveTo(regionTableName);
+		readRegions(file, map.regions, true);
+		Header tracking_info;
+		file.readHeader(tracking_info);
+		if(tracking_info.has("TNEWCOLR"))
+		{
+			ColorType latest_color = tracking_info.get<ColorType>("TNEWCOLR");
+			newColor = latest_color > newColor ? latest_color : newColor;
+		}
+		if(runs)
+		{
+			for (unsigned r = 0; r < map.regions.size(); ++r)
+			{
+				if(map.footprint)
+					map.regions[r]->computeRuns(map.footprint);
+				else
+					map.regions[r]->computeRuns(map.image);
+			}
+		}
+	}
+	else // We extract the regions from the map
+	{
+		map.regions = getRegions(map.image, true);
+		if(! (map.image->getHeader().has("TRACKED") && map.image->getHeader().get<bool>("TRACKED")))
+		{
+			for (unsigned r = 0; r < map.regions.size(); ++r)
+				map.regions[r]->setColor(0);
+		}
+		if(map.image->getHeader().has("TNEWCOLR"))
+		{
+			ColorType latest_color = map.image->getHeader().get<ColorType>("TNEWCOLR");
+			newColor = latest_color > newColor ? latest_color : newColor;
+		}
+	}
+
+	// We keep only the runs of the map, the pixels are decoded again if the map must be recolored
+	if(footprints && !map.footprint)
+	{
+		map.footprint = new ColorRuns(map.image);
+		map.image->resize(0, 0);
+	}
+}
+
+//! The overlap of the regions of 2 maps to track
+struct TrackedPair
+{
+	const TrackedMap* map1;
+	const TrackedMap* map2;
+	map<pair<unsigned,unsigned>, unsigned> intersectPixels;
+};
+
+//! The pairs of maps whose overlap is computed by the threads
+struct PairQueue
+{
+	vector<TrackedPair>* pairs;
+	bool derotate;
+};
+
+//! Work queue routine that computes the overlap of the pair p of the queue
+/*! The overlap only reads the maps and their regions, so the pairs can be computed in any order */
+void computeOverlap(const unsigned p, void* arg)
+{
+	PairQueue* queue = static_cast<PairQueue*>(arg);
+	TrackedPair& trackedPair = (*(queue->pairs))[p];
+	if(trackedPair.map1->footprint && trackedPair.map2->footprint)
+		trackedPair.intersectPixels = overlay_matrix(trackedPair.map1->image, trackedPair.map1->footprint, trackedPair.map1->regions, trackedPair.map2->image, trackedPair.map2->footprint, trackedPair.map2->regions, queue->derotate);
+	else
+		trackedPair.intersectPixels = overlay_matrix(trackedPair.map1->image, trackedPair.map1->regions, trackedPair.map2->image, trackedPair.map2->regions, queue->derotate);
+}
+
+//! Routine to compute the overlap of the pairs of maps with numberThreads threads
+void computeOverlaps(vector<TrackedPair>& pairs, const bool derotate, const unsigned numberThreads)
+{
+	PairQueue queue;
+	queue.pairs = &pairs;
+	queue.derotate = derotate;
+	processWorkQueue(pairs.size(), computeOverlap, &queue, numberThreads);
+
+	#if defined DEBUG
+	// The fits files are written by the main thread, once the overlaps are computed
+	for (unsigned p = 0; p < pairs.size(); ++p)
+	{
+		if(derotate && !pairs[p].map1->footprint)
+		{
+			SunImage<ColorType>* rotated = pairs[p].map1->image->shifted_like(pairs[p].map2->image);
+			rotated->writeFits("rotated_"+ stripSuffix(stripPath(pairs[p].map1->filename)) + "_to_" + stripSuffix(stripPath(pairs[p].map2->filename))+".fits");
+			delete rotated;
+		}
+	}
+	#endif
+}
+
+//! Routine to list the pairs of maps to compare, each map from first with the previous maps, the closest first
+/*! This gives the same edges as comparing all pairs of maps from the closest to the furthest */
+void listPairs(const vector<const TrackedMap*>& sequence, const unsigned first, const unsigned maxDeltaT, vector<TrackedPair>& pairs)
+{
+	for (unsigned s = first; s < sequence.size(); ++s)
+	{
+		for (unsigned d = 1; d <= s; ++d)
+		{
+			//If the time difference between the 2 images is too big, we don't need to continue
+			unsigned delta_t = unsigned(difftime(sequence[s]->image->ObservationTime(), sequence[s - d]->image->ObservationTime()));
+			if (delta_t > maxDeltaT)
+			{
+				break;
+			}
+			TrackedPair trackedPair;
+			trackedPair.map1 = sequence[s - d];
+			trackedPair.map2 = sequence[s];
+			pairs.push_back(trackedPair);
+		}
+	}
+}
+
+//! Routine to add the edges between the regions of 2 maps, from the overlap of their regions
+/*! According to Cis we create an edge between 2 regions if they overlap and if there is not already a path between them */
+void trackRegions(RegionGraph& tracking_graph, const TrackedMap& map1, const TrackedMap& map2, const map<pair<unsigned,unsigned>, unsigned>& intersectPixels)
+{
+	// The pairs are ordered by region, so the edges are added in the same order as when comparing each pair of regions
+	for (map<pair<unsigned,unsigned>, unsigned>::const_iterator it = intersectPixels.begin(); it != intersectPixels.end(); ++it)
+	{
+		RegionGraph::node* node1 = tracking_graph.get_node(map1.firstNode + it->first.first);
+		RegionGraph::node* node2 = tracking_graph.get_node(map2.firstNode + it->first.second);
+		if(it->second > 0 && !node1->path(node2))
+		{
+			tracking_graph.add_edge(node1, node2, it->second);
+		}
+	}
+}
+
+//! Routine to fill the columns of the lifetime of the track of the regions, in the table of regions
+/*! The table must have one row per region, given by the color of it's track. The regions whose color is in shortLivedColors are flagged if flagShortLived is set */
+void fillLifetimeColumns(FitsTable& table, const vector<ColorType>& colors, const std::map<ColorType, TrackLifetime>& lifetimes, const set<ColorType>& shortLivedColors, const bool flagShortLived)
+{
+	vector<unsigned>& lifetime = table.column<unsigned>("LIFETIME");
+	vector<unsigned>& number_observations = table.column<unsigned>("NUMBER_OBSERVATIONS");
+	for (unsigned r = 0; r < colors.size(); ++r)
+	{
+		std::map<ColorType, TrackLifetime>::const_iterator track = lifetimes.find(colors[r]);
+		lifetime[r] = track != lifetimes.end() ? track->second.Lifetime() : 0;
+		number_observations[r] = track != lifetimes.end() ? track->second.numberObservations : 0;
+	}
+	if(flagShortLived)
+	{
+		vector<int>& short_lived = table.column<int>("SHORT_LIVED");
+		for (unsigned r = 0; r < colors.size(); ++r)
+			short_lived[r] = shortLivedColors.count(colors[r]) > 0 ? 1 : 0;
+	}
+}
+
+//! Routine to write the colors of the regions of a map and their tracking relations to it's fits file
+/*! If the lifetimes of the tracks are given, they are written in the table of regions,
+and the regions whose track lived less than minLifetime seconds are flagged, and erased from the map if recolorImages is set. */
+void writeTrackedMap(TrackedMap& map, const RegionGraph& tracking_graph, const string& regionTableName, const bool recolorImages, const int compressed_fits, const unsigned maxDeltaT, const bool derotate, const unsigned numberImages, const std::map<ColorType, TrackLifetime>* lifetimes = NULL, const unsigned minLifetime = 0)
+{
+	FitsFile file(map.filename, FitsFile::update);
+
+	set<ColorType> shortLivedColors;
+	if(lifetimes && minLifetime > 0)
+	{
+		for (unsigned r = 0; r < map.regions.size(); ++r)
+		{
+			std::map<ColorType, TrackLifetime>::const_iterator track = lifetimes->find(map.regions[r]->Color());
+			if(track != lifetimes->end() && track->second.Lifetime() < minLifetime)
+				shortLivedColors.insert(map.regions[r]->Color());
+		}
+	}
+
+	if(recolorImages)
+	{
+		// If we only kept the footprint, we decode the map for the time to write it
+		if(map.footprint)
+			map.footprint->decode(map.image);
+		// We color the image and overwrite them in the fitsfile
+		recolorFromRegions(map.image, map.regions);
+		if(shortLivedColors.size() > 0)
+			map.image->eraseColors(shortLivedColors);
+		map.image->getHeader().set("TRACKED", true, "Map has been tracked");
+		// All the pixels of the map have the color of their region, so we know the greatest color
+		ColorType maxColor = 0;
+		for (unsigned r = 0; r < map.regions.size(); ++r)
+			maxColor = map.regions[r]->Color() > maxColor ? map.regions[r]->Color() : maxColor;
+		map.image->writeFits(file, FitsFile::update|compressed_fits, "", maxColor);
+		if(map.footprint)
+			map.image->resize(0, 0);
+	}
+
+	file.moveTo(regionTableName);
+
+	// We write a nice header with info on the tracking
+	Header tracking_info;
+	tracking_info.set("TNEWCOLR", newColor, "Tracking latest color");
+	tracking_info.set("TMAXDELT", maxDeltaT, "Tracking maxDeltaT");
+	tracking_info.set("TDEROT", derotate, "Tracking derotate");
+	tracking_info.set("TNBRIMG", numberImages, "Tracking number images");
+	tracking_info.set("TSTART", map.trackingStart, "Tracking date of the first map");
+	if(lifetimes && minLifetime > 0)
+		tracking_info.set("TMINLIFE", minLifetime, "Tracking minLifetime");
+	// The erased regions cannot be restored, so the map cannot be reconciled with another shard anymore
+	if(recolorImages && lifetimes && minLifetime > 0)
+		tracking_info.set("TERASED", true, "Tracking short-lived regions erased");
+	tracking_info.set("TRACKED", true, "Regions have been tracked");
+	file.writeHeader(tracking_info);
+
+	// We update the table of regions with the new colors and first_date_obs
+	// We assume that the regions are in the same order than in the fits file(i.e. same id)
+	FitsTable table(map.regions.size());
+	vector<ColorType>& tracked_colors = table.column<ColorType>("TRACKED_COLOR");
+	vector<string>& first_observation_dates = table.column<string>("FIRST_DATE_OBS");
+	for (unsigned r = 0; r < map.regions.size(); ++r)
+	{
+		tracked_colors[r] = map.regions[r]->Color();
+		first_observation_dates[r] = map.regions[r]->FirstObservationDate();
+	}
+
+	//If we recolor the images we update the color column
+	if(recolorImages)
+		table.column<ColorType>("COLOR") = tracked_colors;
+
+	// We add the lifetime of the track of the regions
+	if(lifetimes)
+		fillLifetimeColumns(table, tracked_colors, *lifetimes, shortLivedColors, minLifetime > 0);
+
+	file.writeColumns(table, FitsFile::overwrite);
+
+	// We write the relations in a table of the FITS file
+	writeTrackingRelations(file, map.regions, tracking_graph, map.image->PixelLength() * map.image->PixelWidth());
+	map.finalized = true;
+}
+
+//! Routine to write the tracking window to a state file
+void writeTrackingState(const string& filename, const vector<TrackedMap>& window, const RegionGraph& tracking_graph, const unsigned maxDeltaT, const bool derotate)
+{
+	// We write a temporary file, so the previous state is not lost if something goes wrong
+	const string temporaryFilename = filename + ".tmp";
+	{
+		FitsFile file(temporaryFilename, FitsFile::overwrite);
+
+		FitsTable maps(window.size());
+		vector<string>& filenames = maps.column<string>("FILENAME");
+		vector<unsigned>& xAxes = maps.column<unsigned>("XAXES");
+		vector<unsigned>& yAxes = maps.column<unsigned>("YAXES");
+		vector<int>& finalized = maps.column<int>("FINALIZED");
+		map<const Region*, pair<unsigned, unsigned> > positions;
+		for (unsigned m = 0; m < window.size(); ++m)
+		{
+			filenames[m] = window[m].filename;
+			xAxes[m] = window[m].footprint ? window[m].footprint->Xaxes() : window[m].image->Xaxes();
+			yAxes[m] = window[m].footprint ? window[m].footprint->Yaxes() : window[m].image->Yaxes();
+			finalized[m] = window[m].finalized ? 1 : 0;
+			for (unsigned r = 0; r < window[m].regions.size(); ++r)
+				positions[window[m].regions[r]] = make_pair(m, r);
+		}
+		file.writeTable("TrackingMaps");
+		file.writeColumns(maps);
+		Header state;
+		state.set("TNEWCOLR", newColor, "Tracking latest color");
+		state.set("TMAXDELT", maxDeltaT, "Tracking maxDeltaT");
+		state.set("TDEROT", derotate, "Tracking derotate");
+		if(window.size() > 0)
+			state.set("TSTART", window[0].trackingStart, "Tracking date of the first map");
+		file.writeHeader(state);
+
+		// We keep the edges between the regions of the window, in the order they were added
+		vector<TrackedEdge> edges;
+		for (unsigned m = 0; m < window.size(); ++m)
+		{
+			for (unsigned r = 0; r < window[m].regions.size(); ++r)
+			{
+				const RegionGraph::node* n = tracking_graph.get_node(window[m].firstNode + r);
+				for (RegionGraph::node::const_iterator it = n->in_begin(); it != n->in_end(); ++it)
+				{
+					map<const Region*, pair<unsigned, unsigned> >::const_iterator from = positions.find(it->from->get_region());
+					if(from == positions.end())
+						continue;
+					TrackedEdge edge = {from->second.first, from->second.second, m, r, it->weight};
+					edges.push_back(edge);
+				}
+			}
+		}
+		sort(edges.begin(), edges.end());
+		FitsTable table(edges.size());
+		vector<unsigned>& from_map = table.column<unsigned>("FROM_MAP");
+		vector<unsigned>& from_region = table.column<unsigned>("FROM_REGION");
+		vector<unsigned>& to_map = table.column<unsigned>("TO_MAP");
+		vector<unsigned>& to_region = table.column<unsigned>("TO_REGION");
+		vector<int>& weight = table.column<int>("WEIGHT");
+		for (unsigned e = 0; e < edges.size(); ++e)
+		{
+			from_map[e] = edges[e].fromMap;
+			from_region[e] = edges[e].fromRegion;
+			to_map[e] = edges[e].toMap;
+			to_region[e] = edges[e].toRegion;
+			weight[e] = edges[e].weight;
+		}
+		file.writeTable("TrackingEdges");
+		file.writeColumns(table);
+
+		// We keep the header of the maps, to be able to derotate them, and their regions with their runs
+		for (unsigned m = 0; m < window.size(); ++m)
+		{
+			file.writeTable("Regions_" + toString(m));
+			writeRegions(file, window[m].regions);
+			file.writeHeader(window[m].image->getHeader());
+			file.writeTable("Runs_" + toString(m));
+			writeRegionRuns(file, window[m].regions);
+		}
+		if(!file.isGood())
+		{
+			cerr<<"Error : writing the tracking state to "<<temporaryFilename<<endl;
+			return;
+		}
+	}
+	if(rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+		cerr<<"Error : could not rename "<<temporaryFilename<<" to "<<filename<<endl;
+}
+
+//! Routine to read the tracking window from a state file
+/*! If footprints is set, the maps are restored as runs of pixels instead of images */
+bool readTrackingState(const string& filename, vector<TrackedMap>& window, RegionGraph& tracking_graph, const unsigned maxDeltaT, const bool derotate, const bool footprints)
+{
+	FitsFile file(filename);
+	if(!file.has("TrackingMaps") || !file.has("TrackingEdges"))
+	{
+		cerr<<"Error : "<<filename<<" is not a tracking state file."<<endl;
+		return false;
+	}
+	file.moveTo("TrackingMaps");
+	Header state;
+	file.readHeader(state);
+	// If the parameters change, the colors would not be the same as when tracking all the maps at once
+	if(!state.has("TMAXDELT") || state.get<unsigned>("TMAXDELT") != maxDeltaT || !state.has("TDEROT") || state.get<bool>("TDEROT") != derotate)
+	{
+		cerr<<"Error : the tracking state "<<filename<<" was made with a different maxDeltaT or derotate."<<endl;
+		return false;
+	}
+	if(state.has("TNEWCOLR"))
+	{
+		ColorType latest_color = state.get<ColorType>("TNEWCOLR");
+		newColor = latest_color > newColor ? latest_color : newColor;
+	}
+	FitsTable maps;
+	vector<string>& filenames = maps.column<string>("FILENAME");
+	vector<unsigned>& xAxes = maps.column<unsigned>("XAXES");
+	vector<unsigned>& yAxes = maps.column<unsigned>("YAXES");
+	vector<int>& finalized = maps.column<int>("FINALIZED");
+	file.readColumns(maps);
+
+	for (unsigned m = 0; m < filenames.size(); ++m)
+	{
+		TrackedMap map;
+		map.filename = filenames[m];
+		map.finalized = finalized[m] != 0;
+		map.trackingStart = state.has("TSTART") ? state.get<string>("TSTART") : "";
+		file.moveTo("Regions_" + toString(m));
+		Header header;
+		file.readHeader(header);
+		map.image = new ColorMap(header, footprints ? 0 : xAxes[m], footprints ? 0 : yAxes[m]);
+		// The constructor only parses the header as a SunImage
+		map.image->parseHeader();
+		readRegions(file, map.regions);
+		file.moveTo("Runs_" + toString(m));
+		readRegionRuns(file, map.regions);
+
+		// We paint each region with it's own color, to compute the overlap with the next maps
+		map.footprint = NULL;
+		if(footprints)
+		{
+			vector<PixLoc> start;
+			vector<unsigned> length;
+			vector<ColorType> color;
+			for (unsigned r = 0; r < map.regions.size(); ++r)
+			{
+				const vector<Region::Run>& runs = map.regions[r]->Runs();
+				for (unsigned i = 0; i < runs.size(); ++i)
+				{
+					start.push_back(PixLoc(runs[i].start, runs[i].y));
+					length.push_back(runs[i].length);
+					color.push_back(r + 1);
+				}
+			}
+			map.footprint = new ColorRuns();
+			map.footprint->assign(xAxes[m], yAxes[m], start, length, color);
+		}
+		else
+		{
+			map.image->zero(map.image->null());
+			for (unsigned r = 0; r < map.regions.size(); ++r)
+				map.regions[r]->recolor(map.image, r + 1);
+		}
+		map.firstNode = tracking_graph.add_nodes(map.regions);
+		window.push_back(map);
+	}
+
+	file.moveTo("TrackingEdges");
+	FitsTable table;
+	vector<unsigned>& from_map = table.column<unsigned>("FROM_MAP");
+	vector<unsigned>& from_region = table.column<unsigned>("FROM_REGION");
+	vector<unsigned>& to_map = table.column<unsigned>("TO_MAP");
+	vector<unsigned>& to_region = table.column<unsigned>("TO_REGION");
+	vector<int>& weight = table.column<int>("WEIGHT");
+	file.readColumns(table);
+	for (unsigned e = 0; e < from_map.size(); ++e)
+	{
+		if(from_map[e] >= window.size() || to_map[e] >= window.size() || from_region[e] >= window[from_map[e]].regions.size() || to_region[e] >= window[to_map[e]].regions.size())
+		{
+			cerr<<"Error : edge "<<e<<" of the tracking state "<<filename<<" is not between regions of the window."<<endl;
+			return false;
+		}
+		tracking_graph.add_edge(tracking_graph.get_node(window[from_map[e]].firstNode + from_region[e]), tracking_graph.get_node(window[to_map[e]].firstNode + to_region[e]), weight[e]);
+	}
+	return file.isGood();
+}
+
+//! The tracking information of a map of a shard, read without the map
+struct ShardMap
+{
+	string filename;
+	time_t observationTime;
+	//! Observation date of the first map of the shard (cf. TSTART)
+	string shard;
+	//! The minLifetime the shard was tracked with (cf. TMINLIFE)
+	unsigned minLifetime;
+};
+
+//! Comparison of the maps of the shards by observation time
+bool earlierShardMap(const ShardMap& a, const ShardMap& b)
+{
+	return a.observationTime < b.observationTime;
+}
+
+//! Routine to read the tracking information of a map from the headers of it's fits file
+bool readShardMap(const string& filename, const string& regionTableName, const unsigned maxDeltaT, const bool derotate, ShardMap& shardMap)
+{
+	FitsFile file(filename);
+	Header header;
+	file.readHeader(header);
+	ColorMap coordinates(header);
+	coordinates.parseHeader();
+	shardMap.filename = filename;
+	shardMap.observationTime = coordinates.ObservationTime();
+	if(!file.has(regionTableName))
+	{
+		cerr<<"Error : map "<<filename<<" has no table "<<regionTableName<<"."<<endl;
+		return false;
+	}
+	file.moveTo(regionTableName);
+	Header tracking_info;
+	file.readHeader(tracking_info);
+	if(!tracking_info.has("TSTART"))
+	{
+		cerr<<"Error : map "<<filename<<" has not been tracked, no TSTART keyword."<<endl;
+		return false;
+	}
+	// If the parameters are not the same, the colors of the shards cannot be reconciled
+	if(!tracking_info.has("TMAXDELT") || tracking_info.get<unsigned>("TMAXDELT") != maxDeltaT || !tracking_info.has("TDEROT") || tracking_info.get<bool>("TDEROT") != derotate)
+	{
+		cerr<<"Error : map "<<filename<<" was tracked with a different maxDeltaT or derotate."<<endl;
+		return false;
+	}
+	// The regions of the short-lived tracks of the shard may belong to tracks that continue across a seam
+	if(tracking_info.has("TERASED") && tracking_info.get<bool>("TERASED"))
+	{
+		cerr<<"Error : the short-lived regions of map "<<filename<<" have been erased, the shards must be tracked without minLifetime and recolorImages to be reconciled."<<endl;
+		return false;
+	}
+	shardMap.shard = tracking_info.get<string>("TSTART");
+	shardMap.minLifetime = tracking_info.has("TMINLIFE") ? tracking_info.get<unsigned>("TMINLIFE") : 0;
+	if(tracking_info.has("TNEWCOLR"))
+	{
+		ColorType latest_color = tracking_info.get<ColorType>("TNEWCOLR");
+		newColor = latest_color > newColor ? latest_color : newColor;
+	}
+	return file.isGood();
+}
+
+//! The new colors and first observation dates of the tracks of the shards, by their color in the shard
+struct ColorRemap
+{
+	//! The new color of the tracks that continue from the previous shard
+	map<ColorType, ColorType> colors;
+	//! The new first observation date of the tracks that continue from the previous shard, or that start from them
+	map<ColorType, string> firstObservationDates;
+};
+
+//! Routine to compute the new first observation date of a track of a shard from it's first region
+/*! A region that does not have a parent of the same color starts a track, the first observation date of the track is the earliest of it's parents.
+The past colors are the colors in the shard of the parents of the region. */
+void propagateFirstObservationDate(const ColorType color, const string& firstObservationDate, const vector<ColorType>& pastColors, ColorRemap& remap)
+{
+	if(remap.colors.count(color) > 0 || find(pastColors.begin(), pastColors.end(), color) != pastColors.end())
+		return;
+	string date = firstObservationDate;
+	for (unsigned p = 0; p < pastColors.size(); ++p)
+	{
+		map<ColorType, string>::const_iterator pastDate = remap.firstObservationDates.find(pastColors[p]);
+		if(pastDate != remap.firstObservationDates.end() && pastDate->second < date)
+			date = pastDate->second;
+	}
+	if(date != firstObservationDate)
+		remap.firstObservationDates[color] = date;
+}
+
+//! Routine to give to the regions the new color and first observation date of their track
+void remapRegions(const vector<Region*>& regions, const ColorRemap& remap)
+{
+	for (unsigned r = 0; r < regions.size(); ++r)
+	{
+		map<ColorType, string>::const_iterator date = remap.firstObservationDates.find(regions[r]->Color());
+		if(date != remap.firstObservationDates.end())
+			regions[r]->setFirstObservationTime(iso2ctime(date->second));
+		map<ColorType, ColorType>::const_iterator color = remap.colors.find(regions[r]->Color());
+		if(color != remap.colors.end())
+			regions[r]->setColor(color->second);
+	}
+}
+
+//! Routine to give to the regions of a map fits file the new color and first observation date of their track
+/*! The maps of a shard must be remapped in the order of time, so that the first observation date of the new tracks can be propagated from the relations.
+The colors are updated in the table of regions and in the tracking relations, and in the map if recolorImages is set */
+void remapTrackedMap(const string& filename, const string& regionTableName, ColorRemap& remap, const bool recolorImages, const int compressed_fits)
+{
+	bool recolored = false;
+	{
+		FitsFile file(filename, FitsFile::update);
+		FitsTable relations;
+		vector<ColorType>& past_colors = relations.column<ColorType>("PAST_COLOR");
+		vector<ColorType>& present_colors = relations.column<ColorType>("PRESENT_COLOR");
+		if(file.has("TrackingRelations"))
+		{
+			file.moveTo("TrackingRelations");
+			file.readColumns(relations);
+		}
+
+		file.moveTo(regionTableName);
+		FitsTable table;
+		vector<ColorType>& tracked_colors = table.column<ColorType>("TRACKED_COLOR");
+		vector<string>& first_observation_dates = table.column<string>("FIRST_DATE_OBS");
+		file.readColumns(table);
+		bool remapped = false;
+		for (unsigned r = 0; r < tracked_colors.size() && r < first_observation_dates.size(); ++r)
+		{
+			vector<ColorType> parentColors;
+			for (unsigned e = 0; e < present_colors.size() && e < past_colors.size(); ++e)
+			{
+				if(present_colors[e] == tracked_colors[r])
+					parentColors.push_back(past_colors[e]);
+			}
+			propagateFirstObservationDate(tracked_colors[r], first_observation_dates[r], parentColors, remap);
+			map<ColorType, string>::const_iterator date = remap.firstObservationDates.find(tracked_colors[r]);
+			if(date != remap.firstObservationDates.end() && date->second != first_observation_dates[r])
+			{
+				first_observation_dates[r] = date->second;
+				remapped = true;
+			}
+			map<ColorType, ColorType>::const_iterator color = remap.colors.find(tracked_colors[r]);
+			if(color != remap.colors.end())
+			{
+				tracked_colors[r] = color->second;
+				recolored = true;
+			}
+		}
+		if(remapped || recolored)
+		{
+			if(recolorImages)
+				table.column<ColorType>("COLOR") = tracked_colors;
+			file.writeColumns(table, FitsFile::overwrite);
+		}
+
+		// The parents of a region can be remapped even if the region is not
+		bool relinked = false;
+		for (unsigned e = 0; e < past_colors.size(); ++e)
+		{
+			map<ColorType, ColorType>::const_iterator color = remap.colors.find(past_colors[e]);
+			if(color != remap.colors.end())
+			{
+				past_colors[e] = color->second;
+				relinked = true;
+			}
+		}
+		for (unsigned e = 0; e < present_colors.size(); ++e)
+		{
+			map<ColorType, ColorType>::const_iterator color = remap.colors.find(present_colors[e]);
+			if(color != remap.colors.end())
+			{
+				present_colors[e] = color->second;
+				relinked = true;
+			}
+		}
+		if(relinked)
+		{
+			file.moveTo("TrackingRelations");
+			file.writeColumns(relations, FitsFile::overwrite);
+		}
+	}
+	if(recolored && recolorImages)
+	{
+		FitsFile file(filename, FitsFile::update);
+		ColorMap image;
+		image.readFits(file);
+		image.recolorizeConnectedComponents(remap.colors);
+		image.writeFits(file, FitsFile::update|compressed_fits);
+	}
+}
+
+//! Routine to track the maps around the seam between 2 shards, and to compute again the colors of the maps near the seam
+/*!
+The maps of the window must be ordered by time:
+ - the maps [0, firstT) are the maps of the first shard whose colors are final, they give their color to the next maps
+ - the maps [firstT, firstH) are the last maps of the first shard, at most maxDeltaT before the second shard
+ - the maps [firstH, firstG) are the first maps of the second shard, at most maxDeltaT after the first shard
+ - the maps [firstG, end) are the next maps of the second shard, their tracks do not change but they can get a new color
+The colors of the maps [firstT, firstG) are computed again, and the tracks of the second shard that continue after firstH are added to remap.
+*/
+void reconcileSeam(vector<TrackedMap>& window, const unsigned firstT, const unsigned firstH, const unsigned firstG, RegionGraph& tracking_graph, const unsigned maxDeltaT, const bool derotate, const unsigned numberThreads, ColorRemap& remap)
+{
+	// We track the window the same way the maps are tracked in a shard
+	vector<const TrackedMap*> sequence;
+	for (unsigned m = 0; m < window.size(); ++m)
+	{
+		window[m].firstNode = tracking_graph.add_nodes(window[m].regions);
+		sequence.push_back(&(window[m]));
+	}
+	vector<TrackedPair> pairs;
+	listPairs(sequence, 0, maxDeltaT, pairs);
+	computeOverlaps(pairs, derotate, numberThreads);
+	for (unsigned p = 0; p < pairs.size(); ++p)
+	{
+		trackRegions(tracking_graph, *(pairs[p].map1), *(pairs[p].map2), pairs[p].intersectPixels);
+		pairs[p].intersectPixels.clear();
+	}
+
+	// We color again the maps near the seam, in the order of time
+	map<const Region*, ColorType> shardColors;
+	for (unsigned m = firstH; m < window.size(); ++m)
+	{
+		for (unsigned r = 0; r < window[m].regions.size(); ++r)
+			shardColors[window[m].regions[r]] = window[m].regions[r]->Color();
+	}
+	for (unsigned m = firstT; m < firstG; ++m)
+	{
+		for (unsigned r = 0; r < window[m].regions.size(); ++r)
+		{
+			Region* region = window[m].regions[r];
+			region->setColor(0);
+			region->setFirstObservationTime(region->ObservationTime());
+		}
+	}
+	for (unsigned m = firstT; m < firstG; ++m)
+	{
+		for (unsigned r = 0; r < window[m].regions.size(); ++r)
+			tracking_graph.get_node(window[m].firstNode + r)->colorize();
+	}
+
+	// A track of the second shard takes the color of it's last region near the seam
+	for (unsigned m = firstH; m < firstG; ++m)
+	{
+		for (unsigned r = 0; r < window[m].regions.size(); ++r)
+		{
+			const ColorType color = shardColors[window[m].regions[r]];
+			remap.colors[color] = window[m].regions[r]->Color();
+			remap.firstObservationDates[color] = window[m].regions[r]->FirstObservationDate();
+		}
+	}
+
+	// The tracks that start after the seam get the first observation date of their parents
+	for (unsigned m = firstG; m < window.size(); ++m)
+	{
+		for (unsigned r = 0; r < window[m].regions.size(); ++r)
+		{
+			const RegionGraph::node* node = tracking_graph.get_node(window[m].firstNode + r);
+			vector<ColorType> parentColors;
+			for (RegionGraph::node::const_iterator it = node->in_begin(); it != node->in_end(); ++it)
+				parentColors.push_back(shardColors[it->from->get_region()]);
+			propagateFirstObservationDate(window[m].regions[r]->Color(), window[m].regions[r]->FirstObservationDate(), parentColors, remap);
+		}
+		remapRegions(window[m].regions, remap);
+	}
+}
+
+//! Routine to compute again the lifetime of the tracks of the reconciled shards, and to write it in the table of regions of the maps
+/*! The tracks that continue across a seam were cut by the shards, so their lifetime is computed from the tables of regions of the maps of all the shards.
+The regions whose track lived less than minLifetime seconds are flagged, and erased from the map if recolorImages is set. */
+void writeShardLifetimes(const vector<ShardMap>& shardMaps, const string& regionTableName, const bool recolorImages, const int compressed_fits, const unsigned minLifetime)
+{
+	std::map<ColorType, TrackLifetime> lifetimes;
+	for (unsigned s = 0; s < shardMaps.size(); ++s)
+	{
+		FitsFile file(shardMaps[s].filename);
+		file.moveTo(regionTableName);
+		FitsTable table;
+		vector<ColorType>& tracked_colors = table.column<ColorType>("TRACKED_COLOR");
+		vector<string>& observation_dates = table.column<string>("DATE_OBS");
+		vector<string>& first_observation_dates = table.column<string>("FIRST_DATE_OBS");
+		file.readColumns(table);
+		for (unsigned r = 0; r < tracked_colors.size() && r < observation_dates.size() && r < first_observation_dates.size(); ++r)
+		{
+			if(tracked_colors[r] == 0)
+				continue;
+			TrackLifetime& lifetime = lifetimes[tracked_colors[r]];
+			const time_t firstObservationTime = iso2ctime(first_observation_dates[r]);
+			const time_t observationTime = iso2ctime(observation_dates[r]);
+			if(lifetime.numberObservations == 0 || firstObservationTime < lifetime.firstObservationTime)
+				lifetime.firstObservationTime = firstObservationTime;
+			if(lifetime.numberObservations == 0 || observationTime > lifetime.lastObservationTime)
+				lifetime.lastObservationTime = observationTime;
+			++lifetime.numberObservations;
+		}
+	}
+
+	for (unsigned s = 0; s < shardMaps.size(); ++s)
+	{
+		set<ColorType> shortLivedColors;
+		{
+			FitsFile file(shardMaps[s].filename, FitsFile::update);
+			file.moveTo(regionTableName);
+			FitsTable colors;
+			vector<ColorType>& tracked_colors = colors.column<ColorType>("TRACKED_COLOR");
+			file.readColumns(colors);
+			if(minLifetime > 0)
+			{
+				for (unsigned r = 0; r < tracked_colors.size(); ++r)
+				{
+					std::map<ColorType, TrackLifetime>::const_iterator track = lifetimes.find(tracked_colors[r]);
+					if(track != lifetimes.end() && track->second.Lifetime() < minLifetime)
+						shortLivedColors.insert(tracked_colors[r]);
+				}
+				Header tracking_info;
+				tracking_info.set("TMINLIFE", minLifetime, "Tracking minLifetime");
+				if(recolorImages)
+					tracking_info.set("TERASED", true, "Tracking short-lived regions erased");
+				file.writeHeader(tracking_info);
+			}
+			FitsTable table(tracked_colors.size());
+			fillLifetimeColumns(table, tracked_colors, lifetimes, shortLivedColors, minLifetime > 0);
+			file.writeColumns(table, FitsFile::overwrite);
+		}
+		if(recolorImages && shortLivedColors.size() > 0)
+		{
+			FitsFile file(shardMaps[s].filename, FitsFile::update);
+			ColorMap image;
+			image.readFits(file);
+			image.eraseColors(shortLivedColors);
+			image.writeFits(file, FitsFile::update|compressed_fits);
+		}
+	}
+}
+
+//! Routine to reconcile the colors of the maps of shards tracked separately, and to write the color lookup table of the tracks that continue across the seams
+int reconcileShards(const deque<string>& filenames, const string& lutFilename, const string& regionTableName, const unsigned maxDeltaT, const bool derotate, const bool recolorImages, const int compressed_fits, const bool footprints, const unsigned numberThreads, unsigned minLifetime)
+{
+	// We get the shard and the time of the maps, without reading the maps
+	vector<ShardMap> shardMaps(filenames.size());
+	for (unsigned s = 0; s < filenames.size(); ++s)
+	{
+		if(!readShardMap(filenames[s], regionTableName, maxDeltaT, derotate, shardMaps[s]))
+			return EXIT_FAILURE;
+	}
+	// If no minLifetime is given, the regions are flagged again with the minLifetime of the shards
+	if(minLifetime == 0 && shardMaps.size() > 0)
+	{
+		minLifetime = shardMaps[0].minLifetime;
+		for (unsigned s = 1; s < shardMaps.size(); ++s)
+		{
+			if(shardMaps[s].minLifetime != minLifetime)
+			{
+				cerr<<"Error : map "<<shardMaps[s].filename<<" was tracked with a different minLifetime."<<endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	stable_sort(shardMaps.begin(), shardMaps.end(), earlierShardMap);
+
+	// The shards must follow each other in time
+	vector<unsigned> shardStarts;
+	set<string> shards;
+	for (unsigned s = 0; s < shardMaps.size(); ++s)
+	{
+		if(s > 0 && shardMaps[s].shard == shardMaps[s - 1].shard)
+			continue;
+		if(shards.count(shardMaps[s].shard) > 0)
+		{
+			cerr<<"Error : the shard starting at "<<shardMaps[s].shard<<" overlaps another shard in time."<<endl;
+			return EXIT_FAILURE;
+		}
+		shards.insert(shardMaps[s].shard);
+		shardStarts.push_back(s);
+	}
+	shardStarts.push_back(shardMaps.size());
+
+	ColorRemap remap;
+	vector<bool> written(shardMaps.size(), false);
+	vector<bool> recolored(shardMaps.size(), false);
+	// The maps of the shards are remapped in the order of time, up to the maps that are tracked again
+	unsigned remapped = shardStarts.size() > 1 ? shardStarts[1] : 0;
+	for (unsigned k = 1; k + 1 < shardStarts.size(); ++k)
+	{
+		const unsigned seam = shardStarts[k];
+		const time_t start = shardMaps[seam].observationTime;
+		const time_t end = shardMaps[seam - 1].observationTime;
+
+		// The window goes from 2 maxDeltaT before the second shard to 2 maxDeltaT after the first shard
+		unsigned first = seam, last = seam;
+		while(first > 0 && difftime(start, shardMaps[first - 1].observationTime) <= 2 * maxDeltaT)
+			--first;
+		while(last < shardMaps.size() && difftime(shardMaps[last].observationTime, end) <= 2 * maxDeltaT)
+			++last;
+		unsigned firstT = first, firstG = seam;
+		while(difftime(start, shardMaps[firstT].observationTime) > maxDeltaT)
+			++firstT;
+		while(firstG < last && difftime(shardMaps[firstG].observationTime, end) <= maxDeltaT)
+			++firstG;
+		// The maps near a seam depend on the previous shard, so they cannot be near another seam
+		bool isolated = first >= shardStarts[k - 1] && last <= shardStarts[k + 1];
+		for (unsigned s = firstT; s < seam; ++s)
+			isolated = isolated && !recolored[s];
+		if(!isolated)
+		{
+			cerr<<"Error : the shards around "<<shardMaps[seam].shard<<" are too short to be reconciled, a shard must span more than 4 maxDeltaT."<<endl;
+			return EXIT_FAILURE;
+		}
+
+		for (; remapped < firstT; ++remapped)
+		{
+			if(!written[remapped])
+				remapTrackedMap(shardMaps[remapped].filename, regionTableName, remap, recolorImages, compressed_fits);
+		}
+
+		vector<TrackedMap> window(last - first);
+		for (unsigned m = 0; m < window.size(); ++m)
+		{
+			readTrackedMap(shardMaps[first + m].filename, regionTableName, false, footprints, window[m]);
+			window[m].trackingStart = shardMaps[first + m].shard;
+			// The maps may already have been reconciled with the previous shard
+			remapRegions(window[m].regions, remap);
+		}
+		RegionGraph tracking_graph;
+		reconcileSeam(window, firstT - first, seam - first, firstG - first, tracking_graph, maxDeltaT, derotate, numberThreads, remap);
+		for (unsigned m = firstT - first; m < window.size(); ++m)
+		{
+			writeTrackedMap(window[m], tracking_graph, regionTableName, recolorImages, compressed_fits, maxDeltaT, derotate, window.size());
+			written[first + m] = true;
+			recolored[first + m] = first + m < firstG;
+		}
+		for (unsigned m = 0; m < window.size(); ++m)
+		{
+			delete window[m].image;
+			delete window[m].footprint;
+		}
+	}
+
+	// The other maps of the shards only change by the color and the first observation date of their tracks
+	for (; remapped < shardMaps.size(); ++remapped)
+	{
+		if(!written[remapped])
+			remapTrackedMap(shardMaps[remapped].filename, regionTableName, remap, recolorImages, compressed_fits);
+	}
+
+	// Once all the maps have their final colors, the tracks are complete
+	writeShardLifetimes(shardMaps, regionTableName, recolorImages, compressed_fits, minLifetime);
+
+	// We write the color lookup table, it can be used by recolor_map.x
+	ofstream lut(lutFilename.c_str(), ios_base::trunc);
+	if(!lut.good())
+	{
+		cerr<<"Error : could not open output file "<<lutFilename<<endl;
+		return EXIT_FAILURE;
+	}
+	for (map<ColorType, ColorType>::const_iterator it = remap.colors.begin(); it != remap.colors.end(); ++it)
+		lut<<it->first<<" "<<it->second<<endl;
+	lut.close();
+
+	cout<<"Last color assigned: "<<newColor<<endl;
+	return EXIT_SUCCESS;
+}
+
 int main(int argc, const char **argv)
 {
 	cout<<setiosflags(ios::fixed);
@@ -96,6 +1095,12 @@ int main(int argc, const char **argv)
 	args["derotate"] = ArgParser::Parameter(true, 'D', "Set this to false if you dont want images to be derotated before comparison.");
 	args["regionTableName"] = ArgParser::Parameter("Regions", 'H',"The name of the region table Hdu");
 	args["uncompressed"] = ArgParser::Parameter(false, 'u', "Set this flag if you want results maps to be uncompressed.");
+	args["state"] = ArgParser::Parameter("", 'S', "The path of a state file to track the maps incrementally.");
+	args["finalize"] = ArgParser::Parameter(false, 'F', "Set this flag to write the results of all the maps of the tracking window, even the ones whose colors could still change with the next maps.");
+	args["threads"] = ArgParser::Parameter(4, 't', "The number of pairs of maps to compare in parallel.");
+	args["footprints"] = ArgParser::Parameter(false, 'f', "Set this flag to keep only the runs of pixels of the maps in memory instead of the full maps.");
+	args["minLifetime"] = ArgParser::Parameter(0, 'L', "The minimal number of seconds a track must live. The regions of the shorter tracks are flagged in the table of regions, and erased from the maps if recolorImages is set.");
+	args["reconcile"] = ArgParser::Parameter("", 'R', "The path of a color lookup table file. Set this to reconcile the colors of maps tracked in separate shards, instead of tracking them.");
 	
 	args["fitsFile"] = ArgParser::RemainingPositionalParameters("Path of a fits files containing a maps of regions to track.");
 	
@@ -112,137 +1117,189 @@ int main(int argc, const char **argv)
 	}
 	
 	newColor = args["newColor"];
-	
-	// We get the maps, regions and colors from the fits files
-	vector<vector<Region*> > regions;
-	vector<ColorMap*> images;
-	deque<string> imagesFilenames = args.RemainingPositionalArguments();
-	for (unsigned s = 0; s < imagesFilenames.size(); ++s)
+	const unsigned maxDeltaT = args["maxDeltaT"];
+	const bool derotate = args["derotate"];
+	const bool recolorImages = args["recolorImages"];
+	const string regionTableName = args["regionTableName"];
+	// We set whether we should not compress the maps
+	const int compressed_fits = args["uncompressed"] ? 0 : FitsFile::compress;
+	const string stateFilename = args["state"];
+	const bool incremental = !stateFilename.empty();
+	const unsigned numberThreads = args["threads"];
+	const bool footprints = args["footprints"];
+	const string reconcileFilename = args["reconcile"];
+	const unsigned minLifetime = args["minLifetime"];
+
+	if(!reconcileFilename.empty())
 	{
-		FitsFile file(imagesFilenames[s]);
-		// We get the image
-		ColorMap* image = new ColorMap();
-		image->readFits(file);
-		
-		// We crop the image
-		image->nullifyAboveRadius(1);
-		images.push_back(image);
-		
-		// We get te regions
-		vector<Region* > tmp_regions;
-		
-		// If there is a table of regions, we use it to extract the regions
-		if(file.has(args["regionTableName"]))
-		{
-			file.moveTo(args["regionTableName"].as<string>());
-			readRegions(file, tmp_regions, true);
-			Header tracking_info;
-			file.readHeader(tracking_info);
-			if(tracking_info.has("TNEWCOLR"))
-			{
-				ColorType latest_color = tracking_info.get<ColorType>("TNEWCOLR");
-				newColor = latest_color > newColor ? latest_color : newColor;
-			}
-		}
-		else // We extract the regions from the map
+		if(incremental)
 		{
-			tmp_regions = getRegions(image);
-			if(! (image->getHeader().has("TRACKED") && image->getHeader().get<bool>("TRACKED")))
-			{
-				for (unsigned r = 0; r < tmp_regions.size(); ++r)
-					tmp_regions[r]->setColor(0);
-			}
-			if(image->getHeader().has("TNEWCOLR"))
-			{
-				ColorType latest_color = image->getHeader().get<ColorType>("TNEWCOLR");
-				newColor = latest_color > newColor ? latest_color : newColor;
-			}
+			cerr<<"Error : cannot reconcile shards with a state file."<<endl;
+			return EXIT_FAILURE;
 		}
-		regions.push_back(tmp_regions);
+		return reconcileShards(args.RemainingPositionalArguments(), reconcileFilename, regionTableName, maxDeltaT, derotate, recolorImages, compressed_fits, footprints, numberThreads, minLifetime);
+	}
+	if(numberThreads < 1)
+	{
+		cerr<<"Error : threads must be at least 1."<<endl;
+		return EXIT_FAILURE;
+	}
+	if(incremental && minLifetime > 0)
+	{
+		cerr<<"Error : the lifetime of the tracks is not known when tracking incrementally, minLifetime cannot be used with a state file."<<endl;
+		return EXIT_FAILURE;
 	}
-	
-	filenamePrefix = images.size() > 0 ? toString(images[0]->ObservationTime()) + "." : "nofiles.";
-	#if defined DEBUG
-	// We output the regions found
-	ouputRegions(regions, filenamePrefix+"regions_premodification.txt");
-	#endif
 
 	RegionGraph tracking_graph;
-	// We create the nodes of the graph
-	for (unsigned s = 0; s < regions.size(); ++s)
+	// The maps being tracked, ordonated according to time
+	vector<TrackedMap> window;
+	if(incremental && isFile(stateFilename))
 	{
-		for (unsigned r = 0; r < regions[s].size(); ++r)
-		{
-			tracking_graph.add_node(regions[s][r]);
-		}
+		if(!readTrackingState(stateFilename, window, tracking_graph, maxDeltaT, derotate, footprints))
+			return EXIT_FAILURE;
 	}
 
+	// We get the maps, regions and colors from the fits files
+	deque<string> imagesFilenames = args.RemainingPositionalArguments();
+	vector<TrackedMap> maps(imagesFilenames.size());
+	vector<ColorMap*> images(imagesFilenames.size());
+	for (unsigned s = 0; s < imagesFilenames.size(); ++s)
+	{
+		// In incremental mode we need the runs of the regions for the state
+		readTrackedMap(imagesFilenames[s], regionTableName, incremental, footprints, maps[s]);
+		images[s] = maps[s].image;
+	}
 
 	//We ordonate the images according to time
 	vector<unsigned> indices = imageOrder(images);
-	// We create the edges of the graph
-	// According to Cis we create an edge between 2 nodes
-	// if their time difference is smaller than some value and
-	// if they overlap and
-	// if there is not already a path between them
-	unsigned maxDeltaT = args["maxDeltaT"];
-	for (unsigned d = 1; d < indices.size(); ++d)
-	{
-		for (unsigned i = 0; d + i < indices.size(); ++i)
-		{
-			unsigned s1 = indices[i];
-			unsigned s2 = indices[i + d];
-			//If the time difference between the 2 images is too big, we don't need to continue
-			unsigned delta_t = unsigned(difftime(images[s2]->ObservationTime(),images[s1]->ObservationTime()));
+
+	filenamePrefix = window.size() > 0 ? toString(window[0].image->ObservationTime()) + "." : images.size() > 0 ? toString(images[indices[0]]->ObservationTime()) + "." : "nofiles.";
+
+	// We select the maps to track in the order of time
+	vector<TrackedMap*> newMaps;
+	for (unsigned i = 0; i < indices.size(); ++i)
+	{
+		TrackedMap& map = maps[indices[i]];
+		const TrackedMap* last = newMaps.size() > 0 ? newMaps.back() : window.size() > 0 ? &(window.back()) : NULL;
+		if(incremental && last && map.image->ObservationTime() <= last->image->ObservationTime())
+		{
+			cerr<<"Error : map "<<map.filename<<" is not more recent than the maps already tracked, it will be skipped."<<endl;
+			delete map.image;
+			delete map.footprint;
+			continue;
+		}
+		newMaps.push_back(&map);
+	}
+
+	// The maps tracked together are identified by the date of the first map, so that shards tracked separately can be reconciled
+	string trackingStart = window.size() > 0 ? window[0].trackingStart : "";
+	if(trackingStart.empty())
+		trackingStart = window.size() > 0 ? window[0].image->ObservationDate() : newMaps.size() > 0 ? newMaps[0]->image->ObservationDate() : "";
+	for (unsigned m = 0; m < window.size(); ++m)
+		window[m].trackingStart = trackingStart;
+	for (unsigned m = 0; m < newMaps.size(); ++m)
+		newMaps[m]->trackingStart = trackingStart;
+
+	// Each new map is compared with the previous maps, the closest first
+	// This creates the same edges as comparing all pairs of maps from the closest to the furthest
+	// The overlap of the pairs are independent, so we compute them in parallel, and add the edges in the order of the pairs
+	vector<const TrackedMap*> sequence;
+	for (unsigned m = 0; m < window.size(); ++m)
+		sequence.push_back(&(window[m]));
+	sequence.insert(sequence.end(), newMaps.begin(), newMaps.end());
+	vector<TrackedPair> pairs;
+	listPairs(sequence, window.size(), maxDeltaT, pairs);
+	computeOverlaps(pairs, derotate, numberThreads);
+
+	// We track the maps one after the other
+	unsigned p = 0;
+	for (unsigned i = 0; i < newMaps.size(); ++i)
+	{
+		TrackedMap& map = *(newMaps[i]);
+		map.firstNode = tracking_graph.add_nodes(map.regions);
+		window.push_back(map);
+		for (unsigned d = 1; d < window.size(); ++d)
+		{
+			const TrackedMap& previous = window[window.size() - 1 - d];
+			unsigned delta_t = unsigned(difftime(map.image->ObservationTime(), previous.image->ObservationTime()));
 			if (delta_t > maxDeltaT)
 			{
-				continue;
+				break;
 			}
-			
-			#if defined DEBUG
-			if(args["derotate"])
+			trackRegions(tracking_graph, previous, window.back(), pairs[p].intersectPixels);
+			// We don't need the overlap anymore
+			pairs[p++].intersectPixels.clear();
+		}
+
+		// The next maps will not be compared with the maps more than maxDeltaT older than this one
+		for (unsigned m = 0; m < window.size(); ++m)
+		{
+			if(unsigned(difftime(map.image->ObservationTime(), window[m].image->ObservationTime())) <= maxDeltaT)
 			{
-				SunImage<ColorType>* rotated = images[s1]->shifted_like(images[s2]);
-				rotated->writeFits("rotated_"+ stripSuffix(stripPath(imagesFilenames[s1])) + "_to_" + stripSuffix(stripPath(imagesFilenames[s2]))+".fits");
-				delete rotated;
+				tracking_graph.slide_closure(window[m].firstNode);
+				break;
 			}
-			#endif
-			for (unsigned r1 = 0; r1 < regions[s1].size(); ++r1)
-			{
-				for (unsigned r2 = 0; r2 < regions[s2].size(); ++r2)
-				{
-					if(!tracking_graph.get_node(regions[s1][r1])->path(tracking_graph.get_node(regions[s2][r2])))
-					{
-						unsigned intersectPixels = 0;
-						if(args["derotate"])
-						{
-							intersectPixels = overlay_derotate(images[s1], regions[s1][r1], images[s2], regions[s2][r2]);
-						}
-						else
-						{
-							intersectPixels = overlay(images[s1], regions[s1][r1], images[s2], regions[s2][r2]);
-						}
-						if(intersectPixels > 0)
-						{
-							tracking_graph.add_edge(tracking_graph.get_node(regions[s1][r1]), tracking_graph.get_node(regions[s2][r2]), intersectPixels);
-						}
-					}
-				}
+		}
+
+		if(!incremental)
+			continue;
+
+		// The colors of the regions of a map depend on the edges of their parents, up to maxDeltaT later
+		// So we can write the maps that are at least maxDeltaT older than the latest map
+		const time_t latest = window.back().image->ObservationTime();
+		vector<TrackedMap*> finished;
+		for (unsigned m = 0; m < window.size(); ++m)
+		{
+			if(!window[m].finalized && unsigned(difftime(latest, window[m].image->ObservationTime())) >= maxDeltaT)
+				finished.push_back(&(window[m]));
+		}
+		for (unsigned m = 0; m < finished.size(); ++m)
+		{
+			for (unsigned r = 0; r < finished[m]->regions.size(); ++r)
+				tracking_graph.get_node(finished[m]->firstNode + r)->colorize();
+		}
+		for (unsigned m = 0; m < finished.size(); ++m)
+		{
+			writeTrackedMap(*(finished[m]), tracking_graph, regionTableName, recolorImages, compressed_fits, maxDeltaT, derotate, window.size());
+		}
 
+		// The maps more than 2 maxDeltaT older cannot be the parent of a region whose color is not known
+		// We keep their regions in the graph, but we don't need their image anymore
+		unsigned kept = 0;
+		for (unsigned m = 0; m < window.size(); ++m)
+		{
+			if(window[m].finalized && unsigned(difftime(latest, window[m].image->ObservationTime())) >= 2 * maxDeltaT)
+			{
+				delete window[m].image;
+				delete window[m].footprint;
 			}
+			else
+				window[kept++] = window[m];
 		}
+		window.resize(kept);
 	}
 
 	#if defined DEBUG
+	vector<vector<Region*> > regions;
+	for (unsigned m = 0; m < window.size(); ++m)
+		regions.push_back(window[m].regions);
+	// We output the regions found
+	ouputRegions(regions, filenamePrefix+"regions_premodification.txt");
 	// We output the graph before tranformation
 	ouputGraph(tracking_graph, regions, "ar_graph_premodification", false);
 	#endif
 
-	//We color the graph
-	const RegionGraph::iterator itnEnd = tracking_graph.end();
-	for (RegionGraph::iterator itn = tracking_graph.begin(); itn != itnEnd; ++itn)
+	// We color the regions of the maps that have not been written yet, in the order of time
+	vector<TrackedMap*> finished;
+	for (unsigned m = 0; m < window.size(); ++m)
+	{
+		if(!window[m].finalized && (!incremental || args["finalize"]))
+			finished.push_back(&(window[m]));
+	}
+	for (unsigned m = 0; m < finished.size(); ++m)
 	{
-		itn->colorize();
+		for (unsigned r = 0; r < finished[m]->regions.size(); ++r)
+			tracking_graph.get_node(finished[m]->firstNode + r)->colorize();
 	}
 
 	#if defined DEBUG
@@ -252,57 +1309,25 @@ int main(int argc, const char **argv)
 	ouputRegions(regions, filenamePrefix+"regions_postmodification.txt");
 	#endif
 
-	// We set whether we should not compress the maps
-	const int compressed_fits = args["uncompressed"] ? 0 : FitsFile::compress;
+	// When all the maps are tracked at once, the tracks are complete so we know their lifetime
+	map<ColorType, TrackLifetime> lifetimes;
+	if(!incremental)
+		lifetimes = trackLifetimes(tracking_graph);
 
 	// We update the fits files with the new colors
-	for (unsigned s = 0; s < images.size(); ++s)
+	for (unsigned m = 0; m < finished.size(); ++m)
 	{
-		FitsFile file(imagesFilenames[s], FitsFile::update);
-		
-		if(args["recolorImages"])
-		{
-			// We color the image and overwrite them in the fitsfile
-			recolorFromRegions(images[s], regions[s]);
-			images[s]->getHeader().set("TRACKED", true, "Map has been tracked");
-			images[s]->writeFits(file, FitsFile::update|compressed_fits);
-		}
-		
-		file.moveTo(args["regionTableName"].as<string>());
-		
-		// We write a nice header with info on the tracking
-		Header tracking_info;
-		tracking_info.set("TNEWCOLR", newColor, "Tracking latest color");
-		tracking_info.set("TMAXDELT", maxDeltaT, "Tracking maxDeltaT");
-		tracking_info.set("TDEROT", args["derotate"], "Tracking derotate");
-		tracking_info.set("TNBRIMG", unsigned(imagesFilenames.size()), "Tracking number images");
-		tracking_info.set("TRACKED", true, "Regions have been tracked");
-		file.writeHeader(tracking_info);
-		
-		// We update the table of regions with the new colors and first_date_obs
-		// We assume that the regions are in the same order than in the fits file(i.e. same id)
-		vector<ColorType> tracked_colors(regions[s].size(),0);
-		for (unsigned r = 0; r < regions[s].size(); ++r)
-		{
-			tracked_colors[r] = regions[s][r]->Color();
-		}
-		file.writeColumn("TRACKED_COLOR", tracked_colors, FitsFile::overwrite);
-		
-		vector<string> first_observation_dates(regions[s].size());
-		for (unsigned r = 0; r < regions[s].size(); ++r)
-		{
-			first_observation_dates[r] = regions[s][r]->FirstObservationDate();
-		}
-		file.writeColumn("FIRST_DATE_OBS", first_observation_dates, FitsFile::overwrite);
-		
-		//If we recolor the images we update the color column
-		if(args["recolorImages"])
-			file.writeColumn("COLOR", tracked_colors, FitsFile::overwrite);
-		
-		// We write the relations in a table of the FITS file
-		writeTrackingRelations(file, regions[s], tracking_graph, images[s]->PixelLength() * images[s]->PixelWidth());
-		
-		delete images[s];
+		writeTrackedMap(*(finished[m]), tracking_graph, regionTableName, recolorImages, compressed_fits, maxDeltaT, derotate, window.size(), incremental ? NULL : &lifetimes, minLifetime);
+	}
+
+	// We save the tracking window for the next maps
+	if(incremental)
+		writeTrackingState(stateFilename, window, tracking_graph, maxDeltaT, derotate);
+
+	for (unsigned m = 0; m < window.size(); ++m)
+	{
+		delete window[m].image;
+		delete window[m].footprint;
 	}
 
 	cout<<"Last color assigned: "<<newColor<<endl;